@@ -0,0 +1,223 @@
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+	#include <sys/mman.h>
+#endif
+
+#include "arena.h"
+
+#define ARENA_HUGE_PAGE_SIZE (2 * 1024 * 1024)
+
+typedef struct arena_chunk_s {
+	char *data;
+	size_t size;
+	size_t offset;
+
+	/* 1 if data came from mmap rather than posix_memalign */
+	int mapped;
+
+	struct arena_chunk_s *next;
+} arena_chunk_t;
+
+struct arena_s {
+	ARENA_PAGES pages;
+	size_t chunk_bytes;
+
+	/* The chunk blocks are taken from; the others are only kept to be freed. */
+	arena_chunk_t *chunks;
+
+	size_t peak_bytes;
+	size_t reserved_bytes;
+};
+
+static ARENA_PAGES arena_default_pages = ARENA_PAGES_DEFAULT;
+
+static size_t AR_round_up(size_t bytes, size_t multiple) {
+	return (bytes + multiple - 1) / multiple * multiple;
+}
+
+void AR_set_default_pages(ARENA_PAGES pages) {
+	AR_pages_id_to_name(pages);
+	arena_default_pages = pages;
+}
+
+ARENA_PAGES AR_get_default_pages() {
+	return arena_default_pages;
+}
+
+const char* AR_pages_id_to_name(ARENA_PAGES pages) {
+	switch (pages) {
+	case ARENA_PAGES_DEFAULT:
+		return "none";
+	case ARENA_PAGES_TRANSPARENT:
+		return "transparent";
+	case ARENA_PAGES_EXPLICIT:
+		return "explicit";
+	default:
+		fprintf(stderr, "Error. AR_pages_id_to_name: Invalid ARENA_PAGES (%d). Exiting.\n", pages);
+		exit(-1);
+	}
+}
+
+ARENA_PAGES AR_pages_name_to_id(const char *name) {
+	assert(name != NULL);
+
+	if (strcmp(name, "none") == 0) {
+		return ARENA_PAGES_DEFAULT;
+	} else if (strcmp(name, "transparent") == 0) {
+		return ARENA_PAGES_TRANSPARENT;
+	} else if (strcmp(name, "explicit") == 0) {
+		return ARENA_PAGES_EXPLICIT;
+	}
+
+	fprintf(stderr, "Error. AR_pages_name_to_id: Unknown huge pages setting (%s). Use none, transparent or explicit. Exiting.\n", name);
+	exit(-1);
+}
+
+static arena_chunk_t* AR_chunk_alloc(ARENA_PAGES pages, size_t bytes) {
+	void *p = NULL;
+	size_t alignment = ARENA_ALIGNMENT;
+
+	arena_chunk_t *chunk = (arena_chunk_t*) malloc( sizeof(arena_chunk_t) );
+	if (chunk == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the arena_chunk_t. Exiting.\n");
+		exit(-1);
+	}
+	chunk->mapped = 0;
+	chunk->offset = 0;
+	chunk->next = NULL;
+
+	if (pages != ARENA_PAGES_DEFAULT) {
+		bytes = AR_round_up(bytes, ARENA_HUGE_PAGE_SIZE);
+		alignment = ARENA_HUGE_PAGE_SIZE;
+	}
+
+#if defined(__linux__) && defined(MAP_HUGETLB)
+	if (pages == ARENA_PAGES_EXPLICIT) {
+		p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (p == MAP_FAILED) {
+			p = NULL;
+		} else {
+			chunk->mapped = 1;
+		}
+	}
+#endif
+
+	/* Also the fallback when the huge page pool is empty */
+	if (p == NULL) {
+		if (posix_memalign(&p, alignment, bytes) != 0) {
+			fprintf(stderr, "Error. Arena: Unable to allocate %lu aligned bytes. Exiting.\n", bytes);
+			exit(-1);
+		}
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+		if (pages != ARENA_PAGES_DEFAULT) {
+			madvise(p, bytes, MADV_HUGEPAGE);
+		}
+#endif
+	}
+
+	chunk->data = (char*) p;
+	chunk->size = bytes;
+	return chunk;
+}
+
+static void AR_chunk_free(arena_chunk_t *chunk) {
+#ifdef __linux__
+	if (chunk->mapped) {
+		munmap(chunk->data, chunk->size);
+		free(chunk);
+		return;
+	}
+#endif
+	free(chunk->data);
+	free(chunk);
+}
+
+arena_t* AR_alloc(size_t chunk_bytes, ARENA_PAGES pages) {
+	AR_pages_id_to_name(pages);
+
+	arena_t *arena = (arena_t*) malloc( sizeof(arena_t) );
+	if (arena == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the arena_t. Exiting.\n");
+		exit(-1);
+	}
+
+	arena->pages = pages;
+	arena->chunk_bytes = AR_round_up( chunk_bytes > 0 ? chunk_bytes : ARENA_ALIGNMENT, ARENA_ALIGNMENT );
+	arena->chunks = NULL;
+	arena->peak_bytes = 0;
+	arena->reserved_bytes = 0;
+
+	return arena;
+}
+
+void AR_free(arena_t *arena) {
+	assert(arena != NULL);
+
+	arena_chunk_t *chunk = arena->chunks;
+	while (chunk != NULL) {
+		arena_chunk_t *next = chunk->next;
+		AR_chunk_free(chunk);
+		chunk = next;
+	}
+	arena->chunks = NULL;
+
+	free(arena);
+}
+
+void* AR_malloc(arena_t *arena, size_t bytes) {
+	assert(arena != NULL);
+
+	void *p;
+	arena_chunk_t *chunk = arena->chunks;
+
+	bytes = AR_round_up( bytes > 0 ? bytes : 1, ARENA_ALIGNMENT );
+
+	if (chunk == NULL || chunk->size - chunk->offset < bytes) {
+		/* The rest of the current chunk is wasted, so an oversized block goes behind it instead. */
+		if (bytes > arena->chunk_bytes && chunk != NULL) {
+			arena_chunk_t *large = AR_chunk_alloc(arena->pages, bytes);
+			large->offset = bytes;
+			large->next = chunk->next;
+			chunk->next = large;
+
+			arena->reserved_bytes += large->size;
+			arena->peak_bytes += bytes;
+			return large->data;
+		}
+
+		chunk = AR_chunk_alloc(arena->pages, bytes > arena->chunk_bytes ? bytes : arena->chunk_bytes);
+		chunk->next = arena->chunks;
+		arena->chunks = chunk;
+		arena->reserved_bytes += chunk->size;
+	}
+
+	p = chunk->data + chunk->offset;
+	chunk->offset += bytes;
+	arena->peak_bytes += bytes;
+
+	return p;
+}
+
+void* AR_calloc(arena_t *arena, size_t count, size_t size) {
+	void *p = AR_malloc(arena, count * size);
+	memset(p, 0, count * size);
+	return p;
+}
+
+size_t AR_peak_bytes(const arena_t *arena) {
+	assert(arena != NULL);
+	return arena->peak_bytes;
+}
+
+size_t AR_reserved_bytes(const arena_t *arena) {
+	assert(arena != NULL);
+	return arena->reserved_bytes;
+}
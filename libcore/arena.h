@@ -0,0 +1,57 @@
+#ifndef SRC_C_ARENA_H_
+#define SRC_C_ARENA_H_
+
+#include <stddef.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* Every block handed out by an arena starts on this boundary, a cache line and a full AVX-512 register. */
+#define ARENA_ALIGNMENT 64
+
+typedef enum {
+	ARENA_PAGES_DEFAULT = 0,	/* Ordinary pages. */
+	ARENA_PAGES_TRANSPARENT,	/* 2 MB aligned chunks with transparent huge pages requested (madvise). */
+	ARENA_PAGES_EXPLICIT		/* Chunks from the reserved huge page pool (MAP_HUGETLB), or transparent if it is empty. */
+} ARENA_PAGES;
+
+/* Region allocator. Blocks are carved out of large chunks and are only given back, all at once, by AR_free.
+ * An arena is not thread-safe; each owner (a workspace, a network strain) has its own, which also keeps the
+ * memory of one thread together and first touched by that thread.
+ */
+typedef struct arena_s arena_t;
+
+/* Selects the pages used by arenas created from now on. */
+void AR_set_default_pages(ARENA_PAGES pages);
+
+ARENA_PAGES AR_get_default_pages();
+
+const char* AR_pages_id_to_name(ARENA_PAGES pages);
+
+ARENA_PAGES AR_pages_name_to_id(const char *name);
+
+/* chunk_bytes is the size of each chunk taken from the system. Larger blocks get a chunk of their own. */
+arena_t* AR_alloc(size_t chunk_bytes, ARENA_PAGES pages);
+
+/* Releases every block of the arena. */
+void AR_free(arena_t *arena);
+
+/* An ARENA_ALIGNMENT aligned block of at least bytes bytes. Exits if the memory is not available. */
+void* AR_malloc(arena_t *arena, size_t bytes);
+
+/* AR_malloc of count * size bytes, zeroed. */
+void* AR_calloc(arena_t *arena, size_t count, size_t size);
+
+/* Bytes handed out, including the alignment padding. Nothing is given back before AR_free, so this is also
+ * the peak usage. */
+size_t AR_peak_bytes(const arena_t *arena);
+
+/* Bytes taken from the system for the chunks. */
+size_t AR_reserved_bytes(const arena_t *arena);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* SRC_C_ARENA_H_ */
@@ -0,0 +1,288 @@
+#ifndef SRC_C_COMPLEX_VECTOR_H_
+#define SRC_C_COMPLEX_VECTOR_H_
+
+/* Inline kernels on complex arrays stored as separate real and imaginary arrays (SoA).
+ *
+ * The hot loops should keep their complex data split like this, and only convert to or from the interleaved
+ * (real, imag) layout of gsl_complex arrays and FFT buffers at their boundaries, using CV_interleave and
+ * CV_deinterleave. A gsl_complex array of length n can be passed as (double*) array, 2n doubles.
+ *
+ * With AVX2 and FMA enabled at compile time (-mavx2 -mfma or -march=native) the main kernels use 256-bit
+ * intrinsics. Otherwise they are plain loops over restrict-qualified pointers, which the compiler vectorizes
+ * for whatever the target has (SSE2, AVX-512, NEON) at -O3.
+ *
+ * Unless stated otherwise the outputs may not alias the inputs.
+ */
+
+#include <math.h>
+#include <stddef.h>
+
+#if defined(__AVX2__) && defined(__FMA__)
+	#include <immintrin.h>
+	#define CV_HAVE_AVX2 1
+#endif
+
+#if defined (__cplusplus)
+extern "C" {
+#define CV_RESTRICT __restrict__
+#else
+#define CV_RESTRICT restrict
+#endif
+
+/* out = conj(a) * b */
+static inline void CV_conj_mul(size_t n,
+		const double *CV_RESTRICT a_re, const double *CV_RESTRICT a_im,
+		const double *CV_RESTRICT b_re, const double *CV_RESTRICT b_im,
+		double *CV_RESTRICT out_re, double *CV_RESTRICT out_im) {
+	size_t k = 0;
+#ifdef CV_HAVE_AVX2
+	for (; k + 4 <= n; k += 4) {
+		__m256d ar = _mm256_loadu_pd(a_re + k), ai = _mm256_loadu_pd(a_im + k);
+		__m256d br = _mm256_loadu_pd(b_re + k), bi = _mm256_loadu_pd(b_im + k);
+		_mm256_storeu_pd(out_re + k, _mm256_fmadd_pd(ar, br, _mm256_mul_pd(ai, bi)));
+		_mm256_storeu_pd(out_im + k, _mm256_fmsub_pd(ar, bi, _mm256_mul_pd(ai, br)));
+	}
+#endif
+	for (; k < n; k++) {
+		double re = a_re[k] * b_re[k] + a_im[k] * b_im[k];
+		double im = a_re[k] * b_im[k] - a_im[k] * b_re[k];
+		out_re[k] = re;
+		out_im[k] = im;
+	}
+}
+
+/* out = a * b */
+static inline void CV_mul(size_t n,
+		const double *CV_RESTRICT a_re, const double *CV_RESTRICT a_im,
+		const double *CV_RESTRICT b_re, const double *CV_RESTRICT b_im,
+		double *CV_RESTRICT out_re, double *CV_RESTRICT out_im) {
+	size_t k = 0;
+#ifdef CV_HAVE_AVX2
+	for (; k + 4 <= n; k += 4) {
+		__m256d ar = _mm256_loadu_pd(a_re + k), ai = _mm256_loadu_pd(a_im + k);
+		__m256d br = _mm256_loadu_pd(b_re + k), bi = _mm256_loadu_pd(b_im + k);
+		_mm256_storeu_pd(out_re + k, _mm256_fmsub_pd(ar, br, _mm256_mul_pd(ai, bi)));
+		_mm256_storeu_pd(out_im + k, _mm256_fmadd_pd(ar, bi, _mm256_mul_pd(ai, br)));
+	}
+#endif
+	for (; k < n; k++) {
+		double re = a_re[k] * b_re[k] - a_im[k] * b_im[k];
+		double im = a_re[k] * b_im[k] + a_im[k] * b_re[k];
+		out_re[k] = re;
+		out_im[k] = im;
+	}
+}
+
+/* x *= s, for a complex scalar s. In-place. */
+static inline void CV_scale(size_t n, double s_re, double s_im,
+		double *CV_RESTRICT x_re, double *CV_RESTRICT x_im) {
+	size_t k;
+	for (k = 0; k < n; k++) {
+		double re = x_re[k] * s_re - x_im[k] * s_im;
+		double im = x_re[k] * s_im + x_im[k] * s_re;
+		x_re[k] = re;
+		x_im[k] = im;
+	}
+}
+
+/* x[k] *= s[k], for a real array s. In-place. */
+static inline void CV_scale_real(size_t n, const double *CV_RESTRICT s,
+		double *CV_RESTRICT x_re, double *CV_RESTRICT x_im) {
+	size_t k;
+	for (k = 0; k < n; k++) {
+		x_re[k] *= s[k];
+		x_im[k] *= s[k];
+	}
+}
+
+/* y += alpha * x, for a real scalar alpha */
+static inline void CV_axpy(size_t n, double alpha,
+		const double *CV_RESTRICT x_re, const double *CV_RESTRICT x_im,
+		double *CV_RESTRICT y_re, double *CV_RESTRICT y_im) {
+	size_t k = 0;
+#ifdef CV_HAVE_AVX2
+	__m256d a = _mm256_set1_pd(alpha);
+	for (; k + 4 <= n; k += 4) {
+		_mm256_storeu_pd(y_re + k, _mm256_fmadd_pd(a, _mm256_loadu_pd(x_re + k), _mm256_loadu_pd(y_re + k)));
+		_mm256_storeu_pd(y_im + k, _mm256_fmadd_pd(a, _mm256_loadu_pd(x_im + k), _mm256_loadu_pd(y_im + k)));
+	}
+#endif
+	for (; k < n; k++) {
+		y_re[k] += alpha * x_re[k];
+		y_im[k] += alpha * x_im[k];
+	}
+}
+
+/* acc += a * b */
+static inline void CV_fma(size_t n,
+		const double *CV_RESTRICT a_re, const double *CV_RESTRICT a_im,
+		const double *CV_RESTRICT b_re, const double *CV_RESTRICT b_im,
+		double *CV_RESTRICT acc_re, double *CV_RESTRICT acc_im) {
+	size_t k = 0;
+#ifdef CV_HAVE_AVX2
+	for (; k + 4 <= n; k += 4) {
+		__m256d ar = _mm256_loadu_pd(a_re + k), ai = _mm256_loadu_pd(a_im + k);
+		__m256d br = _mm256_loadu_pd(b_re + k), bi = _mm256_loadu_pd(b_im + k);
+		__m256d cr = _mm256_loadu_pd(acc_re + k), ci = _mm256_loadu_pd(acc_im + k);
+		cr = _mm256_fnmadd_pd(ai, bi, _mm256_fmadd_pd(ar, br, cr));
+		ci = _mm256_fmadd_pd(ai, br, _mm256_fmadd_pd(ar, bi, ci));
+		_mm256_storeu_pd(acc_re + k, cr);
+		_mm256_storeu_pd(acc_im + k, ci);
+	}
+#endif
+	for (; k < n; k++) {
+		acc_re[k] += a_re[k] * b_re[k] - a_im[k] * b_im[k];
+		acc_im[k] += a_re[k] * b_im[k] + a_im[k] * b_re[k];
+	}
+}
+
+/* out = |x|^2 */
+static inline void CV_abs2(size_t n, const double *CV_RESTRICT x_re, const double *CV_RESTRICT x_im,
+		double *CV_RESTRICT out) {
+	size_t k = 0;
+#ifdef CV_HAVE_AVX2
+	for (; k + 4 <= n; k += 4) {
+		__m256d r = _mm256_loadu_pd(x_re + k), i = _mm256_loadu_pd(x_im + k);
+		_mm256_storeu_pd(out + k, _mm256_fmadd_pd(r, r, _mm256_mul_pd(i, i)));
+	}
+#endif
+	for (; k < n; k++) {
+		out[k] = x_re[k] * x_re[k] + x_im[k] * x_im[k];
+	}
+}
+
+/* out += |x|^2 */
+static inline void CV_abs2_add(size_t n, const double *CV_RESTRICT x_re, const double *CV_RESTRICT x_im,
+		double *CV_RESTRICT out) {
+	size_t k = 0;
+#ifdef CV_HAVE_AVX2
+	for (; k + 4 <= n; k += 4) {
+		__m256d r = _mm256_loadu_pd(x_re + k), i = _mm256_loadu_pd(x_im + k);
+		_mm256_storeu_pd(out + k, _mm256_fmadd_pd(r, r, _mm256_fmadd_pd(i, i, _mm256_loadu_pd(out + k))));
+	}
+#endif
+	for (; k < n; k++) {
+		out[k] += x_re[k] * x_re[k] + x_im[k] * x_im[k];
+	}
+}
+
+/* Largest |x| for which CV_sincos uses its own range reduction, about 2^20 * pi / 2. Larger arguments go to libm. */
+#define CV_SINCOS_MAX 1.6e6
+
+/* out_cos = cos(x), out_sin = sin(x), within about 2.5e-16 absolute.
+ * x is reduced to [-pi/4, pi/4] with pi/2 split in three parts (exact products for |x| < CV_SINCOS_MAX), and
+ * the fdlibm kernel polynomials are used on the reduced argument. The loop has no calls or branches, so it
+ * vectorizes.
+ */
+static inline void CV_sincos(size_t n, const double *CV_RESTRICT x,
+		double *CV_RESTRICT out_cos, double *CV_RESTRICT out_sin) {
+	const double two_over_pi = 6.36619772367581382433e-01;
+	const double pio2_1 = 1.57079632673412561417e+00;
+	const double pio2_2 = 6.07710050630396597660e-11;
+	const double pio2_3 = 2.02226624871116645580e-21;
+	/* Adding and subtracting 1.5 * 2^52 rounds to the nearest integer. */
+	const double round_magic = 6755399441055744.0;
+	size_t k;
+
+	for (k = 0; k < n; k++) {
+		double q = (x[k] * two_over_pi + round_magic) - round_magic;
+		double r = ((x[k] - q * pio2_1) - q * pio2_2) - q * pio2_3;
+		double z = r * r;
+		double s = r + r * z * (-1.66666666666666324348e-01 + z * (8.33333333332248946124e-03
+				+ z * (-1.98412698298579493134e-04 + z * (2.75573137070700676789e-06
+				+ z * (-2.50507602534068634195e-08 + z * 1.58969099521155010221e-10)))));
+		double c = 1.0 - 0.5 * z + z * z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03
+				+ z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07
+				+ z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11)))));
+
+		/* Rotate by the quadrant. Converting q is only defined while it fits an int, so beyond CV_SINCOS_MAX
+		 * (and for NaN) it is taken as 0; those values are replaced below. */
+		int quadrant = (int) ((fabs(q) <= CV_SINCOS_MAX) ? q : 0.0);
+		double sq = (quadrant & 1) ? c : s;
+		double cq = (quadrant & 1) ? s : c;
+		out_sin[k] = (quadrant & 2) ? -sq : sq;
+		out_cos[k] = ((quadrant + 1) & 2) ? -cq : cq;
+	}
+
+	for (k = 0; k < n; k++) {
+		if (fabs(x[k]) > CV_SINCOS_MAX) {
+			out_cos[k] = cos(x[k]);
+			out_sin[k] = sin(x[k]);
+		}
+	}
+}
+
+/* out = amp * exp(i phase). If amp is NULL the amplitude is 1. */
+static inline void CV_polar(size_t n, const double *CV_RESTRICT amp, const double *CV_RESTRICT phase,
+		double *CV_RESTRICT out_re, double *CV_RESTRICT out_im) {
+	size_t k;
+
+	CV_sincos(n, phase, out_re, out_im);
+
+	if (amp != NULL) {
+		for (k = 0; k < n; k++) {
+			out_re[k] *= amp[k];
+			out_im[k] *= amp[k];
+		}
+	}
+}
+
+/* Number of independent recurrences in CV_phase_ramp. */
+#define CV_RAMP_LANES 8
+
+/* out = exp(i (phase0 + k step)) for k < n. The first CV_RAMP_LANES values are computed directly, the rest by
+ * the recurrence out[k] = out[k - CV_RAMP_LANES] * exp(i CV_RAMP_LANES step), whose lanes are independent and
+ * vectorize. The error grows by about one rounding per CV_RAMP_LANES values, so keep n to a few thousand.
+ */
+static inline void CV_phase_ramp(size_t n, double phase0, double step,
+		double *CV_RESTRICT out_re, double *CV_RESTRICT out_im) {
+	size_t k;
+	double r_re = cos(CV_RAMP_LANES * step);
+	double r_im = sin(CV_RAMP_LANES * step);
+
+	for (k = 0; k < n && k < CV_RAMP_LANES; k++) {
+		out_re[k] = cos(phase0 + k * step);
+		out_im[k] = sin(phase0 + k * step);
+	}
+	for (k = CV_RAMP_LANES; k < n; k++) {
+		out_re[k] = out_re[k - CV_RAMP_LANES] * r_re - out_im[k - CV_RAMP_LANES] * r_im;
+		out_im[k] = out_re[k - CV_RAMP_LANES] * r_im + out_im[k - CV_RAMP_LANES] * r_re;
+	}
+}
+
+/* Layout converters. z holds n complex values interleaved as (real, imag). */
+static inline void CV_deinterleave(size_t n, const double *CV_RESTRICT z,
+		double *CV_RESTRICT re, double *CV_RESTRICT im) {
+	size_t k;
+	for (k = 0; k < n; k++) {
+		re[k] = z[2*k + 0];
+		im[k] = z[2*k + 1];
+	}
+}
+
+static inline void CV_interleave(size_t n, const double *CV_RESTRICT re, const double *CV_RESTRICT im,
+		double *CV_RESTRICT z) {
+	size_t k;
+	for (k = 0; k < n; k++) {
+		z[2*k + 0] = re[k];
+		z[2*k + 1] = im[k];
+	}
+}
+
+/* out = conj(a) * b on interleaved arrays, for callers whose data is still in gsl_complex layout. */
+static inline void CV_conj_mul_interleaved(size_t n, const double *CV_RESTRICT a, const double *CV_RESTRICT b,
+		double *CV_RESTRICT out) {
+	size_t k;
+	for (k = 0; k < n; k++) {
+		double re = a[2*k] * b[2*k] + a[2*k+1] * b[2*k+1];
+		double im = a[2*k] * b[2*k+1] - a[2*k+1] * b[2*k];
+		out[2*k + 0] = re;
+		out[2*k + 1] = im;
+	}
+}
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* SRC_C_COMPLEX_VECTOR_H_ */
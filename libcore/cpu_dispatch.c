@@ -0,0 +1,198 @@
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "complex_vector.h"
+#include "cpu_dispatch.h"
+
+#define CPU_PATH_ENV "LDA_CPU_PATH"
+
+/* -1 until the path is first asked for or set */
+static int cpu_path = -1;
+
+CPU_PATH CPU_detect_path() {
+#ifdef CPU_HAVE_DISPATCH
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx512f")) {
+		return CPU_PATH_AVX512;
+	}
+	if (__builtin_cpu_supports("avx2")) {
+		return CPU_PATH_AVX2;
+	}
+	if (__builtin_cpu_supports("sse4.2")) {
+		return CPU_PATH_SSE4;
+	}
+#endif
+	return CPU_PATH_GENERIC;
+}
+
+static void CPU_check_supported(CPU_PATH path) {
+	if (path > CPU_detect_path()) {
+		fprintf(stderr, "Error. CPU path %s is not supported by this machine (at most %s). Exiting.\n",
+				CPU_path_id_to_name(path), CPU_path_id_to_name(CPU_detect_path()));
+		exit(-1);
+	}
+}
+
+CPU_PATH CPU_get_path() {
+	if (cpu_path < 0) {
+		#pragma omp critical (cpu_path)
+		{
+			if (cpu_path < 0) {
+				const char *name = getenv(CPU_PATH_ENV);
+				CPU_PATH path = (name != NULL && name[0] != '\0') ? CPU_path_name_to_id(name) : CPU_detect_path();
+				CPU_check_supported(path);
+				cpu_path = path;
+			}
+		}
+	}
+	return (CPU_PATH) cpu_path;
+}
+
+void CPU_set_path(CPU_PATH path) {
+	CPU_path_id_to_name(path);
+	CPU_check_supported(path);
+
+	#pragma omp critical (cpu_path)
+	{
+		cpu_path = path;
+	}
+}
+
+const char* CPU_path_id_to_name(CPU_PATH path) {
+	switch (path) {
+	case CPU_PATH_GENERIC:
+		return "generic";
+	case CPU_PATH_SSE4:
+		return "sse4";
+	case CPU_PATH_AVX2:
+		return "avx2";
+	case CPU_PATH_AVX512:
+		return "avx512";
+	default:
+		fprintf(stderr, "Error. CPU_path_id_to_name: Invalid CPU_PATH (%d). Exiting.\n", path);
+		exit(-1);
+	}
+}
+
+CPU_PATH CPU_path_name_to_id(const char *name) {
+	assert(name != NULL);
+
+	if (strcmp(name, "generic") == 0) {
+		return CPU_PATH_GENERIC;
+	} else if (strcmp(name, "sse4") == 0) {
+		return CPU_PATH_SSE4;
+	} else if (strcmp(name, "avx2") == 0) {
+		return CPU_PATH_AVX2;
+	} else if (strcmp(name, "avx512") == 0) {
+		return CPU_PATH_AVX512;
+	}
+
+	fprintf(stderr, "Error. CPU_path_name_to_id: Unknown CPU path (%s). Use generic, sse4, avx2 or avx512. Exiting.\n", name);
+	exit(-1);
+}
+
+void CPU_report(FILE *fid) {
+	assert(fid != NULL);
+	fprintf(fid, "CPU path: %s (detected %s)\n", CPU_path_id_to_name(CPU_get_path()),
+			CPU_path_id_to_name(CPU_detect_path()));
+}
+
+/* Number of running maxima in CPU_max, one AVX-512 register of doubles */
+#define CPU_MAX_LANES 8
+
+/* CV_sincos is too large to be inlined on its own into every instance, and a shared out-of-line copy would
+ * be compiled for the generic path only. */
+#ifdef CPU_HAVE_DISPATCH
+	#define CPU_INLINE_ALL __attribute__((flatten))
+#else
+	#define CPU_INLINE_ALL
+#endif
+
+#define CPU_DEFINE_KERNELS(SUFFIX, ATTR)										\
+ATTR static void CPU_abs2_pair_##SUFFIX(size_t n, const double *restrict z_plus, const double *restrict z_minus,	\
+		double *restrict out) {											\
+	size_t j;													\
+	for (j = 0; j < n; j++) {											\
+		out[j] = z_plus[2*j] * z_plus[2*j] + z_plus[2*j + 1] * z_plus[2*j + 1]					\
+				+ z_minus[2*j] * z_minus[2*j] + z_minus[2*j + 1] * z_minus[2*j + 1];			\
+	}														\
+}															\
+															\
+ATTR static double CPU_max_##SUFFIX(size_t n, const double *restrict x) {						\
+	size_t j, k;													\
+	double lane[CPU_MAX_LANES];											\
+	double m = x[0];												\
+															\
+	/* Independent running maxima, an element-wise select the compiler turns into vector max instructions */	\
+	if (n >= CPU_MAX_LANES) {											\
+		for (k = 0; k < CPU_MAX_LANES; k++) {									\
+			lane[k] = x[k];											\
+		}													\
+		for (j = CPU_MAX_LANES; j + CPU_MAX_LANES <= n; j += CPU_MAX_LANES) {					\
+			for (k = 0; k < CPU_MAX_LANES; k++) {								\
+				lane[k] = (x[j + k] > lane[k]) ? x[j + k] : lane[k];					\
+			}												\
+		}													\
+		for (k = 0; k < CPU_MAX_LANES; k++) {									\
+			m = (lane[k] > m) ? lane[k] : m;								\
+		}													\
+	} else {													\
+		j = 1;													\
+	}														\
+	for (; j < n; j++) {												\
+		m = (x[j] > m) ? x[j] : m;										\
+	}														\
+	return m;													\
+}															\
+															\
+ATTR CPU_INLINE_ALL static void CPU_sincos_##SUFFIX(size_t n, const double *restrict x, double *restrict out_cos,			\
+		double *restrict out_sin) {										\
+	CV_sincos(n, x, out_cos, out_sin);										\
+}
+
+CPU_DEFINE_KERNELS(generic, )
+#ifdef CPU_HAVE_DISPATCH
+CPU_DEFINE_KERNELS(sse4, CPU_TARGET_SSE4)
+CPU_DEFINE_KERNELS(avx2, CPU_TARGET_AVX2)
+CPU_DEFINE_KERNELS(avx512, CPU_TARGET_AVX512)
+#endif
+
+#ifdef CPU_HAVE_DISPATCH
+	#define CPU_DISPATCH(NAME, ...)											\
+		switch (CPU_get_path()) {										\
+		case CPU_PATH_AVX512: NAME##_avx512(__VA_ARGS__); break;						\
+		case CPU_PATH_AVX2: NAME##_avx2(__VA_ARGS__); break;							\
+		case CPU_PATH_SSE4: NAME##_sse4(__VA_ARGS__); break;							\
+		default: NAME##_generic(__VA_ARGS__); break;								\
+		}
+	#define CPU_DISPATCH_RETURN(NAME, ...)										\
+		switch (CPU_get_path()) {										\
+		case CPU_PATH_AVX512: return NAME##_avx512(__VA_ARGS__);						\
+		case CPU_PATH_AVX2: return NAME##_avx2(__VA_ARGS__);							\
+		case CPU_PATH_SSE4: return NAME##_sse4(__VA_ARGS__);							\
+		default: return NAME##_generic(__VA_ARGS__);								\
+		}
+#else
+	#define CPU_DISPATCH(NAME, ...) NAME##_generic(__VA_ARGS__);
+	#define CPU_DISPATCH_RETURN(NAME, ...) return NAME##_generic(__VA_ARGS__);
+#endif
+
+void CPU_abs2_pair(size_t n, const double *z_plus, const double *z_minus, double *out) {
+	CPU_DISPATCH(CPU_abs2_pair, n, z_plus, z_minus, out)
+}
+
+double CPU_max(size_t n, const double *x) {
+	assert(n > 0);
+	CPU_DISPATCH_RETURN(CPU_max, n, x)
+}
+
+void CPU_sincos(size_t n, const double *x, double *out_cos, double *out_sin) {
+	CPU_DISPATCH(CPU_sincos, n, x, out_cos, out_sin)
+}
@@ -0,0 +1,65 @@
+#ifndef SRC_C_CPU_DISPATCH_H_
+#define SRC_C_CPU_DISPATCH_H_
+
+#include <stddef.h>
+#include <stdio.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* Instruction set paths of the hot kernels (the radix-4 FFT, the trig of the template phase, the fused
+ * engine's matched-filter sum and the |z|^2 and peak reductions). Each kernel is compiled once per path from
+ * the same source, and the path is picked at run time, so one generic build runs the wide code on the
+ * machines that have it.
+ *
+ * Floating point contraction is off in every path, so all paths give bit-identical results.
+ */
+typedef enum {
+	CPU_PATH_GENERIC = 0,	/* Whatever the compiler targets by default (SSE2 on x86-64) */
+	CPU_PATH_SSE4,
+	CPU_PATH_AVX2,
+	CPU_PATH_AVX512
+} CPU_PATH;
+
+#if defined(__GNUC__) && !defined(__clang__) && (defined(__x86_64__) || defined(__i386__))
+	#define CPU_HAVE_DISPATCH 1
+	#define CPU_TARGET_SSE4 __attribute__((target("sse4.2"), optimize("tree-vectorize", "fp-contract=off")))
+	#define CPU_TARGET_AVX2 __attribute__((target("avx2"), optimize("tree-vectorize", "fp-contract=off")))
+	#define CPU_TARGET_AVX512 __attribute__((target("avx512f"), optimize("tree-vectorize", "fp-contract=off")))
+#else
+	#define CPU_TARGET_SSE4
+	#define CPU_TARGET_AVX2
+	#define CPU_TARGET_AVX512
+#endif
+
+/* The widest path this machine supports. */
+CPU_PATH CPU_detect_path();
+
+/* The path in use: the one set by CPU_set_path, else the LDA_CPU_PATH environment variable, else the
+ * detected one. Asking for a path the machine does not support is an error. */
+CPU_PATH CPU_get_path();
+
+void CPU_set_path(CPU_PATH path);
+
+const char* CPU_path_id_to_name(CPU_PATH path);
+
+CPU_PATH CPU_path_name_to_id(const char *name);
+
+/* Prints the detected and the selected path. */
+void CPU_report(FILE *fid);
+
+/* out[j] = |z_plus[j]|^2 + |z_minus[j]|^2 for interleaved (real, imag) z_plus and z_minus */
+void CPU_abs2_pair(size_t n, const double *z_plus, const double *z_minus, double *out);
+
+/* Largest value of x[0..n-1], n > 0 */
+double CPU_max(size_t n, const double *x);
+
+/* out_cos = cos(x), out_sin = sin(x), as CV_sincos */
+void CPU_sincos(size_t n, const double *x, double *out_cos, double *out_sin);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* SRC_C_CPU_DISPATCH_H_ */
@@ -45,6 +45,54 @@ void Detector_Network_free(detector_network_t* net) {
 	net->detector = NULL;
 }
 
+static psd_t* Detector_Network_copy_psd(const psd_t *psd) {
+	psd_t *copy = PSD_alloc(psd->len);
+	copy->type = psd->type;
+	memcpy(copy->psd, psd->psd, psd->len * sizeof(double));
+	memcpy(copy->f, psd->f, psd->len * sizeof(double));
+	return copy;
+}
+
+static asd_t* Detector_Network_copy_asd(const asd_t *asd) {
+	asd_t *copy = ASD_alloc(asd->len);
+	copy->type = asd->type;
+	memcpy(copy->asd, asd->asd, asd->len * sizeof(double));
+	memcpy(copy->f, asd->f, asd->len * sizeof(double));
+	return copy;
+}
+
+detector_network_t* Detector_Network_copy(const detector_network_t *net) {
+	assert(net != NULL);
+
+	size_t i, r, c;
+	detector_network_t *copy = Detector_Network_alloc(net->num_detectors);
+
+	for (i = 0; i < net->num_detectors; i++) {
+		const detector_t *src = net->detector[i];
+		detector_t *dst = copy->detector[i];
+
+		dst->id = src->id;
+		memcpy(dst->name, src->name, DETECTOR_MAX_NAME_LENGTH * sizeof(char));
+		for (r = 0; r < 3; r++) {
+			gsl_vector_set(dst->location, r, gsl_vector_get(src->location, r));
+			gsl_vector_set(dst->arm_x, r, gsl_vector_get(src->arm_x, r));
+			gsl_vector_set(dst->arm_y, r, gsl_vector_get(src->arm_y, r));
+			for (c = 0; c < 3; c++) {
+				gsl_matrix_set(dst->detector_tensor, r, c, gsl_matrix_get(src->detector_tensor, r, c));
+			}
+		}
+
+		if (src->psd != NULL) {
+			dst->psd = Detector_Network_copy_psd(src->psd);
+		}
+		if (src->asd != NULL) {
+			dst->asd = Detector_Network_copy_asd(src->asd);
+		}
+	}
+
+	return copy;
+}
+
 void Detector_Network_print(detector_network_t* net) {
 	assert(net != NULL);
 
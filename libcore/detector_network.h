@@ -19,6 +19,11 @@ detector_network_t* Detector_Network_alloc(size_t num_detectors);
 
 void Detector_Network_free(detector_network_t* net);
 
+/* Deep copy of the network, including the spectral densities. The copy is written by the calling thread, so
+ * on a NUMA machine its pages are placed on that thread's node.
+ */
+detector_network_t* Detector_Network_copy(const detector_network_t *net);
+
 void Detector_Network_print(detector_network_t* net);
 
 detector_network_t* Detector_Network_load( const char* detector_mapping_file, size_t num_time_samples, double sampling_frequency, double f_low, double f_high );
@@ -0,0 +1,879 @@
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <gsl/gsl_fft_complex.h>
+#include <gsl/gsl_fft_complex_float.h>
+#include <gsl/gsl_math.h>
+
+#ifdef HAVE_FFTW3
+	#include <fftw3.h>
+#endif
+
+#include "cpu_dispatch.h"
+#include "fft.h"
+
+/* Alignment of the scratch buffers. Enough for AVX-512 and for FFTW's SIMD codelets. */
+#define FFT_ALIGNMENT 64
+
+/* Environment variable naming the FFTW wisdom file when none has been set explicitly. */
+#define FFT_WISDOM_ENV "LDA_FFTW_WISDOM"
+
+/* Tile size of the transpose in FFT_execute_pruned. */
+#define FFT_TRANSPOSE_TILE 8
+
+/* GSL scratch lengths kept by one workspace: the full, tc window and baseband transforms, and one spare. */
+#define FFT_GSL_WORKSPACES 4
+
+struct fft_plan_s {
+	size_t n;
+	size_t howmany;
+	FFT_DIRECTION direction;
+	FFT_PRECISION precision;
+	FFT_BACKEND backend;
+
+	/* RADIX4: twiddle factors exp(direction * 2 pi i k / n), k = 0..n-1, interleaved. */
+	double *twiddle;
+	float *twiddle_float;
+
+	/* GSL */
+	gsl_fft_complex_wavetable *gsl_wavetable;
+	gsl_fft_complex_wavetable_float *gsl_wavetable_float;
+
+	/* howmany > 1: the plan of one transform, used by the backends without a batched plan. */
+	struct fft_plan_s *single;
+
+#ifdef HAVE_FFTW3
+	fftw_plan fftw;
+	fftwf_plan fftwf;
+#endif
+
+	struct fft_plan_s *next;
+};
+
+struct fft_pruned_plan_s {
+	size_t n;
+	size_t offset;
+	size_t count;
+
+	/* n = radix * sub_n */
+	size_t radix;
+	size_t sub_n;
+	fft_plan_t *sub_plan;
+
+	/* exp(direction * 2 pi i t / n) for the count output indices, interleaved. */
+	double *twiddle;
+};
+
+struct fft_workspace_s {
+	size_t n;
+
+	/* 2n doubles (or 2n floats), aligned to FFT_ALIGNMENT. */
+	void *scratch;
+
+	/* GSL needs scratch of exactly the transform length, which can be shorter than n. One per length, only
+	 * allocated when a GSL plan of that length is executed with this workspace.
+	 */
+	gsl_fft_complex_workspace *gsl_workspace[FFT_GSL_WORKSPACES];
+	gsl_fft_complex_workspace_float *gsl_workspace_float[FFT_GSL_WORKSPACES];
+};
+
+/* The plan cache is a singly linked list. Lookups only happen when callers set up their workspaces,
+ * so a list is plenty. All access goes through the fft_plan_cache critical section.
+ */
+static fft_plan_t *fft_plan_cache = NULL;
+static FFT_BACKEND fft_backend = FFT_BACKEND_AUTO;
+static char *fft_wisdom_filename = NULL;
+static int fft_wisdom_loaded = 0;
+
+static int FFT_is_power_of_two(size_t n) {
+	return (n > 0) && ((n & (n - 1)) == 0);
+}
+
+static void* FFT_aligned_malloc(size_t bytes) {
+	void *p = NULL;
+	if (posix_memalign(&p, FFT_ALIGNMENT, bytes) != 0) {
+		fprintf(stderr, "Error. FFT: Unable to allocate %lu aligned bytes. Exiting.\n", bytes);
+		exit(-1);
+	}
+	return p;
+}
+
+void FFT_set_backend(FFT_BACKEND backend) {
+	switch (backend) {
+	case FFT_BACKEND_AUTO:
+	case FFT_BACKEND_GSL:
+	case FFT_BACKEND_RADIX4:
+		break;
+	case FFT_BACKEND_FFTW3:
+#ifndef HAVE_FFTW3
+		fprintf(stderr, "Error. FFT_set_backend: Not configured with FFTW3. Exiting.\n");
+		exit(-1);
+#endif
+		break;
+	default:
+		fprintf(stderr, "Error. FFT_set_backend: Invalid FFT_BACKEND (%d). Exiting.\n", backend);
+		exit(-1);
+	}
+
+	#pragma omp critical (fft_plan_cache)
+	{
+		fft_backend = backend;
+	}
+}
+
+FFT_BACKEND FFT_get_backend() {
+	return fft_backend;
+}
+
+const char* FFT_backend_id_to_name(FFT_BACKEND backend) {
+	switch (backend) {
+	case FFT_BACKEND_AUTO:
+		return "auto";
+	case FFT_BACKEND_GSL:
+		return "gsl";
+	case FFT_BACKEND_RADIX4:
+		return "radix4";
+	case FFT_BACKEND_FFTW3:
+		return "fftw3";
+	default:
+		fprintf(stderr, "Error. FFT_backend_id_to_name: Invalid FFT_BACKEND (%d). Exiting.\n", backend);
+		exit(-1);
+	}
+}
+
+FFT_BACKEND FFT_backend_name_to_id(const char *name) {
+	assert(name != NULL);
+
+	if (strcmp(name, "auto") == 0) {
+		return FFT_BACKEND_AUTO;
+	} else if (strcmp(name, "gsl") == 0) {
+		return FFT_BACKEND_GSL;
+	} else if (strcmp(name, "radix4") == 0) {
+		return FFT_BACKEND_RADIX4;
+	} else if (strcmp(name, "fftw3") == 0) {
+		return FFT_BACKEND_FFTW3;
+	}
+
+	fprintf(stderr, "Error. FFT_backend_name_to_id: Unknown FFT backend (%s). Use auto, gsl, radix4 or fftw3. Exiting.\n", name);
+	exit(-1);
+}
+
+void FFT_set_wisdom_filename(const char *filename) {
+	#pragma omp critical (fft_plan_cache)
+	{
+		free(fft_wisdom_filename);
+		fft_wisdom_filename = NULL;
+		if (filename != NULL) {
+			fft_wisdom_filename = strdup(filename);
+		}
+		fft_wisdom_loaded = 0;
+	}
+}
+
+#ifdef HAVE_FFTW3
+/* The single-precision wisdom lives next to the double-precision wisdom. */
+static char* FFT_wisdom_filename_single(const char *filename) {
+	const char *suffix = ".single";
+	char *s = (char*) malloc( strlen(filename) + strlen(suffix) + 1 );
+	if (s == NULL) {
+		fprintf(stderr, "Error. FFT: Unable to allocate memory for the wisdom filename. Exiting.\n");
+		exit(-1);
+	}
+	strcpy(s, filename);
+	strcat(s, suffix);
+	return s;
+}
+
+static const char* FFT_wisdom_filename() {
+	if (fft_wisdom_filename != NULL) {
+		/* An empty name disables the wisdom file */
+		return (fft_wisdom_filename[0] == '\0') ? NULL : fft_wisdom_filename;
+	}
+	return getenv(FFT_WISDOM_ENV);
+}
+
+/* Must be called inside the fft_plan_cache critical section. */
+static void FFT_load_wisdom() {
+	const char *filename;
+
+	if (fft_wisdom_loaded) {
+		return;
+	}
+	fft_wisdom_loaded = 1;
+
+	filename = FFT_wisdom_filename();
+	if (filename != NULL) {
+		char *single = FFT_wisdom_filename_single(filename);
+		/* A missing file is not an error, it is created when the wisdom is saved. */
+		fftw_import_wisdom_from_filename(filename);
+		fftwf_import_wisdom_from_filename(single);
+		free(single);
+	}
+}
+
+/* Must be called inside the fft_plan_cache critical section. */
+static void FFT_export_wisdom() {
+	const char *filename = FFT_wisdom_filename();
+	if (filename != NULL) {
+		char *single = FFT_wisdom_filename_single(filename);
+		if (fftw_export_wisdom_to_filename(filename) == 0 || fftwf_export_wisdom_to_filename(single) == 0) {
+			fprintf(stderr, "Warning. FFT: Unable to save the FFTW wisdom to (%s).\n", filename);
+		}
+		free(single);
+	}
+}
+#endif
+
+void FFT_save_wisdom() {
+#ifdef HAVE_FFTW3
+	#pragma omp critical (fft_plan_cache)
+	{
+		FFT_export_wisdom();
+	}
+#endif
+}
+
+static FFT_BACKEND FFT_resolve_backend(size_t n) {
+	switch (fft_backend) {
+	case FFT_BACKEND_AUTO:
+#ifdef HAVE_FFTW3
+		return FFT_BACKEND_FFTW3;
+#else
+		return FFT_is_power_of_two(n) ? FFT_BACKEND_RADIX4 : FFT_BACKEND_GSL;
+#endif
+	case FFT_BACKEND_RADIX4:
+		/* The built-in kernel only handles powers of two. */
+		return FFT_is_power_of_two(n) ? FFT_BACKEND_RADIX4 : FFT_BACKEND_GSL;
+	default:
+		return fft_backend;
+	}
+}
+
+static fft_plan_t* FFT_plan_find(size_t n, size_t howmany, FFT_DIRECTION direction, FFT_PRECISION precision);
+
+/* Must be called inside the fft_plan_cache critical section (the FFTW planner is not thread-safe). */
+static fft_plan_t* FFT_plan_alloc(size_t n, size_t howmany, FFT_DIRECTION direction, FFT_PRECISION precision,
+		FFT_BACKEND backend) {
+	size_t k;
+
+	fft_plan_t *plan = (fft_plan_t*) calloc( 1, sizeof(fft_plan_t) );
+	if (plan == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for fft_plan_t. Exiting.\n");
+		exit(-1);
+	}
+	plan->n = n;
+	plan->howmany = howmany;
+	plan->direction = direction;
+	plan->precision = precision;
+	plan->backend = backend;
+
+	if (howmany > 1) {
+		plan->single = FFT_plan_find(n, 1, direction, precision);
+
+#ifdef HAVE_FFTW3
+		if (backend == FFT_BACKEND_FFTW3) {
+			/* howmany contiguous transforms, one after the other */
+			int len = (int) n;
+			fftw_complex *buf = (fftw_complex*) fftw_malloc( howmany * n * sizeof(fftw_complex) );
+			plan->fftw = fftw_plan_many_dft(1, &len, (int) howmany, buf, NULL, 1, len, buf, NULL, 1, len,
+					direction, FFTW_MEASURE);
+			fftw_free(buf);
+		}
+#endif
+		return plan;
+	}
+
+	switch (backend) {
+	case FFT_BACKEND_RADIX4:
+		plan->twiddle = (double*) FFT_aligned_malloc( 2 * n * sizeof(double) );
+		for (k = 0; k < n; k++) {
+			double theta = direction * 2.0 * M_PI * (double) k / (double) n;
+			plan->twiddle[2*k + 0] = cos(theta);
+			plan->twiddle[2*k + 1] = sin(theta);
+		}
+		if (precision == FFT_SINGLE) {
+			plan->twiddle_float = (float*) FFT_aligned_malloc( 2 * n * sizeof(float) );
+			for (k = 0; k < 2*n; k++) {
+				plan->twiddle_float[k] = (float) plan->twiddle[k];
+			}
+		}
+		break;
+
+	case FFT_BACKEND_GSL:
+		if (precision == FFT_DOUBLE) {
+			plan->gsl_wavetable = gsl_fft_complex_wavetable_alloc( n );
+		} else {
+			plan->gsl_wavetable_float = gsl_fft_complex_wavetable_float_alloc( n );
+		}
+		break;
+
+#ifdef HAVE_FFTW3
+	case FFT_BACKEND_FFTW3:
+		FFT_load_wisdom();
+		/* The planner overwrites its arrays, so plan on scratch memory. The plans are in-place and
+		 * are executed later on arrays with the same alignment (see FFT_execute).
+		 */
+		if (precision == FFT_DOUBLE) {
+			fftw_complex *buf = (fftw_complex*) fftw_malloc( n * sizeof(fftw_complex) );
+			plan->fftw = fftw_plan_dft_1d((int) n, buf, buf, direction, FFTW_MEASURE);
+			fftw_free(buf);
+		} else {
+			fftwf_complex *buf = (fftwf_complex*) fftwf_malloc( n * sizeof(fftwf_complex) );
+			plan->fftwf = fftwf_plan_dft_1d((int) n, buf, buf, direction, FFTW_MEASURE);
+			fftwf_free(buf);
+		}
+		break;
+#endif
+
+	default:
+		fprintf(stderr, "Error. FFT_plan_alloc: Backend (%s) is not available. Exiting.\n", FFT_backend_id_to_name(backend));
+		exit(-1);
+	}
+
+	return plan;
+}
+
+static void FFT_plan_free(fft_plan_t *plan) {
+	free(plan->twiddle);
+	free(plan->twiddle_float);
+
+	if (plan->gsl_wavetable != NULL) {
+		gsl_fft_complex_wavetable_free( plan->gsl_wavetable );
+	}
+	if (plan->gsl_wavetable_float != NULL) {
+		gsl_fft_complex_wavetable_float_free( plan->gsl_wavetable_float );
+	}
+
+#ifdef HAVE_FFTW3
+	if (plan->fftw != NULL) {
+		fftw_destroy_plan( plan->fftw );
+	}
+	if (plan->fftwf != NULL) {
+		fftwf_destroy_plan( plan->fftwf );
+	}
+#endif
+
+	free(plan);
+}
+
+/* Returns the cached plan, creating it if needed. Must be called inside the fft_plan_cache critical section. */
+static fft_plan_t* FFT_plan_find(size_t n, size_t howmany, FFT_DIRECTION direction, FFT_PRECISION precision) {
+	FFT_BACKEND backend = FFT_resolve_backend(n);
+	fft_plan_t *plan;
+
+	for (plan = fft_plan_cache; plan != NULL; plan = plan->next) {
+		if (plan->n == n && plan->howmany == howmany && plan->direction == direction && plan->precision == precision
+				&& plan->backend == backend) {
+			return plan;
+		}
+	}
+
+	plan = FFT_plan_alloc(n, howmany, direction, precision, backend);
+	plan->next = fft_plan_cache;
+	fft_plan_cache = plan;
+
+	return plan;
+}
+
+fft_plan_t* FFT_plan_get(size_t n, FFT_DIRECTION direction, FFT_PRECISION precision) {
+	assert(n > 0);
+	assert(direction == FFT_FORWARD || direction == FFT_BACKWARD);
+	assert(precision == FFT_DOUBLE || precision == FFT_SINGLE);
+
+	fft_plan_t *plan;
+
+	#pragma omp critical (fft_plan_cache)
+	{
+		plan = FFT_plan_find(n, 1, direction, precision);
+	}
+
+	return plan;
+}
+
+fft_plan_t* FFT_plan_many_get(size_t n, size_t howmany, FFT_DIRECTION direction) {
+	assert(n > 0);
+	assert(howmany > 0);
+	assert(direction == FFT_FORWARD || direction == FFT_BACKWARD);
+
+	fft_plan_t *plan;
+
+	#pragma omp critical (fft_plan_cache)
+	{
+		plan = FFT_plan_find(n, howmany, direction, FFT_DOUBLE);
+	}
+
+	return plan;
+}
+
+size_t FFT_plan_length(const fft_plan_t *plan) {
+	assert(plan != NULL);
+	return plan->n;
+}
+
+FFT_BACKEND FFT_plan_backend(const fft_plan_t *plan) {
+	assert(plan != NULL);
+	return plan->backend;
+}
+
+fft_workspace_t* FFT_workspace_alloc(size_t n) {
+	size_t i;
+	fft_workspace_t *workspace = (fft_workspace_t*) malloc( sizeof(fft_workspace_t) );
+	if (workspace == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for fft_workspace_t. Exiting.\n");
+		exit(-1);
+	}
+
+	workspace->n = n;
+	workspace->scratch = FFT_aligned_malloc( 2 * n * sizeof(double) );
+	for (i = 0; i < FFT_GSL_WORKSPACES; i++) {
+		workspace->gsl_workspace[i] = NULL;
+		workspace->gsl_workspace_float[i] = NULL;
+	}
+
+	return workspace;
+}
+
+void FFT_workspace_free(fft_workspace_t *workspace) {
+	assert(workspace != NULL);
+
+	size_t i;
+
+	free(workspace->scratch);
+	workspace->scratch = NULL;
+
+	for (i = 0; i < FFT_GSL_WORKSPACES; i++) {
+		if (workspace->gsl_workspace[i] != NULL) {
+			gsl_fft_complex_workspace_free( workspace->gsl_workspace[i] );
+			workspace->gsl_workspace[i] = NULL;
+		}
+		if (workspace->gsl_workspace_float[i] != NULL) {
+			gsl_fft_complex_workspace_float_free( workspace->gsl_workspace_float[i] );
+			workspace->gsl_workspace_float[i] = NULL;
+		}
+	}
+
+	free(workspace);
+}
+
+size_t FFT_workspace_bytes(const fft_workspace_t *workspace) {
+	assert(workspace != NULL);
+
+	size_t i;
+	size_t bytes = sizeof(fft_workspace_t) + 2 * workspace->n * sizeof(double);
+
+	/* A GSL workspace of length n holds 2n values of scratch. */
+	for (i = 0; i < FFT_GSL_WORKSPACES; i++) {
+		if (workspace->gsl_workspace[i] != NULL) {
+			bytes += sizeof(gsl_fft_complex_workspace) + 2 * workspace->gsl_workspace[i]->n * sizeof(double);
+		}
+		if (workspace->gsl_workspace_float[i] != NULL) {
+			bytes += sizeof(gsl_fft_complex_workspace_float) + 2 * workspace->gsl_workspace_float[i]->n * sizeof(float);
+		}
+	}
+
+	return bytes;
+}
+
+/* The GSL scratch for transforms of length n, allocated on first use. When every slot holds another length
+ * the last one is replaced, which only happens if a workspace is used for more lengths than it was meant for.
+ */
+static gsl_fft_complex_workspace* FFT_gsl_workspace(fft_workspace_t *workspace, size_t n) {
+	size_t i;
+	for (i = 0; i < FFT_GSL_WORKSPACES; i++) {
+		if (workspace->gsl_workspace[i] == NULL) {
+			workspace->gsl_workspace[i] = gsl_fft_complex_workspace_alloc( n );
+			return workspace->gsl_workspace[i];
+		}
+		if (workspace->gsl_workspace[i]->n == n) {
+			return workspace->gsl_workspace[i];
+		}
+	}
+	i = FFT_GSL_WORKSPACES - 1;
+	gsl_fft_complex_workspace_free( workspace->gsl_workspace[i] );
+	workspace->gsl_workspace[i] = gsl_fft_complex_workspace_alloc( n );
+	return workspace->gsl_workspace[i];
+}
+
+static gsl_fft_complex_workspace_float* FFT_gsl_workspace_float(fft_workspace_t *workspace, size_t n) {
+	size_t i;
+	for (i = 0; i < FFT_GSL_WORKSPACES; i++) {
+		if (workspace->gsl_workspace_float[i] == NULL) {
+			workspace->gsl_workspace_float[i] = gsl_fft_complex_workspace_float_alloc( n );
+			return workspace->gsl_workspace_float[i];
+		}
+		if (workspace->gsl_workspace_float[i]->n == n) {
+			return workspace->gsl_workspace_float[i];
+		}
+	}
+	i = FFT_GSL_WORKSPACES - 1;
+	gsl_fft_complex_workspace_float_free( workspace->gsl_workspace_float[i] );
+	workspace->gsl_workspace_float[i] = gsl_fft_complex_workspace_float_alloc( n );
+	return workspace->gsl_workspace_float[i];
+}
+
+/* Radix-4 Stockham autosort FFT, with a final radix-2 pass when log2(n) is odd.
+ *
+ * Pass with sub-transform length l and stride s = n / l: for each p < l/4 and each q < s, the four inputs
+ * x[q + s*(p + j*l/4)] (j = 0..3) are combined by a length-4 DFT, multiplied by w^(k p s) (k = 0..3) and
+ * written to y[q + s*(4p + k)]. The output is naturally ordered, so no bit reversal is needed, and the inner
+ * q loop is unit stride so the compiler can vectorize it. The passes ping-pong between data and scratch.
+ * ATTR is the target attribute of the instruction set path the instance is compiled for (see cpu_dispatch.h).
+ */
+#define FFT_DEFINE_STOCKHAM(TYPE, SUFFIX, ATTR)										\
+ATTR static void FFT_stockham_##SUFFIX(size_t n, int sign, const TYPE *restrict w,						\
+		TYPE *restrict data, TYPE *restrict scratch) {								\
+	TYPE *x = data;													\
+	TYPE *y = scratch;												\
+	size_t l = n;													\
+	size_t s = 1;													\
+	size_t p, q;													\
+															\
+	while (l >= 4) {												\
+		size_t m = l / 4;											\
+		for (p = 0; p < m; p++) {										\
+			const TYPE w1r = w[2*(p*s)],   w1i = w[2*(p*s) + 1];						\
+			const TYPE w2r = w[2*(2*p*s)], w2i = w[2*(2*p*s) + 1];						\
+			const TYPE w3r = w[2*(3*p*s)], w3i = w[2*(3*p*s) + 1];						\
+			const TYPE *restrict x0 = x + 2*s*(p);								\
+			const TYPE *restrict x1 = x + 2*s*(p + m);							\
+			const TYPE *restrict x2 = x + 2*s*(p + 2*m);							\
+			const TYPE *restrict x3 = x + 2*s*(p + 3*m);							\
+			TYPE *restrict y0 = y + 2*s*(4*p + 0);								\
+			TYPE *restrict y1 = y + 2*s*(4*p + 1);								\
+			TYPE *restrict y2 = y + 2*s*(4*p + 2);								\
+			TYPE *restrict y3 = y + 2*s*(4*p + 3);								\
+			for (q = 0; q < s; q++) {									\
+				/* t0 = x0 + x2, t1 = x0 - x2, t2 = x1 + x3, t3 = sign * i * (x1 - x3) */		\
+				const TYPE t0r = x0[2*q] + x2[2*q],     t0i = x0[2*q+1] + x2[2*q+1];			\
+				const TYPE t1r = x0[2*q] - x2[2*q],     t1i = x0[2*q+1] - x2[2*q+1];			\
+				const TYPE t2r = x1[2*q] + x3[2*q],     t2i = x1[2*q+1] + x3[2*q+1];			\
+				const TYPE t3r = -sign * (x1[2*q+1] - x3[2*q+1]);					\
+				const TYPE t3i =  sign * (x1[2*q] - x3[2*q]);						\
+				const TYPE a1r = t1r + t3r, a1i = t1i + t3i;						\
+				const TYPE a2r = t0r - t2r, a2i = t0i - t2i;						\
+				const TYPE a3r = t1r - t3r, a3i = t1i - t3i;						\
+				y0[2*q] = t0r + t2r;									\
+				y0[2*q+1] = t0i + t2i;									\
+				y1[2*q] = w1r*a1r - w1i*a1i;								\
+				y1[2*q+1] = w1r*a1i + w1i*a1r;								\
+				y2[2*q] = w2r*a2r - w2i*a2i;								\
+				y2[2*q+1] = w2r*a2i + w2i*a2r;								\
+				y3[2*q] = w3r*a3r - w3i*a3i;								\
+				y3[2*q+1] = w3r*a3i + w3i*a3r;								\
+			}												\
+		}													\
+		l = m;													\
+		s *= 4;													\
+		{ TYPE *t = x; x = y; y = t; }										\
+	}														\
+															\
+	if (l == 2) {													\
+		const TYPE *restrict x0 = x;										\
+		const TYPE *restrict x1 = x + 2*s;									\
+		for (q = 0; q < s; q++) {										\
+			const TYPE ar = x0[2*q], ai = x0[2*q+1];							\
+			const TYPE br = x1[2*q], bi = x1[2*q+1];							\
+			y[2*q] = ar + br;										\
+			y[2*q+1] = ai + bi;										\
+			y[2*(q+s)] = ar - br;										\
+			y[2*(q+s)+1] = ai - bi;										\
+		}													\
+		{ TYPE *t = x; x = y; y = t; }										\
+	}														\
+															\
+	if (x != data) {												\
+		memcpy(data, x, 2 * n * sizeof(TYPE));									\
+	}														\
+}
+
+FFT_DEFINE_STOCKHAM(double, double, )
+FFT_DEFINE_STOCKHAM(float, float, )
+#ifdef CPU_HAVE_DISPATCH
+FFT_DEFINE_STOCKHAM(double, double_sse4, CPU_TARGET_SSE4)
+FFT_DEFINE_STOCKHAM(float, float_sse4, CPU_TARGET_SSE4)
+FFT_DEFINE_STOCKHAM(double, double_avx2, CPU_TARGET_AVX2)
+FFT_DEFINE_STOCKHAM(float, float_avx2, CPU_TARGET_AVX2)
+FFT_DEFINE_STOCKHAM(double, double_avx512, CPU_TARGET_AVX512)
+FFT_DEFINE_STOCKHAM(float, float_avx512, CPU_TARGET_AVX512)
+#endif
+
+/* The variant of the radix-4 transform for the selected instruction set path */
+static void FFT_stockham_dispatch_double(size_t n, int sign, const double *w, double *data, double *scratch) {
+#ifdef CPU_HAVE_DISPATCH
+	switch (CPU_get_path()) {
+	case CPU_PATH_AVX512:
+		FFT_stockham_double_avx512(n, sign, w, data, scratch);
+		return;
+	case CPU_PATH_AVX2:
+		FFT_stockham_double_avx2(n, sign, w, data, scratch);
+		return;
+	case CPU_PATH_SSE4:
+		FFT_stockham_double_sse4(n, sign, w, data, scratch);
+		return;
+	default:
+		break;
+	}
+#endif
+	FFT_stockham_double(n, sign, w, data, scratch);
+}
+
+static void FFT_stockham_dispatch_float(size_t n, int sign, const float *w, float *data, float *scratch) {
+#ifdef CPU_HAVE_DISPATCH
+	switch (CPU_get_path()) {
+	case CPU_PATH_AVX512:
+		FFT_stockham_float_avx512(n, sign, w, data, scratch);
+		return;
+	case CPU_PATH_AVX2:
+		FFT_stockham_float_avx2(n, sign, w, data, scratch);
+		return;
+	case CPU_PATH_SSE4:
+		FFT_stockham_float_sse4(n, sign, w, data, scratch);
+		return;
+	default:
+		break;
+	}
+#endif
+	FFT_stockham_float(n, sign, w, data, scratch);
+}
+
+void FFT_execute(const fft_plan_t *plan, double *data, fft_workspace_t *workspace) {
+	assert(plan != NULL);
+	assert(data != NULL);
+	assert(workspace != NULL);
+	assert(plan->precision == FFT_DOUBLE);
+	assert(plan->howmany == 1);
+	assert(workspace->n >= plan->n);
+
+	switch (plan->backend) {
+	case FFT_BACKEND_RADIX4:
+		FFT_stockham_dispatch_double(plan->n, plan->direction, plan->twiddle, data, (double*) workspace->scratch);
+		break;
+
+	case FFT_BACKEND_GSL:
+		if (plan->direction == FFT_FORWARD) {
+			gsl_fft_complex_forward( data, 1, plan->n, plan->gsl_wavetable, FFT_gsl_workspace(workspace, plan->n) );
+		} else {
+			gsl_fft_complex_backward( data, 1, plan->n, plan->gsl_wavetable, FFT_gsl_workspace(workspace, plan->n) );
+		}
+		break;
+
+#ifdef HAVE_FFTW3
+	case FFT_BACKEND_FFTW3:
+		/* New-array execution needs the alignment the plan was made with. */
+		if (fftw_alignment_of(data) == 0) {
+			fftw_execute_dft( plan->fftw, (fftw_complex*) data, (fftw_complex*) data );
+		} else {
+			double *aligned = (double*) workspace->scratch;
+			memcpy(aligned, data, 2 * plan->n * sizeof(double));
+			fftw_execute_dft( plan->fftw, (fftw_complex*) aligned, (fftw_complex*) aligned );
+			memcpy(data, aligned, 2 * plan->n * sizeof(double));
+		}
+		break;
+#endif
+
+	default:
+		fprintf(stderr, "Error. FFT_execute: Invalid backend (%d). Exiting.\n", plan->backend);
+		exit(-1);
+	}
+}
+
+void FFT_execute_float(const fft_plan_t *plan, float *data, fft_workspace_t *workspace) {
+	assert(plan != NULL);
+	assert(data != NULL);
+	assert(workspace != NULL);
+	assert(plan->precision == FFT_SINGLE);
+	assert(workspace->n >= plan->n);
+
+	switch (plan->backend) {
+	case FFT_BACKEND_RADIX4:
+		FFT_stockham_dispatch_float(plan->n, plan->direction, plan->twiddle_float, data, (float*) workspace->scratch);
+		break;
+
+	case FFT_BACKEND_GSL:
+		if (plan->direction == FFT_FORWARD) {
+			gsl_fft_complex_float_forward( data, 1, plan->n, plan->gsl_wavetable_float,
+					FFT_gsl_workspace_float(workspace, plan->n) );
+		} else {
+			gsl_fft_complex_float_backward( data, 1, plan->n, plan->gsl_wavetable_float,
+					FFT_gsl_workspace_float(workspace, plan->n) );
+		}
+		break;
+
+#ifdef HAVE_FFTW3
+	case FFT_BACKEND_FFTW3:
+		if (fftwf_alignment_of(data) == 0) {
+			fftwf_execute_dft( plan->fftwf, (fftwf_complex*) data, (fftwf_complex*) data );
+		} else {
+			float *aligned = (float*) workspace->scratch;
+			memcpy(aligned, data, 2 * plan->n * sizeof(float));
+			fftwf_execute_dft( plan->fftwf, (fftwf_complex*) aligned, (fftwf_complex*) aligned );
+			memcpy(data, aligned, 2 * plan->n * sizeof(float));
+		}
+		break;
+#endif
+
+	default:
+		fprintf(stderr, "Error. FFT_execute_float: Invalid backend (%d). Exiting.\n", plan->backend);
+		exit(-1);
+	}
+}
+
+/* One batched FFTW execution when the backend and alignment allow it, else the single plan once per transform. */
+void FFT_execute_many(const fft_plan_t *plan, double *data, fft_workspace_t *workspace) {
+	assert(plan != NULL);
+	assert(data != NULL);
+	assert(workspace != NULL);
+	assert(plan->precision == FFT_DOUBLE);
+
+	size_t i;
+
+	if (plan->howmany == 1) {
+		FFT_execute(plan, data, workspace);
+		return;
+	}
+
+#ifdef HAVE_FFTW3
+	/* New-array execution needs the alignment the plan was made with. Otherwise one transform at a time. */
+	if (plan->backend == FFT_BACKEND_FFTW3 && fftw_alignment_of(data) == 0) {
+		fftw_execute_dft( plan->fftw, (fftw_complex*) data, (fftw_complex*) data );
+		return;
+	}
+#endif
+
+	for (i = 0; i < plan->howmany; i++) {
+		FFT_execute(plan->single, data + 2 * i * plan->n, workspace);
+	}
+}
+
+/* out = out * w + f, on count interleaved complex values. */
+static void FFT_horner_step(size_t count, const double *restrict w, const double *restrict f, double *restrict out) {
+	size_t m;
+	for (m = 0; m < count; m++) {
+		double re = out[2*m] * w[2*m] - out[2*m+1] * w[2*m+1];
+		double im = out[2*m] * w[2*m+1] + out[2*m+1] * w[2*m];
+		out[2*m + 0] = re + f[2*m + 0];
+		out[2*m + 1] = im + f[2*m + 1];
+	}
+}
+
+fft_pruned_plan_t* FFT_pruned_plan_alloc(size_t n, FFT_DIRECTION direction, size_t offset, size_t count) {
+	assert(n > 0);
+	assert(count > 0 && count <= n);
+	assert(direction == FFT_FORWARD || direction == FFT_BACKWARD);
+
+	size_t m;
+	fft_pruned_plan_t *plan = (fft_pruned_plan_t*) malloc( sizeof(fft_pruned_plan_t) );
+	if (plan == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for fft_pruned_plan_t. Exiting.\n");
+		exit(-1);
+	}
+
+	plan->n = n;
+	plan->offset = offset % n;
+	plan->count = count;
+
+	plan->sub_n = count;
+	while (n % plan->sub_n != 0) {
+		plan->sub_n++;
+	}
+	plan->radix = n / plan->sub_n;
+	plan->sub_plan = FFT_plan_get(plan->sub_n, direction, FFT_DOUBLE);
+
+	plan->twiddle = (double*) malloc( 2 * count * sizeof(double) );
+	if (plan->twiddle == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the pruned FFT twiddles. Exiting.\n");
+		exit(-1);
+	}
+	for (m = 0; m < count; m++) {
+		size_t t = (plan->offset + m) % n;
+		double theta = direction * 2.0 * M_PI * (double) t / (double) n;
+		plan->twiddle[2*m + 0] = cos(theta);
+		plan->twiddle[2*m + 1] = sin(theta);
+	}
+
+	return plan;
+}
+
+void FFT_pruned_plan_free(fft_pruned_plan_t *plan) {
+	assert(plan != NULL);
+
+	/* The sub plan belongs to the plan cache. */
+	plan->sub_plan = NULL;
+
+	free(plan->twiddle);
+	plan->twiddle = NULL;
+
+	free(plan);
+}
+
+void FFT_execute_pruned(const fft_pruned_plan_t *plan, const double *data, double *out, double *scratch,
+		fft_workspace_t *workspace) {
+	assert(plan != NULL);
+	assert(data != NULL);
+	assert(out != NULL);
+	assert(scratch != NULL);
+	assert(workspace != NULL);
+	assert(workspace->n >= plan->sub_n);
+
+	size_t k1, k2, b1, b2;
+	size_t radix = plan->radix;
+	size_t sub_n = plan->sub_n;
+	size_t start = plan->offset % sub_n;
+
+	/* Output m reads F_k1[start + m], or F_k1[start + m - sub_n] from wrap on. */
+	size_t wrap = GSL_MIN(plan->count, sub_n - start);
+
+	/* F_k1 occupies scratch[2 k1 sub_n .. 2 (k1 + 1) sub_n). The gather is a transpose of data viewed as a
+	 * sub_n x radix matrix, done in tiles since both strides are usually large powers of two.
+	 */
+	for (b2 = 0; b2 < sub_n; b2 += FFT_TRANSPOSE_TILE) {
+		size_t e2 = GSL_MIN(b2 + FFT_TRANSPOSE_TILE, sub_n);
+		for (b1 = 0; b1 < radix; b1 += FFT_TRANSPOSE_TILE) {
+			size_t e1 = GSL_MIN(b1 + FFT_TRANSPOSE_TILE, radix);
+			for (k2 = b2; k2 < e2; k2++) {
+				for (k1 = b1; k1 < e1; k1++) {
+					scratch[2*(k1 * sub_n + k2) + 0] = data[2*(k1 + radix * k2) + 0];
+					scratch[2*(k1 * sub_n + k2) + 1] = data[2*(k1 + radix * k2) + 1];
+				}
+			}
+		}
+	}
+
+	for (k1 = 0; k1 < radix; k1++) {
+		FFT_execute(plan->sub_plan, scratch + 2 * k1 * sub_n, workspace);
+	}
+
+	/* Horner's rule in w_t = exp(direction * 2 pi i t / n), from the last F_k1 down to F_0. */
+	{
+		const double *f = scratch + 2 * (radix - 1) * sub_n;
+		memcpy( out, f + 2*start, 2 * wrap * sizeof(double) );
+		memcpy( out + 2*wrap, f, 2 * (plan->count - wrap) * sizeof(double) );
+	}
+
+	for (k1 = radix - 1; k1-- > 0; ) {
+		const double *f = scratch + 2 * k1 * sub_n;
+		FFT_horner_step( wrap, plan->twiddle, f + 2*start, out );
+		FFT_horner_step( plan->count - wrap, plan->twiddle + 2*wrap, f, out + 2*wrap );
+	}
+}
+
+void FFT_cleanup() {
+	#pragma omp critical (fft_plan_cache)
+	{
+#ifdef HAVE_FFTW3
+		FFT_export_wisdom();
+#endif
+		while (fft_plan_cache != NULL) {
+			fft_plan_t *next = fft_plan_cache->next;
+			FFT_plan_free(fft_plan_cache);
+			fft_plan_cache = next;
+		}
+	}
+}
@@ -0,0 +1,103 @@
+#ifndef SRC_C_FFT_H_
+#define SRC_C_FFT_H_
+
+#include <stddef.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* All transforms are complex, in-place and operate on interleaved (real, imag) arrays of length 2n.
+ * The backward transform is NOT normalized, so backward(forward(x)) = n * x.
+ */
+typedef enum {
+	FFT_FORWARD = -1,
+	FFT_BACKWARD = +1
+} FFT_DIRECTION;
+
+typedef enum {
+	FFT_DOUBLE = 0,
+	FFT_SINGLE
+} FFT_PRECISION;
+
+typedef enum {
+	FFT_BACKEND_AUTO = 0,	/* FFTW3 if available, otherwise RADIX4 for powers of two and GSL for the rest. */
+	FFT_BACKEND_GSL,		/* GSL mixed-radix. */
+	FFT_BACKEND_RADIX4,		/* Built-in radix-4/2 Stockham kernel. Other lengths fall back to GSL. */
+	FFT_BACKEND_FFTW3		/* Only if configured with FFTW3. */
+} FFT_BACKEND;
+
+/* Plans are immutable once created, owned by the plan cache and shared between threads. */
+typedef struct fft_plan_s fft_plan_t;
+
+/* Scratch memory for executing a plan. Each thread needs its own. */
+typedef struct fft_workspace_s fft_workspace_t;
+
+/* Selects the backend used for plans created from now on. Plans already made are not affected. */
+void FFT_set_backend(FFT_BACKEND backend);
+
+FFT_BACKEND FFT_get_backend();
+
+const char* FFT_backend_id_to_name(FFT_BACKEND backend);
+
+FFT_BACKEND FFT_backend_name_to_id(const char *name);
+
+/* FFTW wisdom is imported from this file before the first plan is made and exported by FFT_save_wisdom()
+ * and FFT_cleanup(). If no file is set, the LDA_FFTW_WISDOM environment variable is used. An empty
+ * filename disables the wisdom file. Ignored without FFTW3.
+ */
+void FFT_set_wisdom_filename(const char *filename);
+
+void FFT_save_wisdom();
+
+/* Returns the cached plan for (n, direction, precision), creating it if needed. Thread-safe. */
+fft_plan_t* FFT_plan_get(size_t n, FFT_DIRECTION direction, FFT_PRECISION precision);
+
+/* Returns the cached plan for howmany transforms of length n, one after the other in the same array, in double
+ * precision. Thread-safe. With FFTW3 they are done by one batched plan, otherwise one at a time.
+ */
+fft_plan_t* FFT_plan_many_get(size_t n, size_t howmany, FFT_DIRECTION direction);
+
+size_t FFT_plan_length(const fft_plan_t *plan);
+
+FFT_BACKEND FFT_plan_backend(const fft_plan_t *plan);
+
+fft_workspace_t* FFT_workspace_alloc(size_t n);
+
+void FFT_workspace_free(fft_workspace_t *workspace);
+
+/* Bytes held by the workspace, including the GSL scratch allocated so far. */
+size_t FFT_workspace_bytes(const fft_workspace_t *workspace);
+
+/* data holds n complex values as 2n doubles (or floats for FFT_execute_float). */
+void FFT_execute(const fft_plan_t *plan, double *data, fft_workspace_t *workspace);
+
+void FFT_execute_float(const fft_plan_t *plan, float *data, fft_workspace_t *workspace);
+
+/* data holds the howmany transforms of a plan from FFT_plan_many_get, 2 * howmany * n doubles. */
+void FFT_execute_many(const fft_plan_t *plan, double *data, fft_workspace_t *workspace);
+
+/* Output-pruned transform of length n that only produces out[t], t = offset .. offset + count - 1 (mod n).
+ * With n = radix * sub_n, sub_n the smallest divisor of n that is at least count,
+ *     out[t] = sum_{k1 < radix} exp(direction * 2 pi i k1 t / n) F_k1[t mod sub_n],
+ * where F_k1 is the length sub_n transform of data[k1 + radix * k2]. This costs n log(sub_n) + count * radix
+ * instead of n log(n). Pruned plans are not cached; the caller owns them. Double precision only.
+ */
+typedef struct fft_pruned_plan_s fft_pruned_plan_t;
+
+fft_pruned_plan_t* FFT_pruned_plan_alloc(size_t n, FFT_DIRECTION direction, size_t offset, size_t count);
+
+void FFT_pruned_plan_free(fft_pruned_plan_t *plan);
+
+/* data (n complex values) is not modified. out holds count complex values and scratch 2n doubles. */
+void FFT_execute_pruned(const fft_pruned_plan_t *plan, const double *data, double *out, double *scratch,
+		fft_workspace_t *workspace);
+
+/* Frees every cached plan (after saving wisdom). No plan obtained earlier may be used afterwards. */
+void FFT_cleanup();
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* SRC_C_FFT_H_ */
@@ -3,23 +3,36 @@
 #include <memory.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <gsl/gsl_cblas.h>
 #include <gsl/gsl_complex.h>
 #include <gsl/gsl_complex_math.h>
-#include <gsl/gsl_fft_complex.h>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_statistics_double.h>
 
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+#include "complex_vector.h"
+#include "cpu_dispatch.h"
 #include "detector.h"
 #include "detector_antenna_patterns.h"
 #include "detector_network.h"
 #include "detector_time_delay.h"
+#include "fft.h"
 #include "inspiral_network_statistic.h"
+#include "inspiral_network_statistic_fixed.h"
 #include "sampling_system.h"
 
 #include "hdf5_file.h"
 
+/* Number of frequency bins the fused engine processes at a time, and the number of scratch arrays it needs.
+ * 13 is also the phase, g and the ramps of CN_FIXED_MAX_DETECTORS detectors for the specialized kernels. */
+#define CN_FUSED_BLOCK 256
+#define CN_FUSED_NUM_SCRATCH 13
+
 coherent_network_helper_t* CN_helper_alloc(size_t num_time_samples) {
 	size_t i;
 	coherent_network_helper_t *h;
@@ -30,6 +43,16 @@ coherent_network_helper_t* CN_helper_alloc(size_t num_time_samples) {
 		exit(-1);
 	}
 
+	h->w_plus_input = 0.0;
+	h->w_minus_input = 0.0;
+	h->c_plus = NULL;
+	h->c_minus = NULL;
+
+	/* The workspaces add the spectra only when an engine needs them. */
+	if (num_time_samples == 0) {
+		return h;
+	}
+
 	h->c_plus = (gsl_complex*) malloc( num_time_samples * sizeof(gsl_complex) );
 	if (h->c_plus == NULL) {
 		fprintf(stderr, "Error. Unable to allocate memory for h->c_plus. Exiting.\n");
@@ -53,114 +76,261 @@ coherent_network_helper_t* CN_helper_alloc(size_t num_time_samples) {
 void CN_helper_free( coherent_network_helper_t* helper) {
 	assert(helper != NULL);
 
-	assert(helper->c_plus != NULL);
 	free(helper->c_plus);
 	helper->c_plus = NULL;
 
-	assert(helper->c_minus != NULL);
 	free(helper->c_minus);
 	helper->c_minus = NULL;
 
 	free(helper);
 }
 
-coherent_network_workspace_t* CN_workspace_alloc(size_t num_time_samples, detector_network_t *net, size_t num_half_freq,
+coherent_network_context_t* CN_context_alloc(size_t num_time_samples, detector_network_t *net, size_t num_half_freq,
 		double f_low, double f_high) {
 	assert(net != NULL);
 
-	coherent_network_workspace_t * work;
-	size_t i, j;
-
-	work = (coherent_network_workspace_t*) malloc(sizeof(coherent_network_workspace_t));
-	if (work == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory: CN_workspace_malloc(). Exiting.\n");
+	size_t i;
+	coherent_network_context_t *context = (coherent_network_context_t*) malloc( sizeof(coherent_network_context_t) );
+	if (context == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the coherent_network_context_t. Exiting.\n");
 		exit(-1);
 	}
 
-	work->num_time_samples = num_time_samples;
-	work->num_helpers = net->num_detectors;
+	context->num_time_samples = num_time_samples;
+	context->num_half_freq = num_half_freq;
+	context->num_detectors = net->num_detectors;
 
-	work->helpers = (coherent_network_helper_t**) malloc( work->num_helpers * sizeof(coherent_network_helper_t*));
-	if (work->helpers == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory: CN_workspace_malloc(). Exiting.\n");
+	/* Note, the asd is only needed to get the frequency values and the number of frequency bins. This should be the
+	 * same for every ASD used for a detector network, so any detector from the network can be used.
+	 */
+	context->sp_lookup = SP_workspace_alloc(f_low, f_high, net->detector[0]->asd->len, net->detector[0]->asd->f);
+
+	/* Each detector has a normalization factor for the stationary phase inner product. */
+	context->normalization_factors = (double*) malloc( net->num_detectors * sizeof(double) );
+	if (context->normalization_factors == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory: CN_context_alloc(). Exiting.\n");
 		exit(-1);
 	}
+	for (i = 0; i < net->num_detectors; i++) {
+		context->normalization_factors[i] = SP_normalization_factor(net->detector[i]->asd, context->sp_lookup);
+	}
 
-	for (i = 0; i < work->num_helpers; i++) {
-		work->helpers[i] = CN_helper_alloc( num_time_samples );
+	return context;
+}
+
+void CN_context_free(coherent_network_context_t *context) {
+	assert(context != NULL);
+
+	SP_workspace_free(context->sp_lookup);
+	context->sp_lookup = NULL;
+
+	free(context->normalization_factors);
+	context->normalization_factors = NULL;
+
+	free(context);
+}
+
+coherent_network_workspace_t* CN_workspace_alloc(size_t num_time_samples, detector_network_t *net, size_t num_half_freq,
+		double f_low, double f_high) {
+	assert(net != NULL);
+
+	coherent_network_context_t *context = CN_context_alloc(num_time_samples, net, num_half_freq, f_low, f_high);
+	coherent_network_workspace_t *work = CN_workspace_alloc_shared(context, net);
+
+	work->own_context = context;
+	return work;
+}
+
+/* Allocates fs[2] and fs[3], used by the two-sided engine, the tc window and the baseband evaluation. */
+static void CN_workspace_alloc_fs(coherent_network_workspace_t *workspace) {
+	size_t i;
+
+	for (i = 2; i < 4; i++) {
+		if (workspace->fs[i] == NULL) {
+			workspace->fs[i] = (double*) AR_malloc( workspace->arena, 2 * workspace->num_time_samples * sizeof(double) );
+		}
 	}
+}
 
-	/* Note, the asd is only needed to get the frequency values and the number of frequency bins. This should be the
-	 * same for every ASD used for a detector network, so any detector from the network can be used.
-	 */
-	work->sp_lookup = SP_workspace_alloc(f_low, f_high, net->detector[0]->asd->len, net->detector[0]->asd->f);
+/* A stationary_phase_t of len zeroed bins carved from the arena. */
+static stationary_phase_t* CN_sp_alloc(arena_t *arena, size_t len) {
+	stationary_phase_t *sp = (stationary_phase_t*) AR_malloc( arena, sizeof(stationary_phase_t) );
+	size_t i;
 
-	work->sp = SP_alloc( num_half_freq );
+	sp->len = len;
+	sp->spa_0 = (gsl_complex*) AR_malloc( arena, len * sizeof(gsl_complex) );
+	for (i = 0; i < len; i++) {
+		sp->spa_0[i] = gsl_complex_rect(0.0, 0.0);
+	}
 
-	work->temp_array = (gsl_complex*) malloc( num_half_freq * sizeof(gsl_complex) );
-	if (work->temp_array == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory: CN_workspace_malloc(). Exiting.\n");
-		exit(-1);
+	return sp;
+}
+
+/* Allocates the templates and spectra of the two-sided and one-sided engines the first time they are used. */
+static void CN_workspace_alloc_legacy(coherent_network_workspace_t *workspace) {
+	size_t i, j;
+	size_t num_time_samples = workspace->num_time_samples;
+	size_t num_half_freq = workspace->context->num_half_freq;
+
+	if (workspace->terms != NULL) {
+		return;
 	}
 
-	for (i = 0; i < num_half_freq; i++) {
-		work->temp_array[i] = gsl_complex_rect(0.0, 0.0);
+	for (i = 0; i < workspace->num_helpers; i++) {
+		coherent_network_helper_t *h = workspace->helpers[i];
+
+		h->c_plus = (gsl_complex*) AR_malloc( workspace->arena, num_time_samples * sizeof(gsl_complex) );
+		h->c_minus = (gsl_complex*) AR_malloc( workspace->arena, num_time_samples * sizeof(gsl_complex) );
+		for (j = 0; j < num_time_samples; j++) {
+			h->c_plus[j] = gsl_complex_rect(0.0, 0.0);
+			h->c_minus[j] = gsl_complex_rect(0.0, 0.0);
+		}
 	}
 
-	work->terms = (gsl_complex**) malloc(4 * sizeof(gsl_complex*) );
-	if (work->terms == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory: CN_workspace_malloc(). Exiting.\n");
-		exit(-1);
+	workspace->sp = CN_sp_alloc( workspace->arena, num_half_freq );
+	workspace->sp_intrinsic = CN_sp_alloc( workspace->arena, num_half_freq );
+
+	workspace->temp_array = (gsl_complex*) AR_malloc( workspace->arena, num_half_freq * sizeof(gsl_complex) );
+
+	for (i = 0; i < num_half_freq; i++) {
+		workspace->temp_array[i] = gsl_complex_rect(0.0, 0.0);
 	}
+
+	workspace->terms = (gsl_complex**) AR_malloc( workspace->arena, 4 * sizeof(gsl_complex*) );
 	for (i = 0; i < 4; i++) {
-		work->terms[i] = (gsl_complex*) malloc( num_time_samples * sizeof(gsl_complex) );
+		workspace->terms[i] = (gsl_complex*) AR_malloc( workspace->arena, num_time_samples * sizeof(gsl_complex) );
 		for (j = 0; j < num_time_samples; j++) {
-			work->terms[i][j] = gsl_complex_rect(0.0, 0.0);
+			workspace->terms[i][j] = gsl_complex_rect(0.0, 0.0);
 		}
 	}
 
-	work->fs = (double**) malloc( 4 * sizeof(double*) );
-	if (work->fs == NULL) {
+	CN_workspace_alloc_fs(workspace);
+}
+
+coherent_network_workspace_t* CN_workspace_alloc_shared(const coherent_network_context_t *context, detector_network_t *net) {
+	assert(context != NULL);
+	assert(net != NULL);
+	assert(net->num_detectors == context->num_detectors);
+
+	coherent_network_workspace_t * work;
+	size_t i;
+	size_t num_time_samples = context->num_time_samples;
+
+	work = (coherent_network_workspace_t*) malloc(sizeof(coherent_network_workspace_t));
+	if (work == NULL) {
 		fprintf(stderr, "Error. Unable to allocate memory: CN_workspace_malloc(). Exiting.\n");
 		exit(-1);
 	}
 
-	for (i = 0; i < 4; i++) {
-		work->fs[i] = (double*) malloc( 2 * num_time_samples * sizeof(double) );
-		if (work->fs[i] == NULL) {
-			fprintf(stderr, "Error. Unable to allocate memory: CN_workspace_malloc(). Exiting.\n");
-			exit(-1);
-		}
-	}
+	work->context = context;
+	work->own_context = NULL;
+
+	/* Room for fs[0], fs[1], temp_ifft, the filtered data and the fused scratch, with their padding, in one chunk. */
+	work->arena = AR_alloc( (5 * num_time_samples + 2 * net->num_detectors * context->sp_lookup->len
+			+ CN_FUSED_NUM_SCRATCH * CN_FUSED_BLOCK) * sizeof(double) + (2 * net->num_detectors + 4) * ARENA_ALIGNMENT,
+			AR_get_default_pages() );
 
-	work->temp_ifft = (double*) malloc( num_time_samples * sizeof(double) );
-	if (work->temp_ifft == NULL) {
+	work->num_time_samples = num_time_samples;
+	work->engine = CN_ENGINE_TWO_SIDED;
+	work->num_helpers = net->num_detectors;
+
+	work->helpers = (coherent_network_helper_t**) malloc( work->num_helpers * sizeof(coherent_network_helper_t*));
+	if (work->helpers == NULL) {
 		fprintf(stderr, "Error. Unable to allocate memory: CN_workspace_malloc(). Exiting.\n");
 		exit(-1);
 	}
 
-	work->fft_wavetable = gsl_fft_complex_wavetable_alloc( num_time_samples );
-	work->fft_workspace = gsl_fft_complex_workspace_alloc( num_time_samples );
+	for (i = 0; i < work->num_helpers; i++) {
+		work->helpers[i] = CN_helper_alloc( 0 );
+	}
+
+	work->sp_lookup = context->sp_lookup;
+	work->normalization_factors = context->normalization_factors;
 
-	work->ap_workspace = Detector_Antenna_Patterns_workspace_alloc();
+	/* Only needed by the two-sided and one-sided engines, see CN_workspace_alloc_legacy. */
+	work->sp = NULL;
+	work->sp_intrinsic = NULL;
+	work->temp_array = NULL;
+	work->terms = NULL;
 
-	/* one antenna pattern structure per detector */
-	work->ap = (detector_antenna_patterns_t*) malloc (net->num_detectors * sizeof(detector_antenna_patterns_t) );
-	if (work->ap == NULL) {
+	work->fs = (double**) malloc( 4 * sizeof(double*) );
+	if (work->fs == NULL) {
 		fprintf(stderr, "Error. Unable to allocate memory: CN_workspace_malloc(). Exiting.\n");
 		exit(-1);
 	}
 
-	/* Each detector has a normalization factor for the stationary phase inner product. */
-	work->normalization_factors = (double*) malloc( net->num_detectors * sizeof(double) );
-	if (work->normalization_factors == NULL) {
+	for (i = 0; i < 4; i++) {
+		work->fs[i] = NULL;
+	}
+	for (i = 0; i < 2; i++) {
+		work->fs[i] = (double*) AR_malloc( work->arena, 2 * num_time_samples * sizeof(double) );
+	}
+
+	work->temp_ifft = (double*) AR_malloc( work->arena, num_time_samples * sizeof(double) );
+
+	work->ifft_plan = FFT_plan_get( num_time_samples, FFT_BACKWARD, FFT_DOUBLE );
+	work->fft_workspace = FFT_workspace_alloc( num_time_samples );
+
+	work->sky_geometry = SG_alloc( net );
+	work->sky_table = NULL;
+
+	work->filtered_generation = 0;
+	work->filtered_realization = 0;
+	work->filtered_re = (double**) malloc( net->num_detectors * sizeof(double*) );
+	work->filtered_im = (double**) malloc( net->num_detectors * sizeof(double*) );
+	if (work->filtered_re == NULL || work->filtered_im == NULL) {
 		fprintf(stderr, "Error. Unable to allocate memory: CN_workspace_malloc(). Exiting.\n");
 		exit(-1);
 	}
 	for (i = 0; i < net->num_detectors; i++) {
-		work->normalization_factors[i] = SP_normalization_factor(net->detector[i]->asd, work->sp_lookup);
+		work->filtered_re[i] = (double*) AR_malloc( work->arena, work->sp_lookup->len * sizeof(double) );
+		work->filtered_im[i] = (double*) AR_malloc( work->arena, work->sp_lookup->len * sizeof(double) );
 	}
 
+	work->fused_scratch = (double*) AR_malloc( work->arena, CN_FUSED_NUM_SCRATCH * CN_FUSED_BLOCK * sizeof(double) );
+
+	/* The single precision arrays are only allocated if they are asked for. */
+	work->precision = FFT_DOUBLE;
+	work->filtered_re_single = NULL;
+	work->filtered_im_single = NULL;
+	work->fs_single = NULL;
+	work->ifft_plan_single = NULL;
+
+	work->tc_window_start = 0;
+	work->tc_window_count = 0;
+	work->tc_window_plan = NULL;
+	work->tc_window_z = NULL;
+	work->tc_window_capacity = 0;
+
+	work->baseband_len = 0;
+	work->baseband_plan = NULL;
+
+	work->search_start = 0;
+	work->search_count = num_time_samples;
+
+	work->template_cache = NULL;
+	work->intrinsic_phasor = NULL;
+
+	work->sky_series_len = 0;
+	work->sky_series_center = 0;
+	work->sky_series_plan = NULL;
+	work->sky_series_fft_workspace = NULL;
+	work->sky_series = NULL;
+
+	work->batch_spectra = NULL;
+	work->batch_geometry = NULL;
+	work->batch_phasor = NULL;
+	work->batch_scratch = NULL;
+	work->batch_ifft_plan = NULL;
+
+	work->realization_generation = 0;
+	work->num_realizations = 0;
+	work->realization_filtered = NULL;
+	work->detector_phasor = NULL;
+
+	work->num_threads = 1;
+	work->extra_fft_workspace = NULL;
+
 	return work;
 }
 
@@ -169,296 +339,1302 @@ void CN_workspace_free( coherent_network_workspace_t *workspace ) {
 
 	size_t i;
 
+	/* The spectra belong to the arena */
 	for (i = 0; i < workspace->num_helpers; i++) {
+		workspace->helpers[i]->c_plus = NULL;
+		workspace->helpers[i]->c_minus = NULL;
 		CN_helper_free( workspace->helpers[i] );
 		workspace->helpers[i] = NULL;
 	}
 	free(workspace->helpers);
 	workspace->helpers = NULL;
 
-	SP_workspace_free(workspace->sp_lookup);
+	/* Shared with the other workspaces of the context */
 	workspace->sp_lookup = NULL;
+	workspace->normalization_factors = NULL;
 
-	SP_free(workspace->sp);
+	/* Everything below that is not freed explicitly belongs to the arena. */
 	workspace->sp = NULL;
-
-	for (i = 0; i < 4; i++) {
-		free(workspace->terms[i]);
-		workspace->terms[i] = NULL;
-
-		free(workspace->fs[i]);
-		workspace->fs[i] = NULL;
-	}
-
-	free(workspace->terms);
+	workspace->sp_intrinsic = NULL;
 	workspace->terms = NULL;
 
 	free(workspace->fs);
 	workspace->fs = NULL;
-
-	free(workspace->temp_ifft);
 	workspace->temp_ifft = NULL;
-
-	free(workspace->temp_array);
 	workspace->temp_array = NULL;
 
-	gsl_fft_complex_workspace_free( workspace->fft_workspace );
+	FFT_workspace_free( workspace->fft_workspace );
 	workspace->fft_workspace = NULL;
 
-	gsl_fft_complex_wavetable_free( workspace->fft_wavetable );
-	workspace->fft_wavetable = NULL;
+	/* The plan belongs to the plan cache. */
+	workspace->ifft_plan = NULL;
 
-	Detector_Antenna_Patterns_workspace_free(workspace->ap_workspace);
-	workspace->ap_workspace = NULL;
+	SG_free(workspace->sky_geometry);
+	workspace->sky_geometry = NULL;
 
-	free(workspace->ap);
-	workspace->ap = NULL;
+	/* The sky table is shared. */
+	workspace->sky_table = NULL;
 
-	free(workspace->normalization_factors);
-	workspace->normalization_factors = NULL;
-
-	free( workspace );
-}
+	free(workspace->filtered_re);
+	workspace->filtered_re = NULL;
 
-void CN_do_work(size_t num_time_samples, size_t f_low_index, size_t f_high_index, gsl_complex *spa, asd_t *asd, gsl_complex *half_fft_data, gsl_complex *temp, gsl_complex *out_c) {
-	assert(spa != NULL);
-	assert(asd != NULL);
-	assert(half_fft_data != NULL);
-	assert(temp != NULL);
-	assert(out_c != NULL);
+	free(workspace->filtered_im);
+	workspace->filtered_im = NULL;
+	workspace->fused_scratch = NULL;
 
-	size_t k;
-	size_t t_index;
-	size_t c_index;
+	workspace->filtered_re_single = NULL;
+	workspace->filtered_im_single = NULL;
+	workspace->fs_single = NULL;
+	workspace->ifft_plan_single = NULL;
 
-	// faster version for (k = f_low_index; k <= f_high_index; k++) {
-	for (k = 0; k < asd->len; k++) {
-		temp[k] = gsl_complex_conjugate(spa[k]);
-		temp[k] = gsl_complex_div_real(temp[k], asd->asd[k]);
-		temp[k] = gsl_complex_mul( temp[k], half_fft_data[k] );
+	if (workspace->tc_window_plan != NULL) {
+		FFT_pruned_plan_free( workspace->tc_window_plan );
+		workspace->tc_window_plan = NULL;
 	}
+	workspace->tc_window_z = NULL;
+	workspace->tc_window_capacity = 0;
 
-	/* This should extend the array with a flipped conjugated version. */
-	SS_make_two_sided( asd->len, temp, num_time_samples, out_c);
-}
-
-void CN_save(char* filename, size_t len, double* tmp_ifft) {
-	assert(filename != NULL);
-	assert(tmp_ifft != NULL);
+	/* The plan belongs to the plan cache. */
+	workspace->baseband_plan = NULL;
 
-	FILE* file;
-	size_t i;
+	/* The template cache is shared. */
+	workspace->template_cache = NULL;
+	workspace->intrinsic_phasor = NULL;
 
-	file = fopen(filename, "w");
-	if (file == NULL) {
-		fprintf(stderr, "Error. CN_save: Unable to open the file (%s) for writing. Exiting.\n", filename);
-		exit(-1);
+	if (workspace->sky_series != NULL) {
+		FFT_workspace_free(workspace->sky_series_fft_workspace);
 	}
+	workspace->sky_series = NULL;
+	workspace->sky_series_fft_workspace = NULL;
+	/* The plan belongs to the plan cache. */
+	workspace->sky_series_plan = NULL;
+
+	/* The batch plans belong to the plan cache. */
+	workspace->batch_spectra = NULL;
+	workspace->batch_geometry = NULL;
+	workspace->batch_phasor = NULL;
+	workspace->batch_scratch = NULL;
+	workspace->batch_ifft_plan = NULL;
+
+	workspace->realization_filtered = NULL;
+	workspace->detector_phasor = NULL;
+	workspace->realization_generation = 0;
+
+	for (i = 0; i + 1 < workspace->num_threads; i++) {
+		FFT_workspace_free(workspace->extra_fft_workspace[i]);
+	}
+	free(workspace->extra_fft_workspace);
+	workspace->extra_fft_workspace = NULL;
 
-	for (i = 0; i < len; i++) {
-		fprintf(file, "%e\n", tmp_ifft[i]);
+	workspace->filtered_generation = 0;
+
+	if (workspace->own_context != NULL) {
+		CN_context_free(workspace->own_context);
 	}
-	fclose(file);
-}
+	workspace->own_context = NULL;
+	workspace->context = NULL;
 
-/* DANGER. This assumes that the coalece phase is 0 */
-void coherent_network_statistic(
-		detector_network_t* net,
-		double f_low,
-		double f_high,
-		inspiral_chirp_time_t *chirp,
-		sky_t *sky,
-		network_strain_half_fft_t *network_strain,
-		coherent_network_workspace_t *workspace,
-		double *out_network_snr,
-		char *hdf5_filename)
-{
-	assert(net);
-	assert(chirp);
-	assert(sky);
-	assert(network_strain);
-	assert(workspace);
-	assert(out_network_snr);
+	AR_free(workspace->arena);
+	workspace->arena = NULL;
 
-	double UdotU_input;
-	double UdotV_input;
-	double VdotV_input;
-	size_t i;
-	double A_input;
-	double B_input;
-	double C_input;
-	double Delta_input;
-	double Delta_factor_input;
-	double D_input;
-	double P1_input;
-	double P2_input;
-	double P3_input;
-	double P4_input;
-	double G1_input;
-	double G2_input;
-	double O11_input;
-	double O12_input;
-	double O21_input;
-	double O22_input;
-	size_t tid;
-	size_t did;
-	size_t fid;
-	size_t j;
-	double max_value;
-	size_t max_index;
+	free( workspace );
+}
 
-	/* WARNING: This assumes that all of the signals have the same lengths. */
-	size_t num_time_samples = network_strain->num_time_samples;
+size_t CN_workspace_bytes_per_thread(const coherent_network_workspace_t *workspace) {
+	assert(workspace != NULL);
 
-	/* Compute the antenna patterns for each detector */
-	for (i = 0; i < net->num_detectors; i++) {
-		double polarization_angle = 0.0; // Shihan said only u and v are needed for templates.
-		Detector_Antenna_Patterns_compute(net->detector[i], sky, polarization_angle,
-				workspace->ap_workspace, &workspace->ap[i]);
-	}
+	size_t t;
+	size_t num_detectors = workspace->num_helpers;
+	size_t bytes = AR_reserved_bytes(workspace->arena);
 
-	/* We need to make vectors with the same number of dimensions as the number of detectors in the network */
-	UdotU_input = 0.0;
-	UdotV_input = 0.0;
-	VdotV_input = 0.0;
+	/* What is not in the arena */
+	bytes += sizeof(coherent_network_workspace_t);
+	bytes += num_detectors * (sizeof(coherent_network_helper_t*) + sizeof(coherent_network_helper_t));
+	bytes += 4 * sizeof(double*);
+	bytes += 2 * num_detectors * sizeof(double*);
+	bytes += sizeof(sky_geometry_t) + 15 * num_detectors * sizeof(double);
 
-	/* dot product */
-	for (i = 0; i < net->num_detectors; i++) {
-		UdotU_input += workspace->ap[i].u * workspace->ap[i].u;
-		UdotV_input += workspace->ap[i].u * workspace->ap[i].v;
-		VdotV_input += workspace->ap[i].v * workspace->ap[i].v;
+	bytes += FFT_workspace_bytes(workspace->fft_workspace);
+	for (t = 0; t + 1 < workspace->num_threads; t++) {
+		bytes += sizeof(fft_workspace_t*) + FFT_workspace_bytes(workspace->extra_fft_workspace[t]);
+	}
+	if (workspace->sky_series_fft_workspace != NULL) {
+		bytes += FFT_workspace_bytes(workspace->sky_series_fft_workspace);
 	}
 
-	A_input = UdotU_input;
-	B_input = UdotV_input;
-	C_input = VdotV_input;
+	return bytes;
+}
 
-	Delta_input = (A_input*C_input) - (B_input*B_input);
-	Delta_factor_input = 1.0 / sqrt(2.0*Delta_input);
+void CN_workspace_set_engine( coherent_network_workspace_t *workspace, CN_ENGINE engine ) {
+	assert(workspace != NULL);
 
-	D_input = sqrt( gsl_pow_2(A_input-C_input) + 4.0*gsl_pow_2(B_input) ) ;
+	switch (engine) {
+	case CN_ENGINE_TWO_SIDED:
+	case CN_ENGINE_ONE_SIDED:
+	case CN_ENGINE_FUSED:
+		workspace->engine = engine;
+		break;
+	default:
+		fprintf(stderr, "Error. Invalid CN_ENGINE (%d). Exiting.\n", engine);
+		exit(-1);
+	}
+}
 
-	P1_input = (C_input-A_input-D_input);
-	P2_input = (C_input-A_input+D_input);
-	P3_input = sqrt(C_input+A_input+D_input);
-	P4_input = sqrt(C_input+A_input-D_input);
+const char* CN_engine_id_to_name(CN_ENGINE engine) {
+	switch (engine) {
+	case CN_ENGINE_TWO_SIDED: return "two_sided"; break;
+	case CN_ENGINE_ONE_SIDED: return "one_sided"; break;
+	case CN_ENGINE_FUSED: return "fused"; break;
+	default:
+		fprintf(stderr, "Error. Invalid CN_ENGINE (%d). Can not convert to string. Exiting.\n", engine);
+		exit(-1);
+	}
+}
 
-	G1_input =  sqrt( gsl_pow_2(P1_input) +  4.0*gsl_pow_2(B_input)) / (2.0*B_input) ;
-	G2_input =  sqrt( gsl_pow_2(P2_input) +  4.0*gsl_pow_2(B_input)) / (2.0*B_input) ;
+CN_ENGINE CN_engine_name_to_id(const char *name) {
+	assert(name != NULL);
+
+	if (strcmp(name, "two_sided") == 0) {
+		return CN_ENGINE_TWO_SIDED;
+	} else if (strcmp(name, "one_sided") == 0) {
+		return CN_ENGINE_ONE_SIDED;
+	} else if (strcmp(name, "fused") == 0) {
+		return CN_ENGINE_FUSED;
+	} else {
+		fprintf(stderr, "Error. Invalid network statistic engine (%s). Must be 'two_sided', 'one_sided' or 'fused'. Exiting.\n", name);
+		exit(-1);
+	}
+}
 
-	O11_input = Delta_factor_input * P3_input / G1_input ;
-	O12_input = Delta_factor_input * P3_input * P1_input / (2.0*B_input*G1_input) ;
-	O21_input = Delta_factor_input * P4_input / G2_input ;
-	O22_input  = Delta_factor_input * P4_input * P2_input / (2.0*B_input*G2_input);
+void CN_workspace_set_tc_window( coherent_network_workspace_t *workspace, size_t start, size_t count ) {
+	assert(workspace != NULL);
 
-	/* Loop over each detector to generate a template and do matched filtering */
-	for (i = 0; i < net->num_detectors; i++) {
-		detector_t* det;
-		double inspiral_coalesce_phase;
-		gsl_complex* whitened_data;
-		double U_vec_input;
-		double V_vec_input;
-		double detector_time_delay;
+	if (count > 0 && (start >= workspace->num_time_samples || count > workspace->num_time_samples - start)) {
+		fprintf(stderr, "Error. The coalescence time window (%lu, %lu samples) is outside the series (%lu samples). Exiting.\n",
+				start, count, workspace->num_time_samples);
+		exit(-1);
+	}
 
-		det = net->detector[i];
+	if (workspace->tc_window_plan != NULL) {
+		FFT_pruned_plan_free( workspace->tc_window_plan );
+		workspace->tc_window_plan = NULL;
+	}
+	workspace->tc_window_start = (count > 0) ? start : 0;
+	workspace->tc_window_count = count;
+
+	if (count > 0) {
+		CN_workspace_alloc_fs(workspace);
+		workspace->tc_window_plan = FFT_pruned_plan_alloc( workspace->num_time_samples, FFT_BACKWARD, start, count );
+		/* As with the fused scratch, a smaller window reuses the block already in the arena. */
+		if (count > workspace->tc_window_capacity) {
+			workspace->tc_window_z = (double*) AR_malloc( workspace->arena, 4 * count * sizeof(double) );
+			workspace->tc_window_capacity = count;
+		}
+	}
+}
 
-		/* For reconstruction use the phase as 0 */
-		inspiral_coalesce_phase = 0.0;
+void CN_workspace_set_threads( coherent_network_workspace_t *workspace, size_t num_threads ) {
+	assert(workspace != NULL);
+	assert(num_threads > 0);
 
-		/* Compute time delay */
-		Detector_time_delay(det, sky, &detector_time_delay);
+	size_t t;
 
-		/*printf("g = %0.21e\n", workspace->normalization_factors[i]);*/
+	for (t = 0; t + 1 < workspace->num_threads; t++) {
+		FFT_workspace_free(workspace->extra_fft_workspace[t]);
+	}
+	free(workspace->extra_fft_workspace);
+	workspace->extra_fft_workspace = NULL;
 
-		SP_compute(		detector_time_delay, workspace->normalization_factors[i],
-						inspiral_coalesce_phase, chirp,
-						workspace->sp_lookup,
-						workspace->sp);
+	/* The old scratch stays in the arena, so it is only replaced when more threads need room. */
+	if (num_threads > workspace->num_threads) {
+		workspace->fused_scratch = (double*) AR_malloc( workspace->arena,
+				num_threads * CN_FUSED_NUM_SCRATCH * CN_FUSED_BLOCK * sizeof(double) );
+	}
 
-		/*
-		printf("Detector SPA_0: %s\n", det->name);
-		for (j = 0; j < workspace->sp->len; j++) {
-			printf("%0.21e \t %0.21e\n", GSL_REAL(workspace->sp->spa_0[j]), GSL_IMAG(workspace->sp->spa_0[j]));
+	if (num_threads > 1) {
+		workspace->extra_fft_workspace = (fft_workspace_t**) malloc( (num_threads - 1) * sizeof(fft_workspace_t*) );
+		if (workspace->extra_fft_workspace == NULL) {
+			fprintf(stderr, "Error. Unable to allocate memory: CN_workspace_set_threads(). Exiting.\n");
+			exit(-1);
 		}
+		for (t = 0; t + 1 < num_threads; t++) {
+			workspace->extra_fft_workspace[t] = FFT_workspace_alloc( workspace->num_time_samples );
+		}
+	}
 
-		printf("Detector SPA_90: %s\n", det->name);
-		for (j = 0; j < workspace->sp->len; j++) {
-			printf("%0.21e \t %0.21e\n", GSL_REAL(workspace->sp->spa_90[j]), GSL_IMAG(workspace->sp->spa_90[j]));
-		}*/
-
-		whitened_data = network_strain->strains[i]->half_fft;
+	workspace->num_threads = num_threads;
+}
 
-		/* compute c_plus */
-		CN_do_work(num_time_samples, workspace->sp_lookup->f_low_index, workspace->sp_lookup->f_high_index, workspace->sp->spa_0, det->asd, whitened_data, workspace->temp_array, workspace->helpers[i]->c_plus);
+/* Thread number inside the parallel regions of one evaluation */
+static size_t CN_thread_num() {
+#ifdef _OPENMP
+	return omp_get_thread_num();
+#else
+	return 0;
+#endif
+}
 
-		/* compute c_minus */
-		CN_do_work(num_time_samples, workspace->sp_lookup->f_low_index, workspace->sp_lookup->f_high_index, workspace->sp->spa_90, det->asd, whitened_data, workspace->temp_array, workspace->helpers[i]->c_minus);
+static fft_workspace_t* CN_thread_fft_workspace( coherent_network_workspace_t *workspace ) {
+	size_t t = CN_thread_num();
+	return (t == 0) ? workspace->fft_workspace : workspace->extra_fft_workspace[t - 1];
+}
 
-		U_vec_input = workspace->ap[i].u;
-		V_vec_input = workspace->ap[i].v;
+void CN_workspace_set_template_cache( coherent_network_workspace_t *workspace, template_cache_t *cache ) {
+	assert(workspace != NULL);
 
-		workspace->helpers[i]->w_plus_input = (O11_input*U_vec_input +  O12_input*V_vec_input);
-		workspace->helpers[i]->w_minus_input = (O21_input*U_vec_input +  O22_input*V_vec_input);
+	if (cache != NULL && TC_template_len(cache) != workspace->sp_lookup->len) {
+		fprintf(stderr, "Error. The template cache holds templates of length %lu but the band has %lu bins. Exiting.\n",
+				TC_template_len(cache), workspace->sp_lookup->len);
+		exit(-1);
 	}
 
-	/* zero the memory */
-	for (tid = 0; tid < 4; tid++) {
-		memset( workspace->terms[tid], 0, num_time_samples * sizeof(gsl_complex) );
-		memset( workspace->fs[tid], 0, num_time_samples * sizeof(gsl_complex) );
+	if (cache != NULL && workspace->intrinsic_phasor == NULL) {
+		workspace->intrinsic_phasor = (double*) AR_malloc( workspace->arena, 2 * workspace->sp_lookup->len * sizeof(double) );
 	}
 
-	for (did = 0; did < net->num_detectors; did++) {
-		for (fid = 0; fid < num_time_samples; fid++) {
-			gsl_complex t;
+	workspace->template_cache = cache;
+}
 
-			t = gsl_complex_mul_real(workspace->helpers[did]->c_plus[fid], workspace->helpers[did]->w_plus_input);
-			workspace->terms[0][fid] = gsl_complex_add( workspace->terms[0][fid], t);
+void CN_workspace_set_sky_table( coherent_network_workspace_t *workspace, const sky_geometry_table_t *table ) {
+	assert(workspace != NULL);
 
-			t = gsl_complex_mul_real(workspace->helpers[did]->c_plus[fid], workspace->helpers[did]->w_minus_input);
-			workspace->terms[1][fid] = gsl_complex_add( workspace->terms[1][fid], t);
+	if (table != NULL && table->num_detectors != workspace->sky_geometry->num_detectors) {
+		fprintf(stderr, "Error. The sky geometry table is for %lu detectors but the network has %lu. Exiting.\n",
+				table->num_detectors, workspace->sky_geometry->num_detectors);
+		exit(-1);
+	}
 
-			t = gsl_complex_mul_real(workspace->helpers[did]->c_minus[fid], workspace->helpers[did]->w_plus_input);
-			workspace->terms[2][fid] = gsl_complex_add( workspace->terms[2][fid], t);
+	workspace->sky_table = table;
+}
 
-			t = gsl_complex_mul_real(workspace->helpers[did]->c_minus[fid], workspace->helpers[did]->w_minus_input);
-			workspace->terms[3][fid] = gsl_complex_add( workspace->terms[3][fid], t);
-		}
-	}
+void CN_workspace_set_baseband( coherent_network_workspace_t *workspace, int enable ) {
+	assert(workspace != NULL);
 
-	for (i = 0; i < 4; i++) {
-		for (j = 0; j < num_time_samples; j++) {
-			workspace->fs[i][2*j + 0] = GSL_REAL( workspace->terms[i][j] );
-			workspace->fs[i][2*j + 1] = GSL_IMAG( workspace->terms[i][j] );
-		}
-		gsl_fft_complex_inverse( workspace->fs[i], 1, num_time_samples, workspace->fft_wavetable, workspace->fft_workspace );
-	}
+	if (enable) {
+		size_t len = workspace->sp_lookup->len;
+		assert(len > 0);
 
-	memset(workspace->temp_ifft, 0, num_time_samples * sizeof(double));
-	for (i = 0; i < 4; i++) {
-		for (j = 0; j < num_time_samples; j++) {
-			/* Take only the real part. The imaginary part should be zero. */
-			double x = workspace->fs[i][2*j + 0];
-			workspace->temp_ifft[j] += gsl_pow_2(x*num_time_samples);
+		while (workspace->num_time_samples % len != 0) {
+			len++;
 		}
+		CN_workspace_alloc_fs(workspace);
+		workspace->baseband_len = len;
+		workspace->baseband_plan = FFT_plan_get( len, FFT_BACKWARD, FFT_DOUBLE );
+	} else {
+		workspace->baseband_len = 0;
+		workspace->baseband_plan = NULL;
 	}
+}
 
-	/*CN_save("tmp_ifft.dat", s, workspace->temp_ifft);*/
+void CN_workspace_set_precision( coherent_network_workspace_t *workspace, FFT_PRECISION precision ) {
+	assert(workspace != NULL);
 
-	max_index = 0;
-	max_value = workspace->temp_ifft[0];
+	size_t i;
 
-	/* check statistical behavior of this time series */
-	for (i = 1; i < num_time_samples; i++) {
-		double m = workspace->temp_ifft[i];
-		if (m > max_value) {
-			max_value = m;
-			max_index = i;
+	switch (precision) {
+	case FFT_DOUBLE:
+		break;
+	case FFT_SINGLE:
+		if (workspace->filtered_re_single == NULL) {
+			workspace->filtered_re_single = (float**) AR_malloc( workspace->arena, workspace->num_helpers * sizeof(float*) );
+			workspace->filtered_im_single = (float**) AR_malloc( workspace->arena, workspace->num_helpers * sizeof(float*) );
+			workspace->fs_single = (float**) AR_malloc( workspace->arena, 2 * sizeof(float*) );
+
+			for (i = 0; i < workspace->num_helpers; i++) {
+				workspace->filtered_re_single[i] = (float*) AR_malloc( workspace->arena, workspace->sp_lookup->len * sizeof(float) );
+				workspace->filtered_im_single[i] = (float*) AR_malloc( workspace->arena, workspace->sp_lookup->len * sizeof(float) );
+			}
+
+			for (i = 0; i < 2; i++) {
+				workspace->fs_single[i] = (float*) AR_malloc( workspace->arena, 2 * workspace->num_time_samples * sizeof(float) );
+			}
+
+			workspace->ifft_plan_single = FFT_plan_get( workspace->num_time_samples, FFT_BACKWARD, FFT_SINGLE );
 		}
+		break;
+	default:
+		fprintf(stderr, "Error. Invalid FFT_PRECISION (%d). Exiting.\n", precision);
+		exit(-1);
 	}
 
+	workspace->precision = precision;
+
+	/* The float copy of the filtered data may be missing or stale. */
+	workspace->filtered_generation = 0;
+}
+
+const char* CN_precision_id_to_name(FFT_PRECISION precision) {
+	switch (precision) {
+	case FFT_DOUBLE: return "double"; break;
+	case FFT_SINGLE: return "single"; break;
+	default:
+		fprintf(stderr, "Error. Invalid FFT_PRECISION (%d). Can not convert to string. Exiting.\n", precision);
+		exit(-1);
+	}
+}
+
+FFT_PRECISION CN_precision_name_to_id(const char *name) {
+	assert(name != NULL);
+
+	if (strcmp(name, "double") == 0) {
+		return FFT_DOUBLE;
+	} else if (strcmp(name, "single") == 0) {
+		return FFT_SINGLE;
+	} else {
+		fprintf(stderr, "Error. Invalid network statistic precision (%s). Must be 'double' or 'single'. Exiting.\n", name);
+		exit(-1);
+	}
+}
+
+/* Whether filtered_re and filtered_im hold the data of network_strain */
+static int CN_workspace_filtered(const coherent_network_workspace_t *workspace,
+		const network_strain_half_fft_t *network_strain) {
+	return workspace->filtered_generation == network_strain->generation
+			&& workspace->filtered_realization == network_strain->realization;
+}
+
+void CN_workspace_filter_data( coherent_network_workspace_t *workspace, detector_network_t *net,
+		network_strain_half_fft_t *network_strain ) {
+	assert(workspace != NULL);
+	assert(net != NULL);
+	assert(network_strain != NULL);
+	assert(net->num_detectors == workspace->num_helpers);
+
+	size_t i, j;
+	stationary_phase_workspace_t *lookup = workspace->sp_lookup;
+	size_t num_time_samples = workspace->num_time_samples;
+
+#ifdef _OPENMP
+	#pragma omp parallel for private(j) num_threads(workspace->num_threads) if (workspace->num_threads > 1)
+#endif
+	for (i = 0; i < net->num_detectors; i++) {
+		asd_t *asd = net->detector[i]->asd;
+		gsl_complex *data = network_strain->strains[i]->half_fft;
+
+		for (j = 0; j < lookup->len; j++) {
+			size_t k = lookup->f_low_index + j;
+
+			/* One-sided weight: DC and Nyquist appear once in the two-sided spectrum, the rest twice. */
+			double weight = (k == 0 || (SS_has_nyquist_term(num_time_samples) && k == SS_nyquist_array_index(num_time_samples))) ? 1.0 : 2.0;
+			double a = weight * lookup->g_coeff[j] / (workspace->normalization_factors[i] * asd->asd[k]);
+
+			workspace->filtered_re[i][j] = a * GSL_REAL(data[k]);
+			workspace->filtered_im[i][j] = a * GSL_IMAG(data[k]);
+		}
+
+		if (workspace->precision == FFT_SINGLE) {
+			for (j = 0; j < lookup->len; j++) {
+				workspace->filtered_re_single[i][j] = (float) workspace->filtered_re[i][j];
+				workspace->filtered_im_single[i][j] = (float) workspace->filtered_im[i][j];
+			}
+		}
+	}
+
+	workspace->filtered_generation = network_strain->generation;
+	workspace->filtered_realization = network_strain->realization;
+}
+
+void CN_do_work(size_t num_time_samples, size_t f_low_index, size_t f_high_index, gsl_complex *spa, asd_t *asd, gsl_complex *half_fft_data, gsl_complex *temp, gsl_complex *out_c) {
+	assert(spa != NULL);
+	assert(asd != NULL);
+	assert(half_fft_data != NULL);
+	assert(temp != NULL);
+	assert(out_c != NULL);
+
+	size_t k;
+
+	// faster version for (k = f_low_index; k <= f_high_index; k++) {
+	/* temp = conj(spa) * data / asd */
+	CV_conj_mul_interleaved( asd->len, (const double*) spa, (const double*) half_fft_data, (double*) temp );
+	for (k = 0; k < asd->len; k++) {
+		GSL_REAL(temp[k]) /= asd->asd[k];
+		GSL_IMAG(temp[k]) /= asd->asd[k];
+	}
+
+	/* This should extend the array with a flipped conjugated version. */
+	SS_make_two_sided( asd->len, temp, num_time_samples, out_c);
+}
+
+void CN_save(char* filename, size_t len, double* tmp_ifft) {
+	assert(filename != NULL);
+	assert(tmp_ifft != NULL);
+
+	FILE* file;
+	size_t i;
+
+	file = fopen(filename, "w");
+	if (file == NULL) {
+		fprintf(stderr, "Error. CN_save: Unable to open the file (%s) for writing. Exiting.\n", filename);
+		exit(-1);
+	}
+
+	for (i = 0; i < len; i++) {
+		fprintf(file, "%e\n", tmp_ifft[i]);
+	}
+	fclose(file);
+}
+
+/* Fills intrinsic_phasor with exp(i phase) at the geocenter from the template cache, computing it on a miss. */
+static void CN_intrinsic_phasor(inspiral_chirp_time_t *chirp, coherent_network_workspace_t *workspace) {
+	size_t len = workspace->sp_lookup->len;
+	double *re = workspace->intrinsic_phasor;
+	double *im = workspace->intrinsic_phasor + len;
+
+	if (!TC_get(workspace->template_cache, chirp->chirp_time0, chirp->chirp_time1_5, re, im)) {
+		/* The coalescence phase is 0 */
+		SP_compute_phasor(0.0, chirp, workspace->sp_lookup, re, im);
+		TC_put(workspace->template_cache, chirp->chirp_time0, chirp->chirp_time1_5, re, im);
+	}
+}
+
+/* Computes the detector independent part of the template. Called once per chirp. */
+static void CN_intrinsic_template(inspiral_chirp_time_t *chirp, coherent_network_workspace_t *workspace) {
+	/* For reconstruction use the phase as 0 */
+	double inspiral_coalesce_phase = 0.0;
+
+	if (workspace->template_cache != NULL) {
+		size_t j;
+		stationary_phase_workspace_t *lookup = workspace->sp_lookup;
+		gsl_complex *spa = workspace->sp_intrinsic->spa_0 + lookup->f_low_index;
+
+		CN_intrinsic_phasor(chirp, workspace);
+		for (j = 0; j < lookup->len; j++) {
+			GSL_SET_COMPLEX(&spa[j], lookup->g_coeff[j] * workspace->intrinsic_phasor[j],
+					-lookup->g_coeff[j] * workspace->intrinsic_phasor[lookup->len + j]);
+		}
+	} else {
+		SP_compute_intrinsic(inspiral_coalesce_phase, chirp, workspace->sp_lookup, workspace->sp_intrinsic);
+	}
+}
+
+/* Computes the stationary phase template for one detector by time shifting the intrinsic template. */
+static void CN_detector_template(size_t detector_index, coherent_network_workspace_t *workspace) {
+	SP_apply_time_delay(	workspace->sky_geometry->time_delay[detector_index],
+					workspace->normalization_factors[detector_index],
+					workspace->sp_intrinsic,
+					workspace->sp_lookup,
+					workspace->sp);
+}
+
+/* |sum_j z_plus[j] w^j|^2 + |sum_j z_minus[j] w^j|^2 for w = exp(2 pi i t / n), by Horner's rule. */
+static double CN_band_power(const double *z_plus, const double *z_minus, size_t len, size_t t, size_t n) {
+	double theta = 2.0 * M_PI * (double) t / (double) n;
+	double w_re = cos(theta);
+	double w_im = sin(theta);
+	double p_re = 0.0, p_im = 0.0;
+	double m_re = 0.0, m_im = 0.0;
+	size_t j;
+
+	for (j = len; j-- > 0; ) {
+		double re = p_re * w_re - p_im * w_im + z_plus[2*j + 0];
+		double im = p_re * w_im + p_im * w_re + z_plus[2*j + 1];
+		p_re = re;
+		p_im = im;
+
+		re = m_re * w_re - m_im * w_im + z_minus[2*j + 0];
+		im = m_re * w_im + m_im * w_re + z_minus[2*j + 1];
+		m_re = re;
+		m_im = im;
+	}
+
+	return p_re * p_re + p_im * p_im + m_re * m_re + m_im * m_im;
+}
+
+/* Reduced-rate form of CN_one_sided_statistic, see baseband_len. Moving the band down to DC only changes the
+ * phase of the two IFFTs, not their modulus. Only the coarse samples and the refined ones around the coarse
+ * peak are written to temp_ifft, and the search is narrowed to the refined samples.
+ */
+static void CN_baseband_statistic( double *z_plus, double *z_minus, coherent_network_workspace_t *workspace ) {
+	size_t r, m, t;
+	size_t num_time_samples = workspace->num_time_samples;
+	size_t k_low = workspace->sp_lookup->f_low_index;
+	size_t len = workspace->sp_lookup->len;
+	size_t baseband_len = workspace->baseband_len;
+	size_t stride = num_time_samples / baseband_len;
+	double *y_plus = workspace->fs[2];
+	double *y_minus = workspace->fs[3];
+	double *y[2] = { y_plus, y_minus };
+	size_t peak = 0;
+
+	memcpy( y_plus, z_plus + 2*k_low, 2 * len * sizeof(double) );
+	memcpy( y_minus, z_minus + 2*k_low, 2 * len * sizeof(double) );
+	memset( y_plus + 2*len, 0, 2 * (baseband_len - len) * sizeof(double) );
+	memset( y_minus + 2*len, 0, 2 * (baseband_len - len) * sizeof(double) );
+
+#ifdef _OPENMP
+	#pragma omp parallel for num_threads(GSL_MIN(workspace->num_threads, 2)) if (workspace->num_threads > 1)
+#endif
+	for (t = 0; t < 2; t++) {
+		FFT_execute( workspace->baseband_plan, y[t], CN_thread_fft_workspace(workspace) );
+	}
+
+	for (r = 0; r < baseband_len; r++) {
+		double x = gsl_pow_2(y_plus[2*r + 0]) + gsl_pow_2(y_plus[2*r + 1])
+				+ gsl_pow_2(y_minus[2*r + 0]) + gsl_pow_2(y_minus[2*r + 1]);
+		workspace->temp_ifft[r * stride] = x;
+		if (x > workspace->temp_ifft[peak * stride]) {
+			peak = r;
+		}
+	}
+
+	/* Full rate between the coarse neighbours of the peak */
+	workspace->search_start = (peak * stride + num_time_samples - (stride - 1)) % num_time_samples;
+	workspace->search_count = 2 * stride - 1;
+
+#ifdef _OPENMP
+	#pragma omp parallel for num_threads(workspace->num_threads) if (workspace->num_threads > 1)
+#endif
+	for (m = 0; m < workspace->search_count; m++) {
+		size_t t = (workspace->search_start + m) % num_time_samples;
+		if (t % stride != 0) {
+			workspace->temp_ifft[t] = CN_band_power( z_plus + 2*k_low, z_minus + 2*k_low, len, t, num_time_samples );
+		}
+	}
+}
+
+/* temp_ifft = |z_plus|^2 + |z_minus|^2 over the whole series, once both are inverse transformed */
+static void CN_one_sided_power( const double *z_plus, const double *z_minus, coherent_network_workspace_t *workspace ) {
+	size_t t;
+
+	/* One contiguous chunk per thread */
+#ifdef _OPENMP
+	#pragma omp parallel for num_threads(workspace->num_threads) if (workspace->num_threads > 1)
+#endif
+	for (t = 0; t < workspace->num_threads; t++) {
+		size_t begin = t * workspace->num_time_samples / workspace->num_threads;
+		size_t end = (t + 1) * workspace->num_time_samples / workspace->num_threads;
+		CPU_abs2_pair( end - begin, z_plus + 2*begin, z_minus + 2*begin, workspace->temp_ifft + begin );
+	}
+}
+
+/* temp_ifft = |IFFT(z_plus)|^2 + |IFFT(z_minus)|^2, over the whole series, just the tc window or at a reduced
+ * rate. Both spectra are overwritten in the first case.
+ */
+static void CN_one_sided_statistic( double *z_plus, double *z_minus, coherent_network_workspace_t *workspace ) {
+	size_t t;
+	double *z[2] = { z_plus, z_minus };
+
+	if (workspace->tc_window_plan == NULL && workspace->baseband_len > 0) {
+		CN_baseband_statistic( z_plus, z_minus, workspace );
+	} else if (workspace->tc_window_plan == NULL) {
+#ifdef _OPENMP
+		#pragma omp parallel for num_threads(GSL_MIN(workspace->num_threads, 2)) if (workspace->num_threads > 1)
+#endif
+		for (t = 0; t < 2; t++) {
+			FFT_execute( workspace->ifft_plan, z[t], CN_thread_fft_workspace(workspace) );
+		}
+
+		CN_one_sided_power( z_plus, z_minus, workspace );
+	} else {
+		size_t count = workspace->tc_window_count;
+		double *y_plus = workspace->tc_window_z;
+		double *y_minus = workspace->tc_window_z + 2 * count;
+		double *out = workspace->temp_ifft + workspace->tc_window_start;
+		double *y[2] = { y_plus, y_minus };
+
+		/* fs[2] and fs[3] are not used by the one-sided and fused engines. */
+#ifdef _OPENMP
+		#pragma omp parallel for num_threads(GSL_MIN(workspace->num_threads, 2)) if (workspace->num_threads > 1)
+#endif
+		for (t = 0; t < 2; t++) {
+			FFT_execute_pruned( workspace->tc_window_plan, z[t], y[t], workspace->fs[2 + t], CN_thread_fft_workspace(workspace) );
+		}
+
+		CPU_abs2_pair( count, y_plus, y_minus, out );
+	}
+}
+
+/* Original formulation: builds the four two-sided spectra (c_plus and c_minus weighted by w_plus and w_minus)
+ * and takes four complex inverse FFTs of length num_time_samples.
+ */
+static void CN_two_sided_ifft(
+		detector_network_t* net,
+		inspiral_chirp_time_t *chirp,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace)
+{
+	size_t i, j;
+	size_t tid;
+	size_t did;
+	size_t fid;
+	size_t num_time_samples = workspace->num_time_samples;
+
+	CN_workspace_alloc_legacy(workspace);
+	CN_intrinsic_template(chirp, workspace);
+
+	/* Loop over each detector to generate a template and do matched filtering */
+	for (i = 0; i < net->num_detectors; i++) {
+		detector_t* det = net->detector[i];
+		gsl_complex* whitened_data = network_strain->strains[i]->half_fft;
+
+		CN_detector_template(i, workspace);
+
+		/* compute c_plus */
+		CN_do_work(num_time_samples, workspace->sp_lookup->f_low_index, workspace->sp_lookup->f_high_index, workspace->sp->spa_0, det->asd, whitened_data, workspace->temp_array, workspace->helpers[i]->c_plus);
+
+		/* compute c_minus. With spa_90 = -i * spa_0 it is i * c_plus on the one-sided bins and -i * c_plus
+		 * on their mirror. */
+		{
+			gsl_complex *c_plus = workspace->helpers[i]->c_plus;
+			gsl_complex *c_minus = workspace->helpers[i]->c_minus;
+			size_t one_sided_len = det->asd->len;
+
+			for (j = 0; j < num_time_samples; j++) {
+				if (j < one_sided_len) {
+					GSL_SET_COMPLEX(&c_minus[j], -GSL_IMAG(c_plus[j]), GSL_REAL(c_plus[j]));
+				} else {
+					GSL_SET_COMPLEX(&c_minus[j], GSL_IMAG(c_plus[j]), -GSL_REAL(c_plus[j]));
+				}
+			}
+		}
+	}
+
+	/* zero the memory */
+	for (tid = 0; tid < 4; tid++) {
+		memset( workspace->terms[tid], 0, num_time_samples * sizeof(gsl_complex) );
+		memset( workspace->fs[tid], 0, num_time_samples * sizeof(gsl_complex) );
+	}
+
+	/* Each bin sums the detectors in order, so the result does not depend on the number of threads. */
+#ifdef _OPENMP
+	#pragma omp parallel for private(did) num_threads(workspace->num_threads) if (workspace->num_threads > 1)
+#endif
+	for (fid = 0; fid < num_time_samples; fid++) {
+		for (did = 0; did < net->num_detectors; did++) {
+			gsl_complex t;
+
+			t = gsl_complex_mul_real(workspace->helpers[did]->c_plus[fid], workspace->helpers[did]->w_plus_input);
+			workspace->terms[0][fid] = gsl_complex_add( workspace->terms[0][fid], t);
+
+			t = gsl_complex_mul_real(workspace->helpers[did]->c_plus[fid], workspace->helpers[did]->w_minus_input);
+			workspace->terms[1][fid] = gsl_complex_add( workspace->terms[1][fid], t);
+
+			t = gsl_complex_mul_real(workspace->helpers[did]->c_minus[fid], workspace->helpers[did]->w_plus_input);
+			workspace->terms[2][fid] = gsl_complex_add( workspace->terms[2][fid], t);
+
+			t = gsl_complex_mul_real(workspace->helpers[did]->c_minus[fid], workspace->helpers[did]->w_minus_input);
+			workspace->terms[3][fid] = gsl_complex_add( workspace->terms[3][fid], t);
+		}
+	}
+
+#ifdef _OPENMP
+	#pragma omp parallel for private(j) num_threads(GSL_MIN(workspace->num_threads, 4)) if (workspace->num_threads > 1)
+#endif
+	for (i = 0; i < 4; i++) {
+		for (j = 0; j < num_time_samples; j++) {
+			workspace->fs[i][2*j + 0] = GSL_REAL( workspace->terms[i][j] );
+			workspace->fs[i][2*j + 1] = GSL_IMAG( workspace->terms[i][j] );
+		}
+		FFT_execute( workspace->ifft_plan, workspace->fs[i], CN_thread_fft_workspace(workspace) );
+	}
+
+	/* The backward transform is unnormalized, which is the N * ifft of the Matlab code. */
+#ifdef _OPENMP
+	#pragma omp parallel for private(i) num_threads(workspace->num_threads) if (workspace->num_threads > 1)
+#endif
+	for (j = 0; j < num_time_samples; j++) {
+		workspace->temp_ifft[j] = 0.0;
+		for (i = 0; i < 4; i++) {
+			/* Take only the real part. The imaginary part should be zero. */
+			double x = workspace->fs[i][2*j + 0];
+			workspace->temp_ifft[j] += gsl_pow_2(x);
+		}
+	}
+}
+
+/* Analytic signal formulation.
+ *
+ * The two-sided spectra are Hermitian, so the real part of their IFFT is the real part of the IFFT of the
+ * one-sided spectrum with every bin except DC and Nyquist doubled. Since spa_90 = -i * spa_0, the c_minus
+ * spectrum is i * c_plus on the one-sided bins, so the c_minus terms are minus the imaginary parts of the
+ * same IFFTs. Two one-sided IFFTs (weighted by w_plus and w_minus) therefore give all four terms.
+ */
+static void CN_one_sided_ifft(
+		detector_network_t* net,
+		inspiral_chirp_time_t *chirp,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace)
+{
+	size_t i, k;
+	size_t num_time_samples = workspace->num_time_samples;
+	double *z_plus = workspace->fs[0];
+	double *z_minus = workspace->fs[1];
+
+	memset( z_plus, 0, num_time_samples * sizeof(gsl_complex) );
+	memset( z_minus, 0, num_time_samples * sizeof(gsl_complex) );
+
+	CN_workspace_alloc_legacy(workspace);
+	CN_intrinsic_template(chirp, workspace);
+
+	for (i = 0; i < net->num_detectors; i++) {
+		detector_t* det = net->detector[i];
+		gsl_complex* whitened_data = network_strain->strains[i]->half_fft;
+		size_t len = det->asd->len;
+		double w_plus = workspace->helpers[i]->w_plus_input;
+		double w_minus = workspace->helpers[i]->w_minus_input;
+
+		/* The last one-sided bin is the Nyquist term when the number of samples is even. */
+		size_t last_doubled = SS_has_nyquist_term(num_time_samples) ? len - 2 : len - 1;
+
+		CN_detector_template(i, workspace);
+
+		/* c = conj(spa_0) * data / asd */
+		CV_conj_mul_interleaved( len, (const double*) workspace->sp->spa_0, (const double*) whitened_data,
+				(double*) workspace->temp_array );
+
+		for (k = 0; k < len; k++) {
+			double weight = (k == 0 || k > last_doubled) ? 1.0 : 2.0;
+			double a = weight / det->asd->asd[k];
+			double c_re = a * GSL_REAL(workspace->temp_array[k]);
+			double c_im = a * GSL_IMAG(workspace->temp_array[k]);
+
+			z_plus[2*k + 0] += w_plus * c_re;
+			z_plus[2*k + 1] += w_plus * c_im;
+			z_minus[2*k + 0] += w_minus * c_re;
+			z_minus[2*k + 1] += w_minus * c_im;
+		}
+	}
+
+	CN_one_sided_statistic( z_plus, z_minus, workspace );
+}
+
+/* Fused form of CN_one_sided_ifft. Only the in-band bins are visited, and for each block of bins the template
+ * phase of every detector is applied to the prefiltered data and summed straight into the two weighted spectra.
+ * conj(spa_0) = g / normalization * exp(+i phase), so the template itself is never stored.
+ */
+static void CN_fused_ifft(
+		detector_network_t* net,
+		inspiral_chirp_time_t *chirp,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace)
+{
+	size_t i, j0;
+	size_t num_time_samples = workspace->num_time_samples;
+	size_t num_detectors = net->num_detectors;
+	stationary_phase_workspace_t *lookup = workspace->sp_lookup;
+	size_t k_low = lookup->f_low_index;
+	size_t len = lookup->len;
+	double *z_plus = workspace->fs[0];
+	double *z_minus = workspace->fs[1];
+	int fixed = CN_fixed_supported(num_detectors);
+	double w_plus[CN_FIXED_MAX_DETECTORS];
+	double w_minus[CN_FIXED_MAX_DETECTORS];
+
+	if (!CN_workspace_filtered(workspace, network_strain)) {
+		CN_workspace_filter_data(workspace, net, network_strain);
+	}
+
+	if (workspace->template_cache != NULL) {
+		CN_intrinsic_phasor(chirp, workspace);
+	}
+
+	if (fixed) {
+		for (i = 0; i < num_detectors; i++) {
+			w_plus[i] = workspace->helpers[i]->w_plus_input;
+			w_minus[i] = workspace->helpers[i]->w_minus_input;
+		}
+	}
+
+	/* Out of band bins are zero */
+	memset( z_plus, 0, 2 * k_low * sizeof(double) );
+	memset( z_minus, 0, 2 * k_low * sizeof(double) );
+	memset( z_plus + 2*(k_low + len), 0, 2 * (num_time_samples - k_low - len) * sizeof(double) );
+	memset( z_minus + 2*(k_low + len), 0, 2 * (num_time_samples - k_low - len) * sizeof(double) );
+
+	/* Work through the band in blocks small enough for the scratch arrays to stay in the L1 cache. The blocks
+	 * are independent, and with several threads each one has its own scratch arrays.
+	 */
+#ifdef _OPENMP
+	#pragma omp parallel for private(i) num_threads(workspace->num_threads) if (workspace->num_threads > 1)
+#endif
+	for (j0 = 0; j0 < len; j0 += CN_FUSED_BLOCK) {
+		size_t n = GSL_MIN(CN_FUSED_BLOCK, len - j0);
+
+		double *phase = workspace->fused_scratch + CN_thread_num() * CN_FUSED_NUM_SCRATCH * CN_FUSED_BLOCK;
+		double *g_re = phase + CN_FUSED_BLOCK;
+		double *g_im = g_re + CN_FUSED_BLOCK;
+		double *r_re = g_im + CN_FUSED_BLOCK;
+		double *r_im = r_re + CN_FUSED_BLOCK;
+		double *e_re = r_im + CN_FUSED_BLOCK;
+		double *e_im = e_re + CN_FUSED_BLOCK;
+		double *c_re = e_im + CN_FUSED_BLOCK;
+		double *c_im = c_re + CN_FUSED_BLOCK;
+		double *zp_re = c_im + CN_FUSED_BLOCK;
+		double *zp_im = zp_re + CN_FUSED_BLOCK;
+		double *zm_re = zp_im + CN_FUSED_BLOCK;
+		double *zm_im = zm_re + CN_FUSED_BLOCK;
+
+		if (workspace->template_cache != NULL) {
+			memcpy( g_re, workspace->intrinsic_phasor + j0, n * sizeof(double) );
+			memcpy( g_im, workspace->intrinsic_phasor + len + j0, n * sizeof(double) );
+		} else {
+			/* Phase at the geocenter. The coalescence phase is 0. */
+			SP_phase( lookup, chirp, 0.0, 0.0, j0, n, phase );
+
+			/* The trig of the template phase is done once per chirp, not once per detector. */
+			CPU_sincos( n, phase, g_re, g_im );
+		}
+
+		/* A network of 2 to CN_FIXED_MAX_DETECTORS detectors has a specialized kernel, which takes the ramps of
+		   all the detectors in the scratch arrays after g. */
+		if (fixed) {
+			for (i = 0; i < num_detectors; i++) {
+				SP_time_delay_ramp( lookup, j0, n, -workspace->sky_geometry->time_delay[i],
+						r_re + 2 * i * CN_FUSED_BLOCK, r_im + 2 * i * CN_FUSED_BLOCK );
+			}
+			CN_fixed_fused_block( num_detectors, n, g_re, g_im, r_re, r_im, 2 * CN_FUSED_BLOCK,
+					workspace->filtered_re, workspace->filtered_im, j0, w_plus, w_minus,
+					z_plus + 2*(k_low + j0), z_minus + 2*(k_low + j0) );
+			continue;
+		}
+
+		memset( zp_re, 0, n * sizeof(double) );
+		memset( zp_im, 0, n * sizeof(double) );
+		memset( zm_re, 0, n * sizeof(double) );
+		memset( zm_im, 0, n * sizeof(double) );
+
+		for (i = 0; i < num_detectors; i++) {
+			/* Detector phase = phase - 2 pi f time_delay */
+			SP_time_delay_ramp( lookup, j0, n, -workspace->sky_geometry->time_delay[i], r_re, r_im );
+			CV_mul( n, g_re, g_im, r_re, r_im, e_re, e_im );
+
+			/* c = filtered data * exp(i detector phase) */
+			CV_mul( n, workspace->filtered_re[i] + j0, workspace->filtered_im[i] + j0, e_re, e_im, c_re, c_im );
+
+			CV_axpy( n, workspace->helpers[i]->w_plus_input, c_re, c_im, zp_re, zp_im );
+			CV_axpy( n, workspace->helpers[i]->w_minus_input, c_re, c_im, zm_re, zm_im );
+		}
+
+		CV_interleave( n, zp_re, zp_im, z_plus + 2*(k_low + j0) );
+		CV_interleave( n, zm_re, zm_im, z_minus + 2*(k_low + j0) );
+	}
+
+	CN_one_sided_statistic( z_plus, z_minus, workspace );
+}
+
+/* Single precision form of CN_fused_ifft. The phases are large (tc times 2 pi f), so they are formed and
+ * reduced to [-pi, pi] in double before the float trig, and the time delay ramp is made in double.
+ * Everything after that, up to and including the IFFT, is in float. The detectors are summed in float,
+ * and |z|^2 in double. There is no pruned or reduced-rate float IFFT, so the whole series is transformed even
+ * when a tc window is set (only the window is searched), and the baseband setting is not used.
+ */
+static void CN_fused_ifft_single(
+		detector_network_t* net,
+		inspiral_chirp_time_t *chirp,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace)
+{
+	size_t i, j, j0;
+	size_t num_time_samples = workspace->num_time_samples;
+	size_t num_detectors = net->num_detectors;
+	stationary_phase_workspace_t *lookup = workspace->sp_lookup;
+	size_t k_low = lookup->f_low_index;
+	size_t len = lookup->len;
+	float *z_plus = workspace->fs_single[0];
+	float *z_minus = workspace->fs_single[1];
+	float *z[2] = { z_plus, z_minus };
+	size_t t;
+	int fixed = CN_fixed_supported(num_detectors);
+	float w_plus[CN_FIXED_MAX_DETECTORS];
+	float w_minus[CN_FIXED_MAX_DETECTORS];
+
+	if (!CN_workspace_filtered(workspace, network_strain)) {
+		CN_workspace_filter_data(workspace, net, network_strain);
+	}
+
+	if (workspace->template_cache != NULL) {
+		CN_intrinsic_phasor(chirp, workspace);
+	}
+
+	if (fixed) {
+		for (i = 0; i < num_detectors; i++) {
+			w_plus[i] = (float) workspace->helpers[i]->w_plus_input;
+			w_minus[i] = (float) workspace->helpers[i]->w_minus_input;
+		}
+	}
+
+	/* Out of band bins are zero */
+	memset( z_plus, 0, 2 * k_low * sizeof(float) );
+	memset( z_minus, 0, 2 * k_low * sizeof(float) );
+	memset( z_plus + 2*(k_low + len), 0, 2 * (num_time_samples - k_low - len) * sizeof(float) );
+	memset( z_minus + 2*(k_low + len), 0, 2 * (num_time_samples - k_low - len) * sizeof(float) );
+
+	/* As in CN_fused_ifft, each thread has its own scratch arrays. */
+#ifdef _OPENMP
+	#pragma omp parallel for private(i, j) num_threads(workspace->num_threads) if (workspace->num_threads > 1)
+#endif
+	for (j0 = 0; j0 < len; j0 += CN_FUSED_BLOCK) {
+		size_t n = GSL_MIN(CN_FUSED_BLOCK, len - j0);
+
+		/* The phase, g in float, the time delay ramp and then the float sums. The specialized kernel uses the
+		 * blocks from r_re on for the ramps of all the detectors instead. */
+		double *phase = workspace->fused_scratch + CN_thread_num() * CN_FUSED_NUM_SCRATCH * CN_FUSED_BLOCK;
+		float *g_re = (float*) (phase + CN_FUSED_BLOCK);
+		float *g_im = g_re + CN_FUSED_BLOCK;
+		double *r_re = (double*) (g_im + CN_FUSED_BLOCK);
+		double *r_im = r_re + CN_FUSED_BLOCK;
+		float *zp_re = (float*) (r_im + CN_FUSED_BLOCK);
+		float *zp_im = zp_re + CN_FUSED_BLOCK;
+		float *zm_re = zp_im + CN_FUSED_BLOCK;
+		float *zm_im = zm_re + CN_FUSED_BLOCK;
+
+		if (workspace->template_cache != NULL) {
+			for (j = 0; j < n; j++) {
+				g_re[j] = (float) workspace->intrinsic_phasor[j0 + j];
+				g_im[j] = (float) workspace->intrinsic_phasor[len + j0 + j];
+			}
+		} else {
+			/* Phase at the geocenter. The coalescence phase is 0. */
+			SP_phase( lookup, chirp, 0.0, 0.0, j0, n, phase );
+
+			for (j = 0; j < n; j++) {
+				float r = (float) (phase[j] - 2.0 * M_PI * floor(phase[j] / (2.0 * M_PI) + 0.5));
+				g_re[j] = cosf(r);
+				g_im[j] = sinf(r);
+			}
+		}
+
+		if (fixed) {
+			for (i = 0; i < num_detectors; i++) {
+				SP_time_delay_ramp( lookup, j0, n, -workspace->sky_geometry->time_delay[i],
+						r_re + 2 * i * CN_FUSED_BLOCK, r_im + 2 * i * CN_FUSED_BLOCK );
+			}
+			CN_fixed_fused_block_single( num_detectors, n, g_re, g_im, r_re, r_im, 2 * CN_FUSED_BLOCK,
+					workspace->filtered_re_single, workspace->filtered_im_single, j0, w_plus, w_minus,
+					z_plus + 2*(k_low + j0), z_minus + 2*(k_low + j0) );
+			continue;
+		}
+
+		memset( zp_re, 0, n * sizeof(float) );
+		memset( zp_im, 0, n * sizeof(float) );
+		memset( zm_re, 0, n * sizeof(float) );
+		memset( zm_im, 0, n * sizeof(float) );
+
+		for (i = 0; i < num_detectors; i++) {
+			float w_plus = (float) workspace->helpers[i]->w_plus_input;
+			float w_minus = (float) workspace->helpers[i]->w_minus_input;
+			const float *d_re = workspace->filtered_re_single[i] + j0;
+			const float *d_im = workspace->filtered_im_single[i] + j0;
+
+			/* Detector phase = phase - 2 pi f time_delay */
+			SP_time_delay_ramp( lookup, j0, n, -workspace->sky_geometry->time_delay[i], r_re, r_im );
+
+			/* c = filtered data * exp(i detector phase) */
+			for (j = 0; j < n; j++) {
+				float e_re = g_re[j] * (float) r_re[j] - g_im[j] * (float) r_im[j];
+				float e_im = g_re[j] * (float) r_im[j] + g_im[j] * (float) r_re[j];
+				float c_re = d_re[j] * e_re - d_im[j] * e_im;
+				float c_im = d_re[j] * e_im + d_im[j] * e_re;
+
+				zp_re[j] += w_plus * c_re;
+				zp_im[j] += w_plus * c_im;
+				zm_re[j] += w_minus * c_re;
+				zm_im[j] += w_minus * c_im;
+			}
+		}
+
+		for (j = 0; j < n; j++) {
+			z_plus[2*(k_low + j0 + j) + 0] = zp_re[j];
+			z_plus[2*(k_low + j0 + j) + 1] = zp_im[j];
+			z_minus[2*(k_low + j0 + j) + 0] = zm_re[j];
+			z_minus[2*(k_low + j0 + j) + 1] = zm_im[j];
+		}
+	}
+
+#ifdef _OPENMP
+	#pragma omp parallel for num_threads(GSL_MIN(workspace->num_threads, 2)) if (workspace->num_threads > 1)
+#endif
+	for (t = 0; t < 2; t++) {
+		FFT_execute_float( workspace->ifft_plan_single, z[t], CN_thread_fft_workspace(workspace) );
+	}
+
+#ifdef _OPENMP
+	#pragma omp parallel for num_threads(workspace->num_threads) if (workspace->num_threads > 1)
+#endif
+	for (j = 0; j < num_time_samples; j++) {
+		workspace->temp_ifft[j] = gsl_pow_2((double) z_plus[2*j + 0]) + gsl_pow_2((double) z_plus[2*j + 1])
+				+ gsl_pow_2((double) z_minus[2*j + 0]) + gsl_pow_2((double) z_minus[2*j + 1]);
+	}
+}
+
+/* Largest x[t] for the count samples t from start on, wrapping around at n */
+static double CN_max_wrapped(const double *x, size_t n, size_t start, size_t count) {
+	size_t first = GSL_MIN(count, n - start);
+	double max_value = CPU_max(first, x + start);
+
+	if (count > first) {
+		max_value = GSL_MAX(max_value, CPU_max(count - first, x));
+	}
+	return max_value;
+}
+
+/* sqrt(max temp_ifft / 2) over the searched samples */
+static double CN_peak_snr(coherent_network_workspace_t *workspace) {
+	size_t t;
+	size_t num_threads = GSL_MIN(workspace->num_threads, workspace->search_count);
+	double max_value = workspace->temp_ifft[workspace->search_start];
+
+	/* One contiguous chunk of the searched samples per thread */
+#ifdef _OPENMP
+	#pragma omp parallel for reduction(max:max_value) num_threads(num_threads) if (num_threads > 1)
+#endif
+	for (t = 0; t < num_threads; t++) {
+		size_t begin = t * workspace->search_count / num_threads;
+		size_t end = (t + 1) * workspace->search_count / num_threads;
+		double m = CN_max_wrapped( workspace->temp_ifft, workspace->num_time_samples,
+				(workspace->search_start + begin) % workspace->num_time_samples, end - begin );
+		if (m > max_value) {
+			max_value = m;
+		}
+	}
+
+	return sqrt(max_value) / sqrt(2.0);
+}
+
+/* Antenna patterns, time delays and the network weights w_plus and w_minus of every detector. */
+static void CN_sky_weights(detector_network_t* net, sky_t *sky, coherent_network_workspace_t *workspace) {
+	size_t i;
+	sky_geometry_t *g = workspace->sky_geometry;
+
+	/* The matrix O orthonormalizes the network vectors u and v */
+	if (workspace->sky_table != NULL) {
+		SG_table_lookup(workspace->sky_table, sky, g);
+	} else {
+		SG_compute(g, sky);
+	}
+
+	/* Each detector contributes to the network terms with these weights. */
+	for (i = 0; i < net->num_detectors; i++) {
+		workspace->helpers[i]->w_plus_input = (g->o11 * g->u[i] + g->o12 * g->v[i]);
+		workspace->helpers[i]->w_minus_input = (g->o21 * g->u[i] + g->o22 * g->v[i]);
+	}
+}
+
+void CN_sky_series_compute(
+		detector_network_t* net,
+		inspiral_chirp_time_t *chirp,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace)
+{
+	assert(net);
+	assert(chirp);
+	assert(network_strain);
+	assert(workspace);
+
+	size_t i, j;
+	size_t len = workspace->sp_lookup->len;
+	size_t center = len / 2;
+	double *re, *im;
+
+	if (workspace->sky_series == NULL) {
+		size_t n = 1;
+		while (n < CN_SKY_OVERSAMPLE * len) {
+			n *= 2;
+		}
+		workspace->sky_series_len = n;
+		workspace->sky_series_center = center;
+		workspace->sky_series_plan = FFT_plan_get( n, FFT_BACKWARD, FFT_DOUBLE );
+		workspace->sky_series_fft_workspace = FFT_workspace_alloc( n );
+
+		workspace->sky_series = (double**) AR_malloc( workspace->arena, workspace->num_helpers * sizeof(double*) );
+		for (i = 0; i < workspace->num_helpers; i++) {
+			workspace->sky_series[i] = (double*) AR_malloc( workspace->arena, 2 * (n + 3) * sizeof(double) );
+		}
+	}
+
+	if (workspace->intrinsic_phasor == NULL) {
+		workspace->intrinsic_phasor = (double*) AR_malloc( workspace->arena, 2 * len * sizeof(double) );
+	}
+
+	if (!CN_workspace_filtered(workspace, network_strain)) {
+		CN_workspace_filter_data(workspace, net, network_strain);
+	}
+
+	/* exp(i phase) at the geocenter. The coalescence phase is 0. */
+	re = workspace->intrinsic_phasor;
+	im = workspace->intrinsic_phasor + len;
+	if (workspace->template_cache != NULL) {
+		CN_intrinsic_phasor(chirp, workspace);
+	} else {
+		SP_compute_phasor(0.0, chirp, workspace->sp_lookup, re, im);
+	}
+
+	for (i = 0; i < net->num_detectors; i++) {
+		size_t n = workspace->sky_series_len;
+		double *x = workspace->sky_series[i] + 2;
+
+		/* Band bin j goes to bin j - center, modulo n */
+		memset( x, 0, 2 * n * sizeof(double) );
+		for (j = 0; j < len; j++) {
+			size_t m = (j + n - center) % n;
+			double d_re = workspace->filtered_re[i][j];
+			double d_im = workspace->filtered_im[i][j];
+
+			x[2*m + 0] = d_re * re[j] - d_im * im[j];
+			x[2*m + 1] = d_re * im[j] + d_im * re[j];
+		}
+
+		FFT_execute( workspace->sky_series_plan, x, workspace->sky_series_fft_workspace );
+
+		/* Wrap around samples for the interpolation */
+		x[-2] = x[2*(n-1) + 0];
+		x[-1] = x[2*(n-1) + 1];
+		memcpy( x + 2*n, x, 4 * sizeof(double) );
+	}
+}
+
+void CN_sky_series_statistic(
+		detector_network_t* net,
+		size_t num_sky,
+		sky_t *sky,
+		coherent_network_workspace_t *workspace,
+		double *out_network_snr)
+{
+	assert(net);
+	assert(sky);
+	assert(workspace);
+	assert(workspace->sky_series != NULL);
+	assert(out_network_snr);
+
+	size_t s, i, j, m0;
+	size_t num_time_samples = workspace->num_time_samples;
+	size_t n = workspace->sky_series_len;
+	double ratio = (double) n / (double) num_time_samples;
+	asd_t *asd = net->detector[0]->asd;
+	double sampling_frequency = num_time_samples * (asd->f[1] - asd->f[0]);
+	double center = (double) (workspace->sp_lookup->f_low_index + workspace->sky_series_center);
+
+	size_t search_start = workspace->tc_window_start;
+	size_t search_count = (workspace->tc_window_count > 0) ? workspace->tc_window_count : num_time_samples;
+
+	double *zp_re = workspace->fused_scratch;
+	double *zp_im = zp_re + CN_FUSED_BLOCK;
+	double *zm_re = zp_im + CN_FUSED_BLOCK;
+	double *zm_im = zm_re + CN_FUSED_BLOCK;
+	double *b_re = zm_im + CN_FUSED_BLOCK;
+	double *b_im = b_re + CN_FUSED_BLOCK;
+
+	for (s = 0; s < num_sky; s++) {
+		double max_value = 0.0;
+
+		CN_sky_weights(net, &sky[s], workspace);
+
+		for (m0 = 0; m0 < search_count; m0 += CN_FUSED_BLOCK) {
+			size_t count = GSL_MIN(CN_FUSED_BLOCK, search_count - m0);
+
+			memset( zp_re, 0, count * sizeof(double) );
+			memset( zp_im, 0, count * sizeof(double) );
+			memset( zm_re, 0, count * sizeof(double) );
+			memset( zm_im, 0, count * sizeof(double) );
+
+			for (i = 0; i < net->num_detectors; i++) {
+				const double *x = workspace->sky_series[i] + 2;
+				double delay = workspace->sky_geometry->time_delay[i] * sampling_frequency;
+
+				/* x_i(t - delay) = exp(2 pi i center (t - delay) / N) b_i((t - delay) n / N). The common factor
+				 * exp(2 pi i center t / N) drops out of |z|^2, the rest goes into the weights.
+				 */
+				double shift = -2.0 * M_PI * center * delay / num_time_samples;
+				double a_re = cos(shift);
+				double a_im = sin(shift);
+				double wp = workspace->helpers[i]->w_plus_input;
+				double wm = workspace->helpers[i]->w_minus_input;
+				double offset = fmod( -delay * ratio, (double) n ) + n;
+
+				for (j = 0; j < count; j++) {
+					size_t t = (search_start + m0 + j) % num_time_samples;
+					double p = t * ratio + offset;
+					double p0 = floor(p);
+					double f = p - p0;
+					size_t k = ((size_t) p0) % n;
+
+					/* Cubic Lagrange interpolation through samples k - 1 .. k + 2 */
+					double c0 = -f * (f - 1.0) * (f - 2.0) / 6.0;
+					double c1 = (f + 1.0) * (f - 1.0) * (f - 2.0) / 2.0;
+					double c2 = -(f + 1.0) * f * (f - 2.0) / 2.0;
+					double c3 = (f + 1.0) * f * (f - 1.0) / 6.0;
+					const double *y = x + 2*k - 2;
+
+					b_re[j] = c0 * y[0] + c1 * y[2] + c2 * y[4] + c3 * y[6];
+					b_im[j] = c0 * y[1] + c1 * y[3] + c2 * y[5] + c3 * y[7];
+				}
+
+				CV_scale( count, a_re, a_im, b_re, b_im );
+				CV_axpy( count, wp, b_re, b_im, zp_re, zp_im );
+				CV_axpy( count, wm, b_re, b_im, zm_re, zm_im );
+			}
+
+			for (j = 0; j < count; j++) {
+				double x = zp_re[j] * zp_re[j] + zp_im[j] * zp_im[j] + zm_re[j] * zm_re[j] + zm_im[j] * zm_im[j];
+				if (x > max_value) {
+					max_value = x;
+				}
+			}
+		}
+
+		out_network_snr[s] = sqrt(max_value) / sqrt(2.0);
+	}
+}
+
+/* DANGER. This assumes that the coalece phase is 0 */
+void coherent_network_statistic(
+		detector_network_t* net,
+		double f_low,
+		double f_high,
+		inspiral_chirp_time_t *chirp,
+		sky_t *sky,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace,
+		double *out_network_snr,
+		char *hdf5_filename)
+{
+	assert(net);
+	assert(chirp);
+	assert(sky);
+	assert(network_strain);
+	assert(workspace);
+	assert(out_network_snr);
+
+	size_t i;
+
+	/* WARNING: This assumes that all of the signals have the same lengths. */
+	size_t num_time_samples = network_strain->num_time_samples;
+
+	CN_sky_weights(net, sky, workspace);
+
+	if (workspace->precision == FFT_SINGLE && workspace->engine != CN_ENGINE_FUSED) {
+		fprintf(stderr, "Error. Single precision is only implemented for the fused network statistic engine. Exiting.\n");
+		exit(-1);
+	}
+
+	/* Only the tc window, if one is set. The baseband evaluation narrows this further. */
+	workspace->search_start = workspace->tc_window_start;
+	workspace->search_count = (workspace->tc_window_count > 0) ? workspace->tc_window_count : num_time_samples;
+
+	switch (workspace->engine) {
+	case CN_ENGINE_TWO_SIDED:
+		CN_two_sided_ifft(net, chirp, network_strain, workspace);
+		break;
+	case CN_ENGINE_ONE_SIDED:
+		CN_one_sided_ifft(net, chirp, network_strain, workspace);
+		break;
+	case CN_ENGINE_FUSED:
+		if (workspace->precision == FFT_SINGLE) {
+			CN_fused_ifft_single(net, chirp, network_strain, workspace);
+		} else {
+			CN_fused_ifft(net, chirp, network_strain, workspace);
+		}
+		break;
+	default:
+		fprintf(stderr, "Error. Invalid CN_ENGINE (%d). Exiting.\n", workspace->engine);
+		exit(-1);
+	}
+
+	/*CN_save("tmp_ifft.dat", s, workspace->temp_ifft);*/
+
 	/* check, sqrt sbould behave according to chi */
 	/* check, use this with just noise and see if the mean is 4, std should be sqrt(8). Chi-sqre if not sqrt(max). Check 'max' dist.*/
-	double old_snr_definition = sqrt(max_value) / sqrt(2.0);
+	double old_snr_definition = CN_peak_snr(workspace);
 
 	// temp hack to do this quickly
 	//workspace->temp_ifft[max_index] = 0.0;
@@ -476,3 +1652,355 @@ void coherent_network_statistic(
 		}
 	}
 }
+
+/* Allocates the batch buffers on first use. */
+static void CN_batch_alloc(size_t num_detectors, coherent_network_workspace_t *workspace) {
+	size_t len = workspace->sp_lookup->len;
+
+	if (workspace->batch_spectra != NULL) {
+		return;
+	}
+
+	/* Aligned, for the batched FFTW plans */
+	workspace->batch_spectra = (double*) AR_malloc( workspace->arena, CN_BATCH_SIZE * 4 * workspace->num_time_samples * sizeof(double) );
+	workspace->batch_ifft_plan = (fft_plan_t**) AR_calloc( workspace->arena, CN_BATCH_SIZE, sizeof(fft_plan_t*) );
+	workspace->batch_geometry = (double*) AR_malloc( workspace->arena, CN_BATCH_SIZE * 3 * num_detectors * sizeof(double) );
+	workspace->batch_phasor = (double*) AR_malloc( workspace->arena, CN_BATCH_SIZE * 2 * len * sizeof(double) );
+	workspace->batch_scratch = (double*) AR_malloc( workspace->arena, (7 + 6 * CN_BATCH_SIZE) * CN_FUSED_BLOCK * sizeof(double) );
+}
+
+/* The statistic of the first num_points points of batch_spectra. Over the whole series and on one thread, the
+ * 2 * num_points IFFTs are done as one batched transform; otherwise each point goes through CN_one_sided_statistic.
+ */
+static void CN_batch_statistic( size_t num_points, coherent_network_workspace_t *workspace, double *out_network_snr ) {
+	size_t p;
+	size_t num_time_samples = workspace->num_time_samples;
+	int batched = (workspace->tc_window_plan == NULL && workspace->baseband_len == 0 && workspace->num_threads == 1);
+
+	if (batched) {
+		if (workspace->batch_ifft_plan[num_points - 1] == NULL) {
+			workspace->batch_ifft_plan[num_points - 1] = FFT_plan_many_get( num_time_samples, 2 * num_points, FFT_BACKWARD );
+		}
+		FFT_execute_many( workspace->batch_ifft_plan[num_points - 1], workspace->batch_spectra, workspace->fft_workspace );
+	}
+
+	for (p = 0; p < num_points; p++) {
+		double *z_plus = workspace->batch_spectra + 4 * num_time_samples * p;
+
+		workspace->search_start = workspace->tc_window_start;
+		workspace->search_count = (workspace->tc_window_count > 0) ? workspace->tc_window_count : num_time_samples;
+
+		if (batched) {
+			CN_one_sided_power( z_plus, z_plus + 2 * num_time_samples, workspace );
+		} else {
+			CN_one_sided_statistic( z_plus, z_plus + 2 * num_time_samples, workspace );
+		}
+		out_network_snr[p] = CN_peak_snr(workspace);
+	}
+}
+
+/* CN_fused_ifft for num_points <= CN_BATCH_SIZE points. Every detector's block of filtered data is used for all
+ * the points before moving on. The statistic of point p is written to out_network_snr[p].
+ */
+static void CN_fused_batch(
+		detector_network_t* net,
+		size_t num_points,
+		inspiral_chirp_time_t *chirp,
+		sky_t *sky,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace,
+		double *out_network_snr)
+{
+	size_t i, p, j0;
+	size_t num_time_samples = workspace->num_time_samples;
+	size_t num_detectors = net->num_detectors;
+	stationary_phase_workspace_t *lookup = workspace->sp_lookup;
+	size_t k_low = lookup->f_low_index;
+	size_t len = lookup->len;
+
+	double *phase = workspace->batch_scratch;
+	double *r_re = phase + CN_FUSED_BLOCK;
+	double *r_im = r_re + CN_FUSED_BLOCK;
+	double *e_re = r_im + CN_FUSED_BLOCK;
+	double *e_im = e_re + CN_FUSED_BLOCK;
+	double *c_re = e_im + CN_FUSED_BLOCK;
+	double *c_im = c_re + CN_FUSED_BLOCK;
+
+	/* Per point: g_re, g_im, zp_re, zp_im, zm_re, zm_im */
+	double *point_scratch = c_im + CN_FUSED_BLOCK;
+
+	if (!CN_workspace_filtered(workspace, network_strain)) {
+		CN_workspace_filter_data(workspace, net, network_strain);
+	}
+
+	for (p = 0; p < num_points; p++) {
+		double *geometry = workspace->batch_geometry + 3 * num_detectors * p;
+		double *z_plus = workspace->batch_spectra + 4 * num_time_samples * p;
+		double *z_minus = z_plus + 2 * num_time_samples;
+
+		CN_sky_weights(net, &sky[p], workspace);
+		for (i = 0; i < num_detectors; i++) {
+			geometry[i] = workspace->sky_geometry->time_delay[i];
+			geometry[num_detectors + i] = workspace->helpers[i]->w_plus_input;
+			geometry[2*num_detectors + i] = workspace->helpers[i]->w_minus_input;
+		}
+
+		if (workspace->template_cache != NULL) {
+			CN_intrinsic_phasor(&chirp[p], workspace);
+			memcpy( workspace->batch_phasor + 2 * len * p, workspace->intrinsic_phasor, 2 * len * sizeof(double) );
+		}
+
+		/* Out of band bins are zero */
+		memset( z_plus, 0, 2 * k_low * sizeof(double) );
+		memset( z_minus, 0, 2 * k_low * sizeof(double) );
+		memset( z_plus + 2*(k_low + len), 0, 2 * (num_time_samples - k_low - len) * sizeof(double) );
+		memset( z_minus + 2*(k_low + len), 0, 2 * (num_time_samples - k_low - len) * sizeof(double) );
+	}
+
+	for (j0 = 0; j0 < len; j0 += CN_FUSED_BLOCK) {
+		size_t n = GSL_MIN(CN_FUSED_BLOCK, len - j0);
+
+		for (p = 0; p < num_points; p++) {
+			double *g_re = point_scratch + 6 * CN_FUSED_BLOCK * p;
+			double *g_im = g_re + CN_FUSED_BLOCK;
+			double *zp = g_im + CN_FUSED_BLOCK;
+
+			if (workspace->template_cache != NULL) {
+				memcpy( g_re, workspace->batch_phasor + 2 * len * p + j0, n * sizeof(double) );
+				memcpy( g_im, workspace->batch_phasor + 2 * len * p + len + j0, n * sizeof(double) );
+			} else {
+				/* Phase at the geocenter. The coalescence phase is 0. */
+				SP_phase( lookup, &chirp[p], 0.0, 0.0, j0, n, phase );
+				CPU_sincos( n, phase, g_re, g_im );
+			}
+
+			/* zp_re, zp_im, zm_re and zm_im */
+			memset( zp, 0, 4 * CN_FUSED_BLOCK * sizeof(double) );
+		}
+
+		for (i = 0; i < num_detectors; i++) {
+			const double *d_re = workspace->filtered_re[i] + j0;
+			const double *d_im = workspace->filtered_im[i] + j0;
+
+			for (p = 0; p < num_points; p++) {
+				const double *geometry = workspace->batch_geometry + 3 * num_detectors * p;
+				double *g_re = point_scratch + 6 * CN_FUSED_BLOCK * p;
+				double *g_im = g_re + CN_FUSED_BLOCK;
+				double *zp_re = g_im + CN_FUSED_BLOCK;
+				double *zp_im = zp_re + CN_FUSED_BLOCK;
+				double *zm_re = zp_im + CN_FUSED_BLOCK;
+				double *zm_im = zm_re + CN_FUSED_BLOCK;
+
+				SP_time_delay_ramp( lookup, j0, n, -geometry[i], r_re, r_im );
+				CV_mul( n, g_re, g_im, r_re, r_im, e_re, e_im );
+				CV_mul( n, d_re, d_im, e_re, e_im, c_re, c_im );
+
+				CV_axpy( n, geometry[num_detectors + i], c_re, c_im, zp_re, zp_im );
+				CV_axpy( n, geometry[2*num_detectors + i], c_re, c_im, zm_re, zm_im );
+			}
+		}
+
+		for (p = 0; p < num_points; p++) {
+			double *zp_re = point_scratch + 6 * CN_FUSED_BLOCK * p + 2 * CN_FUSED_BLOCK;
+			double *zp_im = zp_re + CN_FUSED_BLOCK;
+			double *zm_re = zp_im + CN_FUSED_BLOCK;
+			double *zm_im = zm_re + CN_FUSED_BLOCK;
+			double *z_plus = workspace->batch_spectra + 4 * num_time_samples * p;
+			double *z_minus = z_plus + 2 * num_time_samples;
+
+			CV_interleave( n, zp_re, zp_im, z_plus + 2*(k_low + j0) );
+			CV_interleave( n, zm_re, zm_im, z_minus + 2*(k_low + j0) );
+		}
+	}
+
+	CN_batch_statistic( num_points, workspace, out_network_snr );
+}
+
+void coherent_network_statistic_batch(
+		detector_network_t* net,
+		double f_low,
+		double f_high,
+		size_t num_points,
+		inspiral_chirp_time_t *chirp,
+		sky_t *sky,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace,
+		double *out_network_snr)
+{
+	assert(net);
+	assert(chirp);
+	assert(sky);
+	assert(network_strain);
+	assert(workspace);
+	assert(out_network_snr);
+
+	size_t p;
+
+	if (workspace->engine != CN_ENGINE_FUSED || workspace->precision != FFT_DOUBLE) {
+		for (p = 0; p < num_points; p++) {
+			coherent_network_statistic(net, f_low, f_high, &chirp[p], &sky[p], network_strain, workspace,
+					&out_network_snr[p], NULL);
+		}
+		return;
+	}
+
+	CN_batch_alloc(net->num_detectors, workspace);
+
+	for (p = 0; p < num_points; p += CN_BATCH_SIZE) {
+		size_t count = GSL_MIN(CN_BATCH_SIZE, num_points - p);
+		CN_fused_batch(net, count, &chirp[p], &sky[p], network_strain, workspace, &out_network_snr[p]);
+	}
+}
+
+/* Prefilters every realization of network_strain into realization_filtered. */
+static void CN_realizations_filter_data(detector_network_t* net, network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace)
+{
+	size_t r, i;
+	size_t len = workspace->sp_lookup->len;
+	size_t num_detectors = net->num_detectors;
+	network_strain_half_fft_t view;
+
+	if (workspace->realization_filtered == NULL || workspace->num_realizations < network_strain->num_realizations) {
+		/* The smaller block stays in the arena. */
+		workspace->realization_filtered = (double*) AR_malloc( workspace->arena,
+				network_strain->num_realizations * num_detectors * 2 * len * sizeof(double) );
+		workspace->num_realizations = network_strain->num_realizations;
+	}
+
+	for (r = 0; r < network_strain->num_realizations; r++) {
+		network_strain_half_fft_realization(network_strain, r, &view);
+		CN_workspace_filter_data(workspace, net, &view);
+
+		for (i = 0; i < num_detectors; i++) {
+			double *filtered = workspace->realization_filtered + (r * num_detectors + i) * 2 * len;
+			memcpy( filtered, workspace->filtered_re[i], len * sizeof(double) );
+			memcpy( filtered + len, workspace->filtered_im[i], len * sizeof(double) );
+		}
+	}
+
+	workspace->realization_generation = network_strain->generation;
+}
+
+void coherent_network_statistic_realizations(
+		detector_network_t* net,
+		double f_low,
+		double f_high,
+		inspiral_chirp_time_t *chirp,
+		sky_t *sky,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace,
+		double *out_network_snr)
+{
+	assert(net);
+	assert(chirp);
+	assert(sky);
+	assert(network_strain);
+	assert(workspace);
+	assert(out_network_snr);
+
+	size_t r, r0, i, j0;
+	size_t num_time_samples = workspace->num_time_samples;
+	size_t num_detectors = net->num_detectors;
+	stationary_phase_workspace_t *lookup = workspace->sp_lookup;
+	size_t k_low = lookup->f_low_index;
+	size_t len = lookup->len;
+
+	if (workspace->engine != CN_ENGINE_FUSED || workspace->precision != FFT_DOUBLE) {
+		network_strain_half_fft_t view;
+		for (r = 0; r < network_strain->num_realizations; r++) {
+			network_strain_half_fft_realization(network_strain, r, &view);
+			coherent_network_statistic(net, f_low, f_high, chirp, sky, &view, workspace, &out_network_snr[r], NULL);
+		}
+		return;
+	}
+
+	double *phase = workspace->fused_scratch;
+	double *g_re = phase + CN_FUSED_BLOCK;
+	double *g_im = g_re + CN_FUSED_BLOCK;
+	double *r_re = g_im + CN_FUSED_BLOCK;
+	double *r_im = r_re + CN_FUSED_BLOCK;
+	double *c_re = r_im + CN_FUSED_BLOCK;
+	double *c_im = c_re + CN_FUSED_BLOCK;
+	double *zp_re = c_im + CN_FUSED_BLOCK;
+	double *zp_im = zp_re + CN_FUSED_BLOCK;
+	double *zm_re = zp_im + CN_FUSED_BLOCK;
+	double *zm_im = zm_re + CN_FUSED_BLOCK;
+
+	if (workspace->realization_generation != network_strain->generation) {
+		CN_realizations_filter_data(net, network_strain, workspace);
+	}
+
+	if (workspace->detector_phasor == NULL) {
+		workspace->detector_phasor = (double*) AR_malloc( workspace->arena, num_detectors * 2 * len * sizeof(double) );
+	}
+
+	CN_sky_weights(net, sky, workspace);
+
+	if (workspace->template_cache != NULL) {
+		CN_intrinsic_phasor(chirp, workspace);
+	}
+
+	/* The detector templates, once for all the realizations */
+	for (j0 = 0; j0 < len; j0 += CN_FUSED_BLOCK) {
+		size_t n = GSL_MIN(CN_FUSED_BLOCK, len - j0);
+
+		if (workspace->template_cache != NULL) {
+			memcpy( g_re, workspace->intrinsic_phasor + j0, n * sizeof(double) );
+			memcpy( g_im, workspace->intrinsic_phasor + len + j0, n * sizeof(double) );
+		} else {
+			/* Phase at the geocenter. The coalescence phase is 0. */
+			SP_phase( lookup, chirp, 0.0, 0.0, j0, n, phase );
+			CPU_sincos( n, phase, g_re, g_im );
+		}
+
+		for (i = 0; i < num_detectors; i++) {
+			double *e = workspace->detector_phasor + i * 2 * len;
+
+			SP_time_delay_ramp( lookup, j0, n, -workspace->sky_geometry->time_delay[i], r_re, r_im );
+			CV_mul( n, g_re, g_im, r_re, r_im, e + j0, e + len + j0 );
+		}
+	}
+
+	/* The spectra of CN_BATCH_SIZE realizations, then their IFFTs together */
+	CN_batch_alloc(num_detectors, workspace);
+
+	for (r0 = 0; r0 < network_strain->num_realizations; r0 += CN_BATCH_SIZE) {
+		size_t count = GSL_MIN(CN_BATCH_SIZE, network_strain->num_realizations - r0);
+
+		for (r = r0; r < r0 + count; r++) {
+			double *z_plus = workspace->batch_spectra + 4 * num_time_samples * (r - r0);
+			double *z_minus = z_plus + 2 * num_time_samples;
+
+			/* Out of band bins are zero */
+			memset( z_plus, 0, 2 * k_low * sizeof(double) );
+			memset( z_minus, 0, 2 * k_low * sizeof(double) );
+			memset( z_plus + 2*(k_low + len), 0, 2 * (num_time_samples - k_low - len) * sizeof(double) );
+			memset( z_minus + 2*(k_low + len), 0, 2 * (num_time_samples - k_low - len) * sizeof(double) );
+
+			for (j0 = 0; j0 < len; j0 += CN_FUSED_BLOCK) {
+				size_t n = GSL_MIN(CN_FUSED_BLOCK, len - j0);
+
+				memset( zp_re, 0, n * sizeof(double) );
+				memset( zp_im, 0, n * sizeof(double) );
+				memset( zm_re, 0, n * sizeof(double) );
+				memset( zm_im, 0, n * sizeof(double) );
+
+				for (i = 0; i < num_detectors; i++) {
+					const double *filtered = workspace->realization_filtered + (r * num_detectors + i) * 2 * len;
+					const double *e = workspace->detector_phasor + i * 2 * len;
+
+					CV_mul( n, filtered + j0, filtered + len + j0, e + j0, e + len + j0, c_re, c_im );
+
+					CV_axpy( n, workspace->helpers[i]->w_plus_input, c_re, c_im, zp_re, zp_im );
+					CV_axpy( n, workspace->helpers[i]->w_minus_input, c_re, c_im, zm_re, zm_im );
+				}
+
+				CV_interleave( n, zp_re, zp_im, z_plus + 2*(k_low + j0) );
+				CV_interleave( n, zm_re, zm_im, z_minus + 2*(k_low + j0) );
+			}
+		}
+
+		CN_batch_statistic( count, workspace, &out_network_snr[r0] );
+	}
+}
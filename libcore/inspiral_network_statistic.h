@@ -6,14 +6,17 @@
 #include <stdlib.h>
 
 #include <gsl/gsl_cblas.h>
-#include <gsl/gsl_fft_complex.h>
 #include <gsl/gsl_math.h>
 #include <gsl/gsl_statistics_double.h>
 
+#include "arena.h"
 #include "detector_antenna_patterns.h"
 #include "detector_network.h"
+#include "fft.h"
 #include "inspiral_chirp_time.h"
 #include "inspiral_stationary_phase.h"
+#include "inspiral_template_cache.h"
+#include "sky_geometry.h"
 #include "spectral_density.h"
 #include "strain.h"
 
@@ -21,6 +24,13 @@
 extern "C" {
 #endif
 
+/* Selects how the matched-filter spectra are formed and inverse transformed. */
+typedef enum {
+	CN_ENGINE_TWO_SIDED = 0,	/* Four two-sided spectra and four IFFTs (the Matlab port). */
+	CN_ENGINE_ONE_SIDED,		/* Two one-sided (analytic signal) spectra and two IFFTs. */
+	CN_ENGINE_FUSED			/* As ONE_SIDED, but a single pass over the in-band bins builds both spectra. */
+} CN_ENGINE;
+
 /* There is one helper per detector */
 typedef struct coherent_network_helper_s {
 	double w_plus_input;
@@ -30,44 +40,283 @@ typedef struct coherent_network_helper_s {
 
 } coherent_network_helper_t;
 
+/* With num_time_samples 0, c_plus and c_minus are left unallocated. */
 coherent_network_helper_t* CN_helper_alloc(size_t num_time_samples);
 
 void CN_helper_free( coherent_network_helper_t* helper);
 
+/* Read-only state shared by the workspaces of all the threads of a search: the stationary phase coefficients of
+ * the band and the normalization factor of each detector.
+ */
+typedef struct coherent_network_context_s {
+	size_t num_time_samples;
+	size_t num_half_freq;
+	size_t num_detectors;
+
+	stationary_phase_workspace_t *sp_lookup;
+	double *normalization_factors;
+
+} coherent_network_context_t;
+
+coherent_network_context_t* CN_context_alloc(size_t num_time_samples, detector_network_t *net, size_t num_half_freq,
+		double f_low, double f_high);
+
+void CN_context_free(coherent_network_context_t *context);
+
 typedef struct coherent_network_workspace_s {
 	size_t num_time_samples;
 
+	/* sp_lookup and normalization_factors below point into the context. own_context is only set by
+	 * CN_workspace_alloc, which makes a context of its own.
+	 */
+	const coherent_network_context_t *context;
+	coherent_network_context_t *own_context;
+
+	CN_ENGINE engine;
+
+	/* Holds fs, temp_ifft, the filtered data, the fused scratch and the two-sided and one-sided spectra, 64 byte
+	 * aligned and released together by CN_workspace_free. It uses the arena pages set when it was made.
+	 */
+	arena_t *arena;
+
 	size_t num_helpers;
 	coherent_network_helper_t **helpers;
 
 	stationary_phase_workspace_t *sp_lookup;
 	stationary_phase_t *sp;
 
+	/* Detector independent part of the template, computed once per chirp. */
+	stationary_phase_t *sp_intrinsic;
+
 	/* temporary array that is repeatedly used.
 	 * Its size must be the same as the number of frequencies.
 	 */
 	gsl_complex *temp_array;
 
+	/* sp, sp_intrinsic, temp_array, terms and the helpers' c_plus and c_minus are only allocated when the
+	 * two-sided or one-sided engine first runs, and fs[2], fs[3] when that, a tc window or the baseband
+	 * evaluation needs them. fs[0] and fs[1] are always there.
+	 */
 	gsl_complex **terms;
 	double **fs;
 
 	double *temp_ifft;
-	gsl_fft_complex_wavetable *fft_wavetable;
-	gsl_fft_complex_workspace *fft_workspace;
+	/* Backward (unnormalized) transform of length num_time_samples, shared through the plan cache. */
+	fft_plan_t *ifft_plan;
+	fft_workspace_t *fft_workspace;
 
-	detector_antenna_patterns_workspace_t *ap_workspace;
-	detector_antenna_patterns_t *ap;
+	/* Antenna patterns, time delays and O at the current sky position, from the optional shared table
+	 * set by CN_workspace_set_sky_table or else computed in closed form.
+	 */
+	sky_geometry_t *sky_geometry;
+	const sky_geometry_table_t *sky_table;
 
 	/* g, normalization factor */
 	double *normalization_factors;
 
+	/* CN_ENGINE_FUSED: per detector, the in-band data already multiplied by g_coeff / (normalization * asd)
+	 * and by the one-sided weight, as separate real and imaginary arrays of length sp_lookup->len.
+	 * They are rebuilt by CN_workspace_filter_data whenever the network strain passed in has a different
+	 * generation or realization, 0 when there is nothing filtered.
+	 */
+	size_t filtered_generation;
+	size_t filtered_realization;
+	double **filtered_re;
+	double **filtered_im;
+	double *fused_scratch;
+
+	/* FFT_SINGLE: the fused engine keeps the filtered data, the two spectra and their IFFTs in float.
+	 * Phases and the |z|^2 sums are still formed in double. Allocated by CN_workspace_set_precision.
+	 */
+	FFT_PRECISION precision;
+	float **filtered_re_single;
+	float **filtered_im_single;
+	float **fs_single;
+	fft_plan_t *ifft_plan_single;
+
+	/* Optional coalescence time window set by CN_workspace_set_tc_window. When tc_window_count is not 0 only
+	 * temp_ifft[tc_window_start .. tc_window_start + tc_window_count) is valid, and only it is searched.
+	 * The one-sided and fused engines (in double) produce just the window with a pruned IFFT into tc_window_z.
+	 */
+	size_t tc_window_start;
+	size_t tc_window_count;
+	fft_pruned_plan_t *tc_window_plan;
+	double *tc_window_z;
+	size_t tc_window_capacity;	/* Window length tc_window_z has room for */
+
+	/* Optional reduced-rate evaluation set by CN_workspace_set_baseband. The in-band bins are shifted down to DC
+	 * and inverse transformed at length baseband_len, the smallest divisor of num_time_samples that holds the
+	 * band. That gives every (num_time_samples / baseband_len)-th sample of temp_ifft, and the samples between
+	 * the neighbours of the largest one are then evaluated directly. baseband_len is 0 when disabled.
+	 * Used by the one-sided and fused engines in double precision when no tc window is set.
+	 */
+	size_t baseband_len;
+	fft_plan_t *baseband_plan;
+
+	/* Samples of temp_ifft that are searched for the maximum, counted modulo num_time_samples. */
+	size_t search_start;
+	size_t search_count;
+
+	/* Optional cache of intrinsic templates shared with other workspaces, set by CN_workspace_set_template_cache.
+	 * It is not owned by the workspace. intrinsic_phasor (2 * sp_lookup->len) receives exp(i phase) from it.
+	 */
+	template_cache_t *template_cache;
+	double *intrinsic_phasor;
+
+	/* Sky-marginal evaluation, see CN_sky_series_compute. Per detector, the in-band matched filter output
+	 * centred on bin sky_series_center, inverse transformed at length sky_series_len (at least CN_SKY_OVERSAMPLE
+	 * times the band) and stored with one wrapped sample before and two after. Allocated on first use.
+	 */
+	size_t sky_series_len;
+	size_t sky_series_center;
+	fft_plan_t *sky_series_plan;
+	fft_workspace_t *sky_series_fft_workspace;
+	double **sky_series;
+
+	/* coherent_network_statistic_batch and _realizations with the fused engine in double: for up to
+	 * CN_BATCH_SIZE points, the two spectra of each point (4 * num_time_samples), the time delays and weights
+	 * (3 per detector), the intrinsic phasor when a template cache is set (2 * sp_lookup->len) and the block
+	 * scratch. batch_ifft_plan[p - 1] inverse transforms the spectra of p points at once. Allocated on first use.
+	 */
+	double *batch_spectra;
+	double *batch_geometry;
+	double *batch_phasor;
+	double *batch_scratch;
+	fft_plan_t **batch_ifft_plan;
+
+	/* coherent_network_statistic_realizations with the fused engine in double: the prefiltered data of every
+	 * realization of the network strain of generation realization_generation, num_realizations * num_detectors
+	 * blocks of sp_lookup->len real parts followed by sp_lookup->len imaginary parts, and the detector templates
+	 * exp(i detector phase) in the same layout. Allocated on first use.
+	 */
+	size_t realization_generation;
+	size_t num_realizations;
+	double *realization_filtered;
+	double *detector_phasor;
+
+	/* Threads used inside one evaluation, set by CN_workspace_set_threads. fused_scratch holds a set of scratch
+	 * arrays per thread and every thread after the first has its own FFT workspace in extra_fft_workspace.
+	 */
+	size_t num_threads;
+	fft_workspace_t **extra_fft_workspace;
+
 } coherent_network_workspace_t;
 
 coherent_network_workspace_t* CN_workspace_alloc(size_t num_time_samples, detector_network_t *net, size_t num_half_freq,
 		double f_low, double f_high);
 
+/* A workspace for one thread that uses a shared context. The context must outlive the workspace. */
+coherent_network_workspace_t* CN_workspace_alloc_shared(const coherent_network_context_t *context, detector_network_t *net);
+
+/* Bytes allocated by the workspace itself as it stands: every chunk of its arena, so also the padding and the
+ * blocks left behind when a buffer grew, plus the parts still on malloc. Without its context, the cached FFT
+ * plans, the tc window plan, and any template cache or sky table.
+ */
+size_t CN_workspace_bytes_per_thread(const coherent_network_workspace_t *workspace);
+
 void CN_workspace_free( coherent_network_workspace_t *workspace );
 
+void CN_workspace_set_engine( coherent_network_workspace_t *workspace, CN_ENGINE engine );
+
+const char* CN_engine_id_to_name(CN_ENGINE engine);
+
+CN_ENGINE CN_engine_name_to_id(const char *name);
+
+/* Restricts the statistic to the coalescence time samples start .. start + count - 1, which must lie inside
+ * the series. A count of 0 restores the whole series.
+ */
+void CN_workspace_set_tc_window( coherent_network_workspace_t *workspace, size_t start, size_t count );
+
+/* Spreads one evaluation over num_threads OpenMP threads (1, the default, is serial): the data filtering over
+ * the detectors, the band of the fused engine (in double) over blocks, the IFFTs over each other, and the
+ * |z|^2 sums and the peak search over the samples. The results do not depend on num_threads. Inside another
+ * parallel region, such as the PSO particle loop, this needs nested parallelism to be enabled.
+ */
+void CN_workspace_set_threads( coherent_network_workspace_t *workspace, size_t num_threads );
+
+/* Takes the intrinsic templates from the cache, computing and storing them on a miss. The cache must have been
+ * made with a template length of sp_lookup->len. NULL turns the cache off.
+ */
+void CN_workspace_set_template_cache( coherent_network_workspace_t *workspace, template_cache_t *cache );
+
+/* Interpolates the sky dependent quantities from a table made for the same network. NULL computes them exactly. */
+void CN_workspace_set_sky_table( coherent_network_workspace_t *workspace, const sky_geometry_table_t *table );
+
+/* Turns the reduced-rate (baseband) evaluation on or off. */
+void CN_workspace_set_baseband( coherent_network_workspace_t *workspace, int enable );
+
+/* Selects double or single precision. Single precision is only available with CN_ENGINE_FUSED and trades
+ * about six significant digits of the statistic for half the memory traffic.
+ */
+void CN_workspace_set_precision( coherent_network_workspace_t *workspace, FFT_PRECISION precision );
+
+const char* CN_precision_id_to_name(FFT_PRECISION precision);
+
+FFT_PRECISION CN_precision_name_to_id(const char *name);
+
+/* Precomputes the filtered data used by CN_ENGINE_FUSED. This is done automatically when a network strain
+ * of another generation is passed in; after modifying a strain in place, call network_strain_half_fft_changed.
+ */
+void CN_workspace_filter_data( coherent_network_workspace_t *workspace, detector_network_t *net,
+		network_strain_half_fft_t *network_strain );
+
+/* Evaluates num_points (chirp, sky) points, as coherent_network_statistic does one at a time. With the fused
+ * engine in double the points are taken CN_BATCH_SIZE at a time: each block of the prefiltered data is read
+ * once for the whole group and the templates of the group are built side by side, after which the IFFTs of
+ * the group are done as one batched transform. Other engines evaluate the points one after the other.
+ */
+#define CN_BATCH_SIZE 4
+
+void coherent_network_statistic_batch(
+		detector_network_t* net,
+		double f_low,
+		double f_high,
+		size_t num_points,
+		inspiral_chirp_time_t *chirp,
+		sky_t *sky,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace,
+		double *out_network_snr);
+
+/* The statistic of every realization of network_strain at one (chirp, sky) point, out_network_snr[r] for
+ * realization r. The template and the sky factors are formed once. With the fused engine in double the
+ * detector templates are built over the band once, the prefiltered data of all the realizations is kept in the
+ * workspace, and each realization then only costs its weighted sums and IFFTs, which are batched CN_BATCH_SIZE
+ * realizations at a time. Other engines evaluate the realizations one after the other.
+ */
+void coherent_network_statistic_realizations(
+		detector_network_t* net,
+		double f_low,
+		double f_high,
+		inspiral_chirp_time_t *chirp,
+		sky_t *sky,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace,
+		double *out_network_snr);
+
+/* Sky-marginal evaluation. For a fixed chirp the one-sided matched filter output of detector i is
+ *     z_plus(t) = sum_i w_plus_i x_i(t - time_delay_i),   z_minus(t) = sum_i w_minus_i x_i(t - time_delay_i)
+ * where x_i does not depend on the sky. CN_sky_series_compute forms the x_i once per chirp on an oversampled
+ * grid, and CN_sky_series_statistic then gives the statistic of any number of sky positions with cubic
+ * interpolation and weighted sums, O(num_time_samples * num_detectors) per position instead of the per
+ * detector templates and IFFTs. Only the tc window, if set, is evaluated. With CN_SKY_OVERSAMPLE 8 the
+ * squared statistic is within about 1e-3 (relative) of coherent_network_statistic.
+ */
+#define CN_SKY_OVERSAMPLE 8
+
+void CN_sky_series_compute(
+		detector_network_t* net,
+		inspiral_chirp_time_t *chirp,
+		network_strain_half_fft_t *network_strain,
+		coherent_network_workspace_t *workspace);
+
+void CN_sky_series_statistic(
+		detector_network_t* net,
+		size_t num_sky,
+		sky_t *sky,
+		coherent_network_workspace_t *workspace,
+		double *out_network_snr);
+
 void CN_do_work(size_t num_time_samples, size_t f_low_index, size_t f_high_index, gsl_complex *spa, asd_t *asd, gsl_complex *whitened_data, gsl_complex *temp, gsl_complex *out_c);
 
 void CN_save(char* filename, size_t len, double* tmp_ifft);
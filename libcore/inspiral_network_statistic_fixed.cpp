@@ -0,0 +1,157 @@
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif
+
+#include <stddef.h>
+
+#include "cpu_dispatch.h"
+#include "inspiral_network_statistic_fixed.h"
+
+/* With D known at compile time the detector loop unrolls, the per-detector pointers and weights live in
+ * fixed arrays, and the bin loop keeps the four sums in registers instead of making a pass over the block
+ * per detector. The operations are those of the generic loop in the same order, so the results agree.
+ *
+ * The kernels are stamped once per instruction set path (see cpu_dispatch.h); ATTR is the path's target
+ * attribute.
+ */
+#define CN_FIXED_DEFINE(SUFFIX, ATTR)											\
+template <typename T, size_t D>												\
+ATTR static void CN_fixed_block_##SUFFIX(size_t n,									\
+		const T *g_re, const T *g_im,										\
+		const double *ramp_re, const double *ramp_im, size_t ramp_stride,					\
+		T **data_re, T **data_im, size_t offset,								\
+		const T *w_plus_in, const T *w_minus_in,								\
+		T *z_plus, T *z_minus)											\
+{															\
+	size_t i, j;													\
+	const T *d_re[D];												\
+	const T *d_im[D];												\
+	const double *r_re[D];												\
+	const double *r_im[D];												\
+	T w_plus[D];													\
+	T w_minus[D];													\
+															\
+	for (i = 0; i < D; i++) {											\
+		d_re[i] = data_re[i] + offset;										\
+		d_im[i] = data_im[i] + offset;										\
+		r_re[i] = ramp_re + i * ramp_stride;									\
+		r_im[i] = ramp_im + i * ramp_stride;									\
+		w_plus[i] = w_plus_in[i];										\
+		w_minus[i] = w_minus_in[i];										\
+	}														\
+															\
+	for (j = 0; j < n; j++) {											\
+		T zp_re = 0, zp_im = 0, zm_re = 0, zm_im = 0;								\
+															\
+		for (i = 0; i < D; i++) {										\
+			T rr = (T) r_re[i][j];										\
+			T ri = (T) r_im[i][j];										\
+															\
+			/* exp(i detector phase), then c = filtered data * exp(i detector phase) */			\
+			T e_re = g_re[j] * rr - g_im[j] * ri;								\
+			T e_im = g_re[j] * ri + g_im[j] * rr;								\
+			T c_re = d_re[i][j] * e_re - d_im[i][j] * e_im;							\
+			T c_im = d_re[i][j] * e_im + d_im[i][j] * e_re;							\
+															\
+			zp_re += w_plus[i] * c_re;									\
+			zp_im += w_plus[i] * c_im;									\
+			zm_re += w_minus[i] * c_re;									\
+			zm_im += w_minus[i] * c_im;									\
+		}													\
+															\
+		z_plus[2*j + 0] = zp_re;										\
+		z_plus[2*j + 1] = zp_im;										\
+		z_minus[2*j + 0] = zm_re;										\
+		z_minus[2*j + 1] = zm_im;										\
+	}														\
+}															\
+															\
+template <typename T>													\
+static int CN_fixed_detectors_##SUFFIX(size_t num_detectors, size_t n,							\
+		const T *g_re, const T *g_im,										\
+		const double *ramp_re, const double *ramp_im, size_t ramp_stride,					\
+		T **data_re, T **data_im, size_t offset,								\
+		const T *w_plus, const T *w_minus,									\
+		T *z_plus, T *z_minus)											\
+{															\
+	switch (num_detectors) {											\
+	case 2:														\
+		CN_fixed_block_##SUFFIX<T, 2>(n, g_re, g_im, ramp_re, ramp_im, ramp_stride, data_re, data_im,	\
+				offset, w_plus, w_minus, z_plus, z_minus);						\
+		return 1;												\
+	case 3:														\
+		CN_fixed_block_##SUFFIX<T, 3>(n, g_re, g_im, ramp_re, ramp_im, ramp_stride, data_re, data_im,	\
+				offset, w_plus, w_minus, z_plus, z_minus);						\
+		return 1;												\
+	case 4:														\
+		CN_fixed_block_##SUFFIX<T, 4>(n, g_re, g_im, ramp_re, ramp_im, ramp_stride, data_re, data_im,	\
+				offset, w_plus, w_minus, z_plus, z_minus);						\
+		return 1;												\
+	case 5:														\
+		CN_fixed_block_##SUFFIX<T, 5>(n, g_re, g_im, ramp_re, ramp_im, ramp_stride, data_re, data_im,	\
+				offset, w_plus, w_minus, z_plus, z_minus);						\
+		return 1;												\
+	default:													\
+		return 0;												\
+	}														\
+}
+
+CN_FIXED_DEFINE(generic, )
+#ifdef CPU_HAVE_DISPATCH
+CN_FIXED_DEFINE(sse4, CPU_TARGET_SSE4)
+CN_FIXED_DEFINE(avx2, CPU_TARGET_AVX2)
+CN_FIXED_DEFINE(avx512, CPU_TARGET_AVX512)
+#endif
+
+template <typename T>
+static int CN_fixed_dispatch(size_t num_detectors, size_t n,
+		const T *g_re, const T *g_im,
+		const double *ramp_re, const double *ramp_im, size_t ramp_stride,
+		T **data_re, T **data_im, size_t offset,
+		const T *w_plus, const T *w_minus,
+		T *z_plus, T *z_minus)
+{
+#ifdef CPU_HAVE_DISPATCH
+	switch (CPU_get_path()) {
+	case CPU_PATH_AVX512:
+		return CN_fixed_detectors_avx512<T>(num_detectors, n, g_re, g_im, ramp_re, ramp_im, ramp_stride,
+				data_re, data_im, offset, w_plus, w_minus, z_plus, z_minus);
+	case CPU_PATH_AVX2:
+		return CN_fixed_detectors_avx2<T>(num_detectors, n, g_re, g_im, ramp_re, ramp_im, ramp_stride,
+				data_re, data_im, offset, w_plus, w_minus, z_plus, z_minus);
+	case CPU_PATH_SSE4:
+		return CN_fixed_detectors_sse4<T>(num_detectors, n, g_re, g_im, ramp_re, ramp_im, ramp_stride,
+				data_re, data_im, offset, w_plus, w_minus, z_plus, z_minus);
+	default:
+		break;
+	}
+#endif
+	return CN_fixed_detectors_generic<T>(num_detectors, n, g_re, g_im, ramp_re, ramp_im, ramp_stride,
+			data_re, data_im, offset, w_plus, w_minus, z_plus, z_minus);
+}
+
+int CN_fixed_supported(size_t num_detectors) {
+	return num_detectors >= CN_FIXED_MIN_DETECTORS && num_detectors <= CN_FIXED_MAX_DETECTORS;
+}
+
+int CN_fixed_fused_block(size_t num_detectors, size_t n,
+		const double *g_re, const double *g_im,
+		const double *ramp_re, const double *ramp_im, size_t ramp_stride,
+		double **data_re, double **data_im, size_t offset,
+		const double *w_plus, const double *w_minus,
+		double *z_plus, double *z_minus)
+{
+	return CN_fixed_dispatch<double>(num_detectors, n, g_re, g_im, ramp_re, ramp_im, ramp_stride,
+			data_re, data_im, offset, w_plus, w_minus, z_plus, z_minus);
+}
+
+int CN_fixed_fused_block_single(size_t num_detectors, size_t n,
+		const float *g_re, const float *g_im,
+		const double *ramp_re, const double *ramp_im, size_t ramp_stride,
+		float **data_re, float **data_im, size_t offset,
+		const float *w_plus, const float *w_minus,
+		float *z_plus, float *z_minus)
+{
+	return CN_fixed_dispatch<float>(num_detectors, n, g_re, g_im, ramp_re, ramp_im, ramp_stride,
+			data_re, data_im, offset, w_plus, w_minus, z_plus, z_minus);
+}
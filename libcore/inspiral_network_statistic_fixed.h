@@ -0,0 +1,41 @@
+#ifndef SRC_C_INSPIRAL_NETWORK_STATISTIC_FIXED_H_
+#define SRC_C_INSPIRAL_NETWORK_STATISTIC_FIXED_H_
+
+#include <stddef.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* Detector counts the fused engine has compile-time specializations for. */
+#define CN_FIXED_MIN_DETECTORS 2
+#define CN_FIXED_MAX_DETECTORS 5
+
+int CN_fixed_supported(size_t num_detectors);
+
+/* One block of n in-band bins of the fused engine, with every detector of a bin handled in registers:
+ *     z_plus[2j], z_plus[2j+1] = sum over detectors i of w_plus[i] * data_i[offset + j] * g[j] * ramp_i[j]
+ * and likewise z_minus with w_minus. The time delay ramp of detector i is ramp_re + i * ramp_stride.
+ * z_plus and z_minus are interleaved (real, imag). Returns 0, without touching z, if num_detectors has no
+ * specialization.
+ */
+int CN_fixed_fused_block(size_t num_detectors, size_t n,
+		const double *g_re, const double *g_im,
+		const double *ramp_re, const double *ramp_im, size_t ramp_stride,
+		double **data_re, double **data_im, size_t offset,
+		const double *w_plus, const double *w_minus,
+		double *z_plus, double *z_minus);
+
+/* The same in float, as CN_fused_ifft_single: the ramps stay double and are rounded per bin. */
+int CN_fixed_fused_block_single(size_t num_detectors, size_t n,
+		const float *g_re, const float *g_im,
+		const double *ramp_re, const double *ramp_im, size_t ramp_stride,
+		float **data_re, float **data_im, size_t offset,
+		const float *w_plus, const float *w_minus,
+		float *z_plus, float *z_minus);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* SRC_C_INSPIRAL_NETWORK_STATISTIC_FIXED_H_ */
@@ -7,8 +7,12 @@
 #include <gsl/gsl_complex_math.h>
 #include <gsl/gsl_math.h>
 
+#include "complex_vector.h"
 #include "inspiral_stationary_phase.h"
 
+/* The time delay ramp is restarted exactly every SP_RAMP_BLOCK bins to bound the recurrence error. */
+#define SP_RAMP_BLOCK 256
+
 
 int find_index_low(double f_low, size_t len, double *f_array) {
 	size_t i;
@@ -49,11 +53,24 @@ void SP_workspace_init(size_t len_f_array, double *f_array, stationary_phase_wor
 
 		lookup->g_coeff[j] = pow(f, -7.0 / 6.0);
 		lookup->chirp_tc_coeff[j] = 2.0 * M_PI * f;
-		lookup->constant_coeff[j] = -M_PI / 4.0;
-		lookup->chirp_time_0_coeff[j] = 2.0 * M_PI * lookup->f_low * 3.0 * pow(f_fac, -5.0 / 3.0) / 5.0;
-		lookup->chirp_time_1_coeff[j] =  2.0 * M_PI * lookup->f_low * pow(f_fac, -5.0 / 3.0);
-		lookup->chirp_time1_5_coeff[j] = -2.0 * M_PI * lookup->f_low * 3.0 * pow(f_fac,-2.0 / 3.0) / 2.0;
-		lookup->chirp_time2_coeff[j] = 2.0 * M_PI * lookup->f_low * 3.0 * pow(f_fac, -1.0 / 3.0);
+		lookup->u_coeff[j] = pow(f_fac, -1.0 / 3.0);
+	}
+
+	/* Evenly spaced frequencies allow the time delay to be applied by a recurrence. */
+	lookup->f_step = 0.0;
+	if (lookup->f_high_index > lookup->f_low_index) {
+		double step = (f_array[lookup->f_high_index] - f_array[lookup->f_low_index])
+				/ (lookup->f_high_index - lookup->f_low_index);
+		int even = 1;
+		for (i = lookup->f_low_index + 1; i <= lookup->f_high_index; i++) {
+			if (fabs(f_array[i] - f_array[i-1] - step) > 1e-9 * step) {
+				even = 0;
+				break;
+			}
+		}
+		if (even) {
+			lookup->f_step = step;
+		}
 	}
 }
 
@@ -102,47 +119,14 @@ stationary_phase_workspace_t* SP_workspace_alloc(double f_low, double f_high, si
 
 	lookup->len = lookup->f_high_index - lookup->f_low_index + 1;
 
-	lookup->g_coeff = (double*) malloc (lookup->len * sizeof(double));
-	if (lookup->g_coeff == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory in SP_workspace_alloc(). Exiting.\n");
-		exit(-1);
-	}
-
-	lookup->chirp_tc_coeff = (double*) malloc (lookup->len * sizeof(double));
-	if (lookup->chirp_tc_coeff == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory in SP_workspace_alloc(). Exiting.\n");
-		exit(-1);
-	}
-
-	lookup->constant_coeff = (double*) malloc (lookup->len * sizeof(double));
-	if (lookup->constant_coeff == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory in SP_workspace_alloc(). Exiting.\n");
-		exit(-1);
-	}
-
-	lookup->chirp_time_0_coeff = (double*) malloc (lookup->len * sizeof(double));
-	if (lookup->chirp_time_0_coeff == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory in SP_workspace_alloc(). Exiting.\n");
-		exit(-1);
-	}
-
-	lookup->chirp_time_1_coeff = (double*) malloc (lookup->len * sizeof(double));
-	if (lookup->chirp_time_1_coeff == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory in SP_workspace_alloc(). Exiting.\n");
-		exit(-1);
-	}
-
-	lookup->chirp_time1_5_coeff = (double*) malloc (lookup->len * sizeof(double));
-	if (lookup->chirp_time1_5_coeff == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory in SP_workspace_alloc(). Exiting.\n");
-		exit(-1);
-	}
-
-	lookup->chirp_time2_coeff = (double*) malloc (lookup->len * sizeof(double));
-	if (lookup->chirp_time2_coeff == NULL) {
+	lookup->coeff = (double*) malloc (SP_NUM_COEFF * lookup->len * sizeof(double));
+	if (lookup->coeff == NULL) {
 		fprintf(stderr, "Error. Unable to allocate memory in SP_workspace_alloc(). Exiting.\n");
 		exit(-1);
 	}
+	lookup->g_coeff = lookup->coeff;
+	lookup->chirp_tc_coeff = lookup->coeff + lookup->len;
+	lookup->u_coeff = lookup->coeff + 2 * lookup->len;
 
 	/* Lookup is now set up and can be initialized with the coefficients. */
 	SP_workspace_init(len_f_array, f_array, lookup);
@@ -153,33 +137,12 @@ stationary_phase_workspace_t* SP_workspace_alloc(double f_low, double f_high, si
 void SP_workspace_free( stationary_phase_workspace_t *lookup) {
 	assert(lookup != NULL);
 
-	assert(lookup->g_coeff != NULL);
-	free(lookup->g_coeff);
+	assert(lookup->coeff != NULL);
+	free(lookup->coeff);
+	lookup->coeff = NULL;
 	lookup->g_coeff = NULL;
-
-	assert(lookup->chirp_tc_coeff != NULL);
-	free(lookup->chirp_tc_coeff);
 	lookup->chirp_tc_coeff = NULL;
-
-	assert(lookup->constant_coeff != NULL);
-	free(lookup->constant_coeff);
-	lookup->constant_coeff = NULL;
-
-	assert(lookup->chirp_time_0_coeff != NULL);
-	free(lookup->chirp_time_0_coeff);
-	lookup->chirp_time_0_coeff = NULL;
-
-	assert(lookup->chirp_time_1_coeff != NULL);
-	free(lookup->chirp_time_1_coeff);
-	lookup->chirp_time_1_coeff = NULL;
-
-	assert(lookup->chirp_time1_5_coeff != NULL);
-	free(lookup->chirp_time1_5_coeff);
-	lookup->chirp_time1_5_coeff = NULL;
-
-	assert(lookup->chirp_time2_coeff != NULL);
-	free(lookup->chirp_time2_coeff);
-	lookup->chirp_time2_coeff = NULL;
+	lookup->u_coeff = NULL;
 
 	free(lookup);
 }
@@ -203,15 +166,8 @@ stationary_phase_t* SP_alloc(size_t num_half_frequencies) {
 		exit(-1);
 	}
 
-	sp->spa_90 = (gsl_complex*) malloc(sp->len * sizeof(gsl_complex));
-	if (sp->spa_90 == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory in SP_malloc. Exiting.\n");
-		exit(-1);
-	}
-
 	for (i = 0; i < sp->len; i++) {
 		sp->spa_0[i] = gsl_complex_rect(0.0, 0.0);
-		sp->spa_90[i] = gsl_complex_rect(0.0, 0.0);
 	}
 
 	return sp;
@@ -224,10 +180,6 @@ void SP_free(stationary_phase_t* sp) {
 	free(sp->spa_0);
 	sp->spa_0 = NULL;
 
-	assert(sp->spa_90);
-	free(sp->spa_90);
-	sp->spa_90 = NULL;
-
 	free(sp);
 }
 
@@ -246,7 +198,8 @@ void SP_save(char* filename, asd_t* asd, stationary_phase_t* sp) {
 	}
 
 	for (i = 0; i < sp->len; i++) {
-		fprintf(file, "%e %e %e\n", asd->asd[i], GSL_REAL(sp->spa_0[i]), GSL_REAL(sp->spa_90[i]));
+		/* The real part of spa_90 = -i spa_0 is the imaginary part of spa_0. */
+		fprintf(file, "%e %e %e\n", asd->asd[i], GSL_REAL(sp->spa_0[i]), GSL_IMAG(sp->spa_0[i]));
 	}
 
 	fclose(file);
@@ -281,6 +234,30 @@ double SP_normalization_factor(asd_t* asd, stationary_phase_workspace_t *lookup)
 	return sqrt(sum);
 }
 
+/* spa_0[f_low_index + j] = amp * g_j * exp(-i phase_j) over the band, in blocks. */
+static void SP_compute_template(
+		double time_delay, double amp, double inspiral_coalesce_phase, inspiral_chirp_time_t *chirp,
+		stationary_phase_workspace_t *lookup,
+		stationary_phase_t *out_sp)
+{
+	size_t i, j0;
+	double phase[SP_RAMP_BLOCK];
+	double c[SP_RAMP_BLOCK];
+	double s[SP_RAMP_BLOCK];
+
+	for (j0 = 0; j0 < lookup->len; j0 += SP_RAMP_BLOCK) {
+		size_t n = GSL_MIN(SP_RAMP_BLOCK, lookup->len - j0);
+
+		SP_phase(lookup, chirp, time_delay, inspiral_coalesce_phase, j0, n, phase);
+		CV_sincos(n, phase, c, s);
+
+		for (i = 0; i < n; i++) {
+			double a = amp * lookup->g_coeff[j0 + i];
+			GSL_SET_COMPLEX(&out_sp->spa_0[lookup->f_low_index + j0 + i], a * c[i], -a * s[i]);
+		}
+	}
+}
+
 void SP_compute(
 		double detector_time_delay, double detector_normalization_factor,
 		double inspiral_coalesce_phase, inspiral_chirp_time_t *chirp,
@@ -291,22 +268,116 @@ void SP_compute(
 	assert(lookup != NULL);
 	assert(out_sp != NULL);
 
-	size_t i;
+	SP_compute_template(detector_time_delay, 1.0 / detector_normalization_factor, inspiral_coalesce_phase, chirp,
+			lookup, out_sp);
+}
+
+void SP_compute_intrinsic(
+		double inspiral_coalesce_phase, inspiral_chirp_time_t *chirp,
+		stationary_phase_workspace_t *lookup,
+		stationary_phase_t *out_intrinsic)
+{
+	assert(chirp != NULL);
+	assert(lookup != NULL);
+	assert(out_intrinsic != NULL);
+
+	SP_compute_template(0.0, 1.0, inspiral_coalesce_phase, chirp, lookup, out_intrinsic);
+}
+
+void SP_compute_phasor(
+		double inspiral_coalesce_phase, inspiral_chirp_time_t *chirp,
+		stationary_phase_workspace_t *lookup,
+		double *out_re, double *out_im)
+{
+	assert(chirp != NULL);
+	assert(lookup != NULL);
+	assert(out_re != NULL);
+	assert(out_im != NULL);
+
+	size_t j0;
+	double phase[SP_RAMP_BLOCK];
+
+	for (j0 = 0; j0 < lookup->len; j0 += SP_RAMP_BLOCK) {
+		size_t n = GSL_MIN(SP_RAMP_BLOCK, lookup->len - j0);
+
+		SP_phase(lookup, chirp, 0.0, inspiral_coalesce_phase, j0, n, phase);
+		CV_sincos(n, phase, out_re + j0, out_im + j0);
+	}
+}
+
+void SP_apply_time_delay(
+		double detector_time_delay, double detector_normalization_factor,
+		stationary_phase_t *intrinsic,
+		stationary_phase_workspace_t *lookup,
+		stationary_phase_t *out_sp)
+{
+	assert(intrinsic != NULL);
+	assert(lookup != NULL);
+	assert(out_sp != NULL);
+
+	size_t i, j0;
+	double ramp_re[SP_RAMP_BLOCK];
+	double ramp_im[SP_RAMP_BLOCK];
+	double scale = 1.0 / detector_normalization_factor;
+
+	for (j0 = 0; j0 < lookup->len; j0 += SP_RAMP_BLOCK) {
+		size_t n = GSL_MIN(SP_RAMP_BLOCK, lookup->len - j0);
+		const double *in = (const double*) (intrinsic->spa_0 + lookup->f_low_index + j0);
+
+		SP_time_delay_ramp(lookup, j0, n, detector_time_delay, ramp_re, ramp_im);
+
+		for (i = 0; i < n; i++) {
+			double re = scale * (in[2*i] * ramp_re[i] - in[2*i+1] * ramp_im[i]);
+			double im = scale * (in[2*i] * ramp_im[i] + in[2*i+1] * ramp_re[i]);
+			GSL_SET_COMPLEX(&out_sp->spa_0[lookup->f_low_index + j0 + i], re, im);
+		}
+	}
+}
+
+void SP_phase(stationary_phase_workspace_t *lookup, inspiral_chirp_time_t *chirp, double time_delay,
+		double inspiral_coalesce_phase, size_t j0, size_t n, double *out_phase) {
+	assert(lookup != NULL);
+	assert(chirp != NULL);
+	assert(j0 + n <= lookup->len);
+	assert(out_phase != NULL);
+
+	size_t j;
+	const double *two_pi_f = lookup->chirp_tc_coeff + j0;
+	const double *u = lookup->u_coeff + j0;
+
+	/* Everything that only depends on the chirp */
+	double t = chirp->tc - time_delay;
+	double c0 = -2.0 * inspiral_coalesce_phase - M_PI / 4.0;
+	double c1 = 2.0 * M_PI * lookup->f_low * 3.0 * chirp->chirp_time2;
+	double c2 = -2.0 * M_PI * lookup->f_low * 1.5 * chirp->chirp_time1_5;
+	double c5 = 2.0 * M_PI * lookup->f_low * (0.6 * chirp->chirp_time0 + chirp->chirp_time1);
+
+	for (j = 0; j < n; j++) {
+		double u3 = u[j] * u[j] * u[j];
+		out_phase[j] = two_pi_f[j] * t + c0 + u[j] * (c1 + u[j] * (c2 + u3 * c5));
+	}
+}
 
-	for (i = 0; i < lookup->len; i++) {
-		double amp_2pn = (1.0 / detector_normalization_factor) * lookup->g_coeff[i];
-
-		double phase_2pn =
-				lookup->chirp_tc_coeff[i] * (chirp->tc - detector_time_delay)
-				- 2.0 * inspiral_coalesce_phase
-				+ lookup->constant_coeff[i]
-				+ lookup->chirp_time_0_coeff[i] * chirp->chirp_time0
-				+ lookup->chirp_time_1_coeff[i] * chirp->chirp_time1
-				+ lookup->chirp_time1_5_coeff[i] * chirp->chirp_time1_5
-				+ lookup->chirp_time2_coeff[i] * chirp->chirp_time2;
-
-		gsl_complex exp_phase = gsl_complex_exp(gsl_complex_rect(0.0, -1.0*phase_2pn));
-		out_sp->spa_0[lookup->f_low_index + i] = gsl_complex_mul_real(exp_phase, amp_2pn);
-		out_sp->spa_90[lookup->f_low_index + i] = gsl_complex_mul_imag(out_sp->spa_0[lookup->f_low_index + i], -1.0);
+void SP_time_delay_ramp(stationary_phase_workspace_t *lookup, size_t j0, size_t n, double time_delay,
+		double *out_re, double *out_im) {
+	assert(lookup != NULL);
+	assert(j0 + n <= lookup->len);
+	assert(out_re != NULL);
+	assert(out_im != NULL);
+
+	size_t k;
+
+	if (lookup->f_step > 0.0) {
+		double step = 2.0 * M_PI * lookup->f_step * time_delay;
+		for (k = 0; k < n; k += SP_RAMP_BLOCK) {
+			size_t m = GSL_MIN(SP_RAMP_BLOCK, n - k);
+			CV_phase_ramp(m, lookup->chirp_tc_coeff[j0 + k] * time_delay, step, out_re + k, out_im + k);
+		}
+	} else {
+		for (k = 0; k < n; k++) {
+			double phase = lookup->chirp_tc_coeff[j0 + k] * time_delay;
+			out_re[k] = cos(phase);
+			out_im[k] = sin(phase);
+		}
 	}
 }
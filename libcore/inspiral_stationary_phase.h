@@ -18,20 +18,27 @@ typedef struct stationary_phase_workspace_s {
 
 	size_t len;
 
-	double *g_coeff;
-	double *chirp_tc_coeff;
-	double *constant_coeff;
-	double *chirp_time_0_coeff;
-	double *chirp_time_1_coeff;
-	double *chirp_time1_5_coeff;
-	double *chirp_time2_coeff;
+	/* Spacing of the band frequencies if they are evenly spaced, otherwise 0. */
+	double f_step;
+
+	/* Per band bin, packed in one block of SP_NUM_COEFF * len doubles (coeff) that the others point into.
+	 * With u = (f / f_low)^(-1/3) the 2PN phase is
+	 *     2 pi f (tc - time_delay) - 2 phi_c - pi / 4 + 2 pi f_low u (3 t2 + u (-3/2 t1.5 + u^3 (3/5 t0 + t1)))
+	 * so only 2 pi f and u are stored, and the chirp times are combined once per chirp (see SP_phase).
+	 */
+	double *coeff;
+	double *g_coeff;			/* f^(-7/6), the amplitude */
+	double *chirp_tc_coeff;		/* 2 pi f */
+	double *u_coeff;			/* (f / f_low)^(-1/3) */
 
 } stationary_phase_workspace_t;
 
+#define SP_NUM_COEFF 3
+
+/* The quadrature template spa_90 = -i spa_0 is not stored. */
 typedef struct stationary_phase_s {
 	size_t 			len;
 	gsl_complex		*spa_0;
-	gsl_complex		*spa_90;
 
 } stationary_phase_t;
 
@@ -64,6 +71,42 @@ void SP_compute(
 		stationary_phase_workspace_t *lookup,
 		stationary_phase_t *out_sp);
 
+/* The template factors into a detector independent (intrinsic) part and a time shift, so for a network
+ *     SP_compute(time_delay, normalization, ...) = SP_apply_time_delay(time_delay, normalization, intrinsic)
+ * with the intrinsic part from SP_compute_intrinsic computed once per chirp.
+ */
+
+/* out_intrinsic->spa_0 = g * exp(-i phase) at the geocenter, i.e. without time delay and normalization. */
+void SP_compute_intrinsic(
+		double inspiral_coalesce_phase, inspiral_chirp_time_t *chirp,
+		stationary_phase_workspace_t *lookup,
+		stationary_phase_t *out_intrinsic);
+
+/* exp(i phase) at the geocenter over the band, as len values of out_re and out_im. This is the intrinsic
+ * template without the amplitude, conj(intrinsic->spa_0) = g * (out_re + i out_im).
+ */
+void SP_compute_phasor(
+		double inspiral_coalesce_phase, inspiral_chirp_time_t *chirp,
+		stationary_phase_workspace_t *lookup,
+		double *out_re, double *out_im);
+
+/* out_sp->spa_0 = intrinsic->spa_0 * exp(i 2 pi f time_delay) / normalization */
+void SP_apply_time_delay(
+		double detector_time_delay, double detector_normalization_factor,
+		stationary_phase_t *intrinsic,
+		stationary_phase_workspace_t *lookup,
+		stationary_phase_t *out_sp);
+
+/* The 2PN phase at the band bins j = j0 .. j0 + n - 1, in Horner form. */
+void SP_phase(stationary_phase_workspace_t *lookup, inspiral_chirp_time_t *chirp, double time_delay,
+		double inspiral_coalesce_phase, size_t j0, size_t n, double *out_phase);
+
+/* exp(i 2 pi f_j time_delay) for the band bins j = j0 .. j0 + n - 1, with f_j relative to f_low_index.
+ * Evenly spaced frequencies use a trig recurrence instead of a sin and cos per bin.
+ */
+void SP_time_delay_ramp(stationary_phase_workspace_t *lookup, size_t j0, size_t n, double time_delay,
+		double *out_re, double *out_im);
+
 void SP_save(char *filename, asd_t *asd, stationary_phase_t *sp);
 
 #if defined (__cplusplus)
@@ -0,0 +1,335 @@
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+	#include <omp.h>
+#endif
+
+#include "inspiral_template_cache.h"
+
+#define TC_NUM_SHARDS 16
+
+/* End of a hash chain or of the LRU list */
+#define TC_NONE ((size_t) -1)
+
+typedef struct template_cache_entry_s {
+	int64_t key0;
+	int64_t key1;
+	size_t chain_next;
+	size_t lru_prev;
+	size_t lru_next;
+} template_cache_entry_t;
+
+typedef struct template_cache_shard_s {
+#ifdef _OPENMP
+	omp_lock_t lock;
+#endif
+	size_t capacity;
+	size_t count;
+
+	/* Each bucket is the first entry of a hash chain. */
+	size_t num_buckets;
+	size_t *buckets;
+
+	template_cache_entry_t *entries;
+
+	/* 2 * template_len doubles per entry */
+	double *templates;
+
+	/* Most and least recently used entries */
+	size_t lru_head;
+	size_t lru_tail;
+
+	size_t hits;
+	size_t misses;
+
+} template_cache_shard_t;
+
+struct template_cache_s {
+	size_t template_len;
+	double quantum;
+	size_t capacity;
+	size_t num_shards;
+	template_cache_shard_t *shards;
+};
+
+static void TC_lock(template_cache_shard_t *shard) {
+#ifdef _OPENMP
+	omp_set_lock(&shard->lock);
+#endif
+}
+
+static void TC_unlock(template_cache_shard_t *shard) {
+#ifdef _OPENMP
+	omp_unset_lock(&shard->lock);
+#endif
+}
+
+static int64_t TC_key(const template_cache_t *cache, double chirp_time) {
+	return (int64_t) floor(chirp_time / cache->quantum + 0.5);
+}
+
+static uint64_t TC_hash(int64_t key0, int64_t key1) {
+	uint64_t h = (uint64_t) key0 * 0x9E3779B97F4A7C15ULL ^ (uint64_t) key1;
+	h ^= h >> 33;
+	h *= 0xFF51AFD7ED558CCDULL;
+	h ^= h >> 33;
+	return h;
+}
+
+static template_cache_shard_t* TC_shard(const template_cache_t *cache, int64_t key0, int64_t key1, size_t *bucket) {
+	uint64_t h = TC_hash(key0, key1);
+	template_cache_shard_t *shard = &cache->shards[h % cache->num_shards];
+
+	*bucket = (h / cache->num_shards) % shard->num_buckets;
+	return shard;
+}
+
+static size_t TC_find(const template_cache_shard_t *shard, size_t bucket, int64_t key0, int64_t key1) {
+	size_t e;
+	for (e = shard->buckets[bucket]; e != TC_NONE; e = shard->entries[e].chain_next) {
+		if (shard->entries[e].key0 == key0 && shard->entries[e].key1 == key1) {
+			break;
+		}
+	}
+	return e;
+}
+
+static void TC_lru_unlink(template_cache_shard_t *shard, size_t e) {
+	template_cache_entry_t *entry = &shard->entries[e];
+
+	if (entry->lru_prev != TC_NONE) {
+		shard->entries[entry->lru_prev].lru_next = entry->lru_next;
+	} else {
+		shard->lru_head = entry->lru_next;
+	}
+
+	if (entry->lru_next != TC_NONE) {
+		shard->entries[entry->lru_next].lru_prev = entry->lru_prev;
+	} else {
+		shard->lru_tail = entry->lru_prev;
+	}
+}
+
+static void TC_lru_push_front(template_cache_shard_t *shard, size_t e) {
+	shard->entries[e].lru_prev = TC_NONE;
+	shard->entries[e].lru_next = shard->lru_head;
+
+	if (shard->lru_head != TC_NONE) {
+		shard->entries[shard->lru_head].lru_prev = e;
+	} else {
+		shard->lru_tail = e;
+	}
+	shard->lru_head = e;
+}
+
+/* Removes the least recently used entry from its hash chain and the LRU list, and returns it. */
+static size_t TC_evict(const template_cache_t *cache, template_cache_shard_t *shard) {
+	size_t e = shard->lru_tail;
+	size_t bucket;
+	size_t *link;
+
+	TC_shard(cache, shard->entries[e].key0, shard->entries[e].key1, &bucket);
+	for (link = &shard->buckets[bucket]; *link != e; link = &shard->entries[*link].chain_next) {
+		assert(*link != TC_NONE);
+	}
+	*link = shard->entries[e].chain_next;
+
+	TC_lru_unlink(shard, e);
+	return e;
+}
+
+template_cache_t* TC_alloc(size_t template_len, size_t max_bytes, double quantum) {
+	assert(template_len > 0);
+	assert(quantum > 0.0);
+
+	size_t s, b;
+	size_t entry_bytes = 2 * template_len * sizeof(double) + sizeof(template_cache_entry_t) + sizeof(size_t);
+
+	template_cache_t *cache = (template_cache_t*) malloc( sizeof(template_cache_t) );
+	if (cache == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the template_cache_t. Exiting.\n");
+		exit(-1);
+	}
+
+	cache->template_len = template_len;
+	cache->quantum = quantum;
+
+	cache->capacity = max_bytes / entry_bytes;
+	if (cache->capacity == 0) {
+		fprintf(stderr, "Error. The template cache needs at least %lu bytes for one template. Exiting.\n", entry_bytes);
+		exit(-1);
+	}
+
+	cache->num_shards = cache->capacity < TC_NUM_SHARDS ? cache->capacity : TC_NUM_SHARDS;
+	cache->shards = (template_cache_shard_t*) malloc( cache->num_shards * sizeof(template_cache_shard_t) );
+	if (cache->shards == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the template cache shards. Exiting.\n");
+		exit(-1);
+	}
+
+	for (s = 0; s < cache->num_shards; s++) {
+		template_cache_shard_t *shard = &cache->shards[s];
+
+		/* Spread the capacity over the shards without going over max_bytes */
+		shard->capacity = cache->capacity / cache->num_shards + (s < cache->capacity % cache->num_shards ? 1 : 0);
+		shard->count = 0;
+		shard->num_buckets = shard->capacity;
+		shard->lru_head = TC_NONE;
+		shard->lru_tail = TC_NONE;
+		shard->hits = 0;
+		shard->misses = 0;
+
+		shard->buckets = (size_t*) malloc( shard->num_buckets * sizeof(size_t) );
+		shard->entries = (template_cache_entry_t*) malloc( shard->capacity * sizeof(template_cache_entry_t) );
+		shard->templates = (double*) malloc( shard->capacity * 2 * template_len * sizeof(double) );
+		if (shard->buckets == NULL || shard->entries == NULL || shard->templates == NULL) {
+			fprintf(stderr, "Error. Unable to allocate memory for the template cache. Exiting.\n");
+			exit(-1);
+		}
+
+		for (b = 0; b < shard->num_buckets; b++) {
+			shard->buckets[b] = TC_NONE;
+		}
+
+#ifdef _OPENMP
+		omp_init_lock(&shard->lock);
+#endif
+	}
+
+	return cache;
+}
+
+void TC_free(template_cache_t *cache) {
+	assert(cache != NULL);
+
+	size_t s;
+	for (s = 0; s < cache->num_shards; s++) {
+		template_cache_shard_t *shard = &cache->shards[s];
+#ifdef _OPENMP
+		omp_destroy_lock(&shard->lock);
+#endif
+		free(shard->buckets);
+		free(shard->entries);
+		free(shard->templates);
+	}
+
+	free(cache->shards);
+	cache->shards = NULL;
+
+	free(cache);
+}
+
+size_t TC_template_len(const template_cache_t *cache) {
+	assert(cache != NULL);
+	return cache->template_len;
+}
+
+size_t TC_capacity(const template_cache_t *cache) {
+	assert(cache != NULL);
+	return cache->capacity;
+}
+
+void TC_snap(const template_cache_t *cache, double *chirp_time0, double *chirp_time1_5) {
+	assert(cache != NULL);
+	assert(chirp_time0 != NULL);
+	assert(chirp_time1_5 != NULL);
+
+	*chirp_time0 = TC_key(cache, *chirp_time0) * cache->quantum;
+	*chirp_time1_5 = TC_key(cache, *chirp_time1_5) * cache->quantum;
+}
+
+int TC_get(template_cache_t *cache, double chirp_time0, double chirp_time1_5, double *out_re, double *out_im) {
+	assert(cache != NULL);
+	assert(out_re != NULL);
+	assert(out_im != NULL);
+
+	size_t bucket, e;
+	int64_t key0 = TC_key(cache, chirp_time0);
+	int64_t key1 = TC_key(cache, chirp_time1_5);
+	template_cache_shard_t *shard = TC_shard(cache, key0, key1, &bucket);
+	size_t len = cache->template_len;
+
+	TC_lock(shard);
+	e = TC_find(shard, bucket, key0, key1);
+	if (e != TC_NONE) {
+		const double *t = shard->templates + e * 2 * len;
+		memcpy(out_re, t, len * sizeof(double));
+		memcpy(out_im, t + len, len * sizeof(double));
+
+		TC_lru_unlink(shard, e);
+		TC_lru_push_front(shard, e);
+		shard->hits++;
+	} else {
+		shard->misses++;
+	}
+	TC_unlock(shard);
+
+	return e != TC_NONE;
+}
+
+void TC_put(template_cache_t *cache, double chirp_time0, double chirp_time1_5, const double *re, const double *im) {
+	assert(cache != NULL);
+	assert(re != NULL);
+	assert(im != NULL);
+
+	size_t bucket, e;
+	int64_t key0 = TC_key(cache, chirp_time0);
+	int64_t key1 = TC_key(cache, chirp_time1_5);
+	template_cache_shard_t *shard = TC_shard(cache, key0, key1, &bucket);
+	size_t len = cache->template_len;
+
+	TC_lock(shard);
+
+	/* Another thread may have stored it since the miss. */
+	if (TC_find(shard, bucket, key0, key1) == TC_NONE) {
+		if (shard->count < shard->capacity) {
+			e = shard->count++;
+		} else {
+			e = TC_evict(cache, shard);
+		}
+
+		shard->entries[e].key0 = key0;
+		shard->entries[e].key1 = key1;
+		memcpy(shard->templates + e * 2 * len, re, len * sizeof(double));
+		memcpy(shard->templates + e * 2 * len + len, im, len * sizeof(double));
+
+		shard->entries[e].chain_next = shard->buckets[bucket];
+		shard->buckets[bucket] = e;
+		TC_lru_push_front(shard, e);
+	}
+
+	TC_unlock(shard);
+}
+
+size_t TC_hits(template_cache_t *cache) {
+	assert(cache != NULL);
+
+	size_t s, total = 0;
+	for (s = 0; s < cache->num_shards; s++) {
+		TC_lock(&cache->shards[s]);
+		total += cache->shards[s].hits;
+		TC_unlock(&cache->shards[s]);
+	}
+	return total;
+}
+
+size_t TC_misses(template_cache_t *cache) {
+	assert(cache != NULL);
+
+	size_t s, total = 0;
+	for (s = 0; s < cache->num_shards; s++) {
+		TC_lock(&cache->shards[s]);
+		total += cache->shards[s].misses;
+		TC_unlock(&cache->shards[s]);
+	}
+	return total;
+}
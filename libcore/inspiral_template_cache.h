@@ -0,0 +1,48 @@
+#ifndef SRC_C_INSPIRAL_TEMPLATE_CACHE_H_
+#define SRC_C_INSPIRAL_TEMPLATE_CACHE_H_
+
+#include <stddef.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* Bounded cache of intrinsic (geocenter, coalescence phase 0) templates, keyed on (chirp_time0, chirp_time1_5)
+ * rounded to a grid of spacing quantum seconds. An entry holds exp(i phase) over the band bins as
+ * template_len cosines followed by template_len sines (see SP_compute_phasor).
+ *
+ * One cache is shared by all the threads of a search. It is split into shards, each with its own lock,
+ * hash table and least recently used list, so threads only contend when their keys fall in the same shard.
+ * The chirp times should be snapped to the grid with TC_snap before the template is computed, so that every
+ * point in a grid cell gets the same template whichever thread filled the entry.
+ */
+typedef struct template_cache_s template_cache_t;
+
+/* max_bytes bounds the memory used by the entries. It must hold at least one template. */
+template_cache_t* TC_alloc(size_t template_len, size_t max_bytes, double quantum);
+
+void TC_free(template_cache_t *cache);
+
+size_t TC_template_len(const template_cache_t *cache);
+
+/* Number of templates the cache holds before it starts evicting. */
+size_t TC_capacity(const template_cache_t *cache);
+
+/* Rounds the chirp times to the cache grid. */
+void TC_snap(const template_cache_t *cache, double *chirp_time0, double *chirp_time1_5);
+
+/* Copies the cached template into out_re and out_im (template_len each) and returns 1, or returns 0 on a miss. */
+int TC_get(template_cache_t *cache, double chirp_time0, double chirp_time1_5, double *out_re, double *out_im);
+
+/* Stores a template, evicting the least recently used one of its shard if the shard is full. */
+void TC_put(template_cache_t *cache, double chirp_time0, double chirp_time1_5, const double *re, const double *im);
+
+size_t TC_hits(template_cache_t *cache);
+
+size_t TC_misses(template_cache_t *cache);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* SRC_C_INSPIRAL_TEMPLATE_CACHE_H_ */
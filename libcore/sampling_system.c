@@ -2,6 +2,7 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <gsl/gsl_complex.h>
 #include <gsl/gsl_complex_math.h>
@@ -59,9 +60,7 @@ void SS_make_two_sided (size_t M, gsl_complex *one_sided, size_t N, gsl_complex
 	}
 
 	/* copy the left side */
-	for (m = 0; m < M; m++) {
-		two_sided[m] = one_sided[m];
-	}
+	memcpy(two_sided, one_sided, M * sizeof(gsl_complex));
 
 	/* if a Nyquist term is present, then don't mirror it. */
 	size_t c = M - 1;
@@ -71,7 +70,7 @@ void SS_make_two_sided (size_t M, gsl_complex *one_sided, size_t N, gsl_complex
 
 	/* make the mirror of the left side */
 	for (n = M, m = c; n < N; n++, m--) {
-		two_sided[n] = gsl_complex_conjugate( one_sided[m] );
+		GSL_SET_COMPLEX(&two_sided[n], GSL_REAL(one_sided[m]), -GSL_IMAG(one_sided[m]));
 	}
 }
 
@@ -98,9 +97,7 @@ void SS_make_two_sided_real (size_t M, double *one_sided, size_t N, double *two_
 	}
 
 	/* copy the left side */
-	for (m = 0; m < M; m++) {
-		two_sided[m] = one_sided[m];
-	}
+	memcpy(two_sided, one_sided, M * sizeof(double));
 
 	/* if a Nyquist term is present, then don't mirror it. */
 	size_t c = M - 1;
@@ -136,108 +133,123 @@ void SS_time_array(double samplingFrequency, size_t num_desired_time_samples, do
 	}
 }
 
-/* This function colours a time series by multiplying by the ASD in the frequency domain */
-void SS_colour_timeseries( psd_t *psd_one_sided, size_t num_time_samples, double *timeseries) {
-	assert(psd_one_sided != NULL);
-	assert(timeseries != NULL);
-
+/* Multiplies (or divides, if invert is set) the spectrum of a real time series by a real gain given on the
+ * one-sided frequencies. The mirrored frequencies get the same gain, so a real transform of the series is
+ * enough: GSL arranges its output as the DC term, then REAL, IMAG pairs, then the Nyquist term if present.
+ */
+static void SS_filter_timeseries( size_t num_time_samples, const double *one_sided_gain, int invert, double *timeseries) {
 	size_t k, l;
+	size_t len = SS_half_size( num_time_samples );
 
-	if (psd_one_sided->type != PSD_ONE_SIDED) {
-		fprintf(stderr, "SS_colour_timeseries: Error. Algorithm only works with one_sided PSD. Exiting.\n");
-		exit(-1);
+	gsl_fft_real_wavetable *fft_real_wavetable = gsl_fft_real_wavetable_alloc( num_time_samples );
+	gsl_fft_halfcomplex_wavetable *fft_complex_wavetable = gsl_fft_halfcomplex_wavetable_alloc( num_time_samples );
+	gsl_fft_real_workspace *fft_workspace = gsl_fft_real_workspace_alloc( num_time_samples );
+
+	gsl_fft_real_transform(timeseries, 1, num_time_samples, fft_real_wavetable, fft_workspace);
+
+	size_t lu = SS_last_unique_index( num_time_samples );
+	if (SS_has_nyquist_term(num_time_samples)) {
+		lu--;
 	}
 
-	if (SS_half_size(num_time_samples) != psd_one_sided->len) {
-		fprintf(stderr, "SS_colour_timeseries: Error. The PSD length doesn't match the half-size of the timeseries. Exiting.");
-		exit(-1);
+	if (invert) {
+		timeseries[0] /= one_sided_gain[0];
+		for (k = 1, l = 1; l <= lu; k+=2, l++) {
+			timeseries[k+0] /= one_sided_gain[l];
+			timeseries[k+1] /= one_sided_gain[l];
+		}
+		if (SS_has_nyquist_term(num_time_samples)) {
+			timeseries[num_time_samples-1] /= one_sided_gain[len-1];
+		}
+	} else {
+		timeseries[0] *= one_sided_gain[0];
+		for (k = 1, l = 1; l <= lu; k+=2, l++) {
+			timeseries[k+0] *= one_sided_gain[l];
+			timeseries[k+1] *= one_sided_gain[l];
+		}
+		if (SS_has_nyquist_term(num_time_samples)) {
+			timeseries[num_time_samples-1] *= one_sided_gain[len-1];
+		}
 	}
 
+	gsl_fft_halfcomplex_inverse( timeseries, 1, num_time_samples, fft_complex_wavetable, fft_workspace );
+
+	gsl_fft_real_workspace_free( fft_workspace );
+	gsl_fft_halfcomplex_wavetable_free( fft_complex_wavetable );
+	gsl_fft_real_wavetable_free( fft_real_wavetable );
+}
+
+/* The gain is the ASD, with the factor of 1/sqrt(2) on every term that has a mirrored partner. */
+static double* SS_asd_gain( psd_t *psd_one_sided, size_t num_time_samples) {
+	size_t l;
+
 	asd_t * asd_one_sided = ASD_alloc( psd_one_sided->len );
 	ASD_init_from_psd( psd_one_sided, asd_one_sided );
 
-	gsl_fft_real_wavetable *fft_real_wavetable = gsl_fft_real_wavetable_alloc( num_time_samples );
-	gsl_fft_halfcomplex_wavetable *fft_complex_wavetable = gsl_fft_halfcomplex_wavetable_alloc( num_time_samples );
-	gsl_fft_real_workspace *fft_workspace = gsl_fft_real_workspace_alloc( num_time_samples );
-
-	gsl_fft_real_transform(timeseries, 1, num_time_samples, fft_real_wavetable, fft_workspace);
+	double *gain = (double*) malloc( asd_one_sided->len * sizeof(double) );
+	if (gain == NULL) {
+		fprintf(stderr, "Error. SS_asd_gain: Unable to allocate memory. Exiting.\n");
+		exit(-1);
+	}
 
 	// DC term doesn't have an imaginary component
-	timeseries[0] *= asd_one_sided->asd[0];
+	gain[0] = asd_one_sided->asd[0];
 
 	size_t lu = SS_last_unique_index( num_time_samples );
 	if (SS_has_nyquist_term(num_time_samples)) {
 		lu--;
 	}
 
-	/* The GSL fft arranges the data as REAL, IMAG pairs except for the DC and Nyquist Terms. */
-	for (k = 1, l = 1; l <= lu; k+=2, l++) {
-		double s = asd_one_sided->asd[l] / sqrt(2.0);
-		timeseries[k+0] *= s;
-		timeseries[k+1] *= s;
+	for (l = 1; l <= lu; l++) {
+		gain[l] = asd_one_sided->asd[l] / sqrt(2.0);
 	}
 
 	// If nyquist term is present, it doesn't have an imaginary component
 	if (SS_has_nyquist_term(num_time_samples)) {
-		timeseries[num_time_samples-1] *= asd_one_sided->asd[asd_one_sided->len-1];
+		gain[asd_one_sided->len-1] = asd_one_sided->asd[asd_one_sided->len-1];
 	}
 
-	gsl_fft_halfcomplex_inverse( timeseries, 1, num_time_samples, fft_complex_wavetable, fft_workspace );
+	ASD_free( asd_one_sided );
 
-	gsl_fft_real_workspace_free( fft_workspace );
-	gsl_fft_halfcomplex_wavetable_free( fft_complex_wavetable );
-	gsl_fft_real_wavetable_free( fft_real_wavetable );
+	return gain;
 }
 
-/* This function whitens a time series by dividing by the ASD in the frequency domain */
-void SS_whiten_timeseries( psd_t *psd_one_sided, size_t num_time_samples, double *timeseries) {
+/* This function colours a time series by multiplying by the ASD in the frequency domain */
+void SS_colour_timeseries( psd_t *psd_one_sided, size_t num_time_samples, double *timeseries) {
 	assert(psd_one_sided != NULL);
 	assert(timeseries != NULL);
 
-	size_t k, l;
-
 	if (psd_one_sided->type != PSD_ONE_SIDED) {
-		fprintf(stderr, "SS_whiten_timeseries: Error. Algorithm only works with one_sided PSD. Exiting.\n");
+		fprintf(stderr, "SS_colour_timeseries: Error. Algorithm only works with one_sided PSD. Exiting.\n");
 		exit(-1);
 	}
 
 	if (SS_half_size(num_time_samples) != psd_one_sided->len) {
-		fprintf(stderr, "SS_whiten_timeseries: Error. The PSD length doesn't match the half-size of the timeseries. Exiting.");
+		fprintf(stderr, "SS_colour_timeseries: Error. The PSD length doesn't match the half-size of the timeseries. Exiting.");
 		exit(-1);
 	}
 
-	asd_t * asd_one_sided = ASD_alloc( psd_one_sided->len );
-	ASD_init_from_psd( psd_one_sided, asd_one_sided );
-
-	gsl_fft_real_wavetable *fft_real_wavetable = gsl_fft_real_wavetable_alloc( num_time_samples );
-	gsl_fft_halfcomplex_wavetable *fft_complex_wavetable = gsl_fft_halfcomplex_wavetable_alloc( num_time_samples );
-	gsl_fft_real_workspace *fft_workspace = gsl_fft_real_workspace_alloc( num_time_samples );
-
-	gsl_fft_real_transform(timeseries, 1, num_time_samples, fft_real_wavetable, fft_workspace);
-
-	// DC term doesn't have an imaginary component
-	timeseries[0] /= asd_one_sided->asd[0];
+	double *gain = SS_asd_gain( psd_one_sided, num_time_samples );
+	SS_filter_timeseries( num_time_samples, gain, 0, timeseries );
+	free(gain);
+}
 
-	size_t lu = SS_last_unique_index( num_time_samples );
-	if (SS_has_nyquist_term(num_time_samples)) {
-		lu--;
-	}
+/* This function whitens a time series by dividing by the ASD in the frequency domain */
+void SS_whiten_timeseries( psd_t *psd_one_sided, size_t num_time_samples, double *timeseries) {
+	assert(psd_one_sided != NULL);
+	assert(timeseries != NULL);
 
-	/* The GSL fft arranges the data as REAL, IMAG pairs except for the DC and Nyquist Terms. */
-	for (k = 1, l = 1; l <= lu; k+=2, l++) {
-		double s = asd_one_sided->asd[l] / sqrt(2.0);
-		timeseries[k+0] /= s;
-		timeseries[k+1] /= s;
+	if (psd_one_sided->type != PSD_ONE_SIDED) {
+		fprintf(stderr, "SS_whiten_timeseries: Error. Algorithm only works with one_sided PSD. Exiting.\n");
+		exit(-1);
 	}
 
-	// If nyquist term is present, it doesn't have an imaginary component
-	if (SS_has_nyquist_term(num_time_samples)) {
-		timeseries[num_time_samples-1] /= asd_one_sided->asd[asd_one_sided->len-1];
+	if (SS_half_size(num_time_samples) != psd_one_sided->len) {
+		fprintf(stderr, "SS_whiten_timeseries: Error. The PSD length doesn't match the half-size of the timeseries. Exiting.");
+		exit(-1);
 	}
 
-	gsl_fft_halfcomplex_inverse( timeseries, 1, num_time_samples, fft_complex_wavetable, fft_workspace );
-
-	gsl_fft_real_workspace_free( fft_workspace );
-	gsl_fft_halfcomplex_wavetable_free( fft_complex_wavetable );
-	gsl_fft_real_wavetable_free( fft_real_wavetable );
+	double *gain = SS_asd_gain( psd_one_sided, num_time_samples );
+	SS_filter_timeseries( num_time_samples, gain, 1, timeseries );
+	free(gain);
 }
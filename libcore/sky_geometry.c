@@ -0,0 +1,229 @@
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <gsl/gsl_const_mksa.h>
+#include <gsl/gsl_math.h>
+#include <gsl/gsl_matrix.h>
+#include <gsl/gsl_vector.h>
+
+#include "sky_geometry.h"
+
+sky_geometry_t* SG_alloc(detector_network_t *net) {
+	assert(net != NULL);
+
+	size_t i, r, c;
+	size_t num_detectors = net->num_detectors;
+
+	sky_geometry_t *geometry = (sky_geometry_t*) malloc( sizeof(sky_geometry_t) );
+	if (geometry == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the sky_geometry_t. Exiting.\n");
+		exit(-1);
+	}
+
+	geometry->num_detectors = num_detectors;
+	geometry->tensor = (double*) malloc( 9 * num_detectors * sizeof(double) );
+	geometry->location = (double*) malloc( 3 * num_detectors * sizeof(double) );
+	geometry->u = (double*) malloc( num_detectors * sizeof(double) );
+	geometry->v = (double*) malloc( num_detectors * sizeof(double) );
+	geometry->time_delay = (double*) malloc( num_detectors * sizeof(double) );
+	if (geometry->tensor == NULL || geometry->location == NULL || geometry->u == NULL || geometry->v == NULL
+			|| geometry->time_delay == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory in SG_alloc(). Exiting.\n");
+		exit(-1);
+	}
+
+	for (i = 0; i < num_detectors; i++) {
+		detector_t *det = net->detector[i];
+		for (r = 0; r < 3; r++) {
+			for (c = 0; c < 3; c++) {
+				geometry->tensor[9*i + 3*r + c] = gsl_matrix_get(det->detector_tensor, r, c);
+			}
+			geometry->location[3*i + r] = gsl_vector_get(det->location, r) / GSL_CONST_MKSA_SPEED_OF_LIGHT;
+		}
+	}
+
+	return geometry;
+}
+
+void SG_free(sky_geometry_t *geometry) {
+	assert(geometry != NULL);
+
+	free(geometry->tensor);
+	free(geometry->location);
+	free(geometry->u);
+	free(geometry->v);
+	free(geometry->time_delay);
+	free(geometry);
+}
+
+/* a.D.b for a 3x3 row major D */
+static double SG_quadratic_form(const double *D, const double *a, const double *b) {
+	return a[0] * (D[0] * b[0] + D[1] * b[1] + D[2] * b[2])
+		 + a[1] * (D[3] * b[0] + D[4] * b[1] + D[5] * b[2])
+		 + a[2] * (D[6] * b[0] + D[7] * b[1] + D[8] * b[2]);
+}
+
+/* The matrix O from the network vectors u and v, as in the Matlab code. */
+static void SG_network_matrix(sky_geometry_t *geometry) {
+	size_t i;
+	double A = 0.0, B = 0.0, C = 0.0;
+
+	for (i = 0; i < geometry->num_detectors; i++) {
+		A += geometry->u[i] * geometry->u[i];
+		B += geometry->u[i] * geometry->v[i];
+		C += geometry->v[i] * geometry->v[i];
+	}
+
+	double Delta = (A*C) - (B*B);
+	double Delta_factor = 1.0 / sqrt(2.0*Delta);
+
+	double D = sqrt( gsl_pow_2(A-C) + 4.0*gsl_pow_2(B) );
+
+	double P1 = (C-A-D);
+	double P2 = (C-A+D);
+	double P3 = sqrt(C+A+D);
+	double P4 = sqrt(C+A-D);
+
+	double G1 = sqrt( gsl_pow_2(P1) + 4.0*gsl_pow_2(B) ) / (2.0*B);
+	double G2 = sqrt( gsl_pow_2(P2) + 4.0*gsl_pow_2(B) ) / (2.0*B);
+
+	geometry->o11 = Delta_factor * P3 / G1;
+	geometry->o12 = Delta_factor * P3 * P1 / (2.0*B*G1);
+	geometry->o21 = Delta_factor * P4 / G2;
+	geometry->o22 = Delta_factor * P4 * P2 / (2.0*B*G2);
+}
+
+/* u, v and time delays of every detector at one sky position, without O. */
+static void SG_detectors(const sky_geometry_t *geometry, sky_t *sky, double *u, double *v, double *time_delay) {
+	size_t i;
+	double cos_ra = cos(sky->ra), sin_ra = sin(sky->ra);
+	double cos_dec = cos(sky->dec), sin_dec = sin(sky->dec);
+
+	double n_hat[3] = { cos_ra * cos_dec, sin_ra * cos_dec, sin_dec };
+	double ex[3] = { sin_ra, -cos_ra, 0.0 };
+	double ey[3] = { -cos_ra * sin_dec, -sin_ra * sin_dec, cos_dec };
+
+	for (i = 0; i < geometry->num_detectors; i++) {
+		const double *D = geometry->tensor + 9*i;
+		const double *x = geometry->location + 3*i;
+
+		u[i] = SG_quadratic_form(D, ex, ex) - SG_quadratic_form(D, ey, ey);
+		v[i] = SG_quadratic_form(D, ex, ey) + SG_quadratic_form(D, ey, ex);
+		time_delay[i] = x[0] * n_hat[0] + x[1] * n_hat[1] + x[2] * n_hat[2];
+	}
+}
+
+void SG_compute(sky_geometry_t *geometry, sky_t *sky) {
+	assert(geometry != NULL);
+	assert(sky != NULL);
+
+	SG_detectors(geometry, sky, geometry->u, geometry->v, geometry->time_delay);
+	SG_network_matrix(geometry);
+}
+
+sky_geometry_table_t* SG_table_alloc(detector_network_t *net, size_t num_ra, size_t num_dec) {
+	assert(net != NULL);
+
+	size_t a, d;
+
+	if (num_ra < 2 || num_dec < 2) {
+		fprintf(stderr, "Error. The sky geometry table needs at least 2 points in right ascension and declination. Exiting.\n");
+		exit(-1);
+	}
+
+	sky_geometry_table_t *table = (sky_geometry_table_t*) malloc( sizeof(sky_geometry_table_t) );
+	if (table == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the sky_geometry_table_t. Exiting.\n");
+		exit(-1);
+	}
+
+	table->num_detectors = net->num_detectors;
+	table->num_ra = num_ra;
+	table->num_dec = num_dec;
+	table->ra_step = 2.0 * M_PI / num_ra;
+	table->dec_step = M_PI / (num_dec - 1);
+
+	size_t node_len = 3 * table->num_detectors;
+	table->nodes = (double*) malloc( num_ra * num_dec * node_len * sizeof(double) );
+	if (table->nodes == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the sky geometry table nodes. Exiting.\n");
+		exit(-1);
+	}
+
+	sky_geometry_t *geometry = SG_alloc(net);
+	for (d = 0; d < num_dec; d++) {
+		for (a = 0; a < num_ra; a++) {
+			double *node = table->nodes + (d * num_ra + a) * node_len;
+			sky_t sky;
+			sky.ra = -M_PI + a * table->ra_step;
+			sky.dec = -0.5 * M_PI + d * table->dec_step;
+
+			SG_detectors(geometry, &sky, node, node + table->num_detectors, node + 2 * table->num_detectors);
+		}
+	}
+	SG_free(geometry);
+
+	return table;
+}
+
+void SG_table_free(sky_geometry_table_t *table) {
+	assert(table != NULL);
+
+	free(table->nodes);
+	table->nodes = NULL;
+
+	free(table);
+}
+
+void SG_table_lookup(const sky_geometry_table_t *table, sky_t *sky, sky_geometry_t *geometry) {
+	assert(table != NULL);
+	assert(sky != NULL);
+	assert(geometry != NULL);
+	assert(geometry->num_detectors == table->num_detectors);
+
+	size_t i;
+	size_t num_detectors = table->num_detectors;
+	size_t node_len = 3 * num_detectors;
+
+	/* Right ascension wraps around, declination is clamped to the poles. */
+	double x = (sky->ra + M_PI) / table->ra_step;
+	double fx = floor(x);
+	double tx = x - fx;
+	long ia = ((long) fx) % (long) table->num_ra;
+	if (ia < 0) {
+		ia += table->num_ra;
+	}
+	size_t a0 = (size_t) ia;
+	size_t a1 = (a0 + 1) % table->num_ra;
+
+	double y = (sky->dec + 0.5 * M_PI) / table->dec_step;
+	if (y < 0.0) {
+		y = 0.0;
+	} else if (y > table->num_dec - 1) {
+		y = table->num_dec - 1;
+	}
+	size_t d0 = GSL_MIN( (size_t) y, table->num_dec - 2 );
+	double ty = y - d0;
+
+	const double *n00 = table->nodes + (d0 * table->num_ra + a0) * node_len;
+	const double *n01 = table->nodes + (d0 * table->num_ra + a1) * node_len;
+	const double *n10 = table->nodes + ((d0 + 1) * table->num_ra + a0) * node_len;
+	const double *n11 = table->nodes + ((d0 + 1) * table->num_ra + a1) * node_len;
+
+	double w00 = (1.0 - tx) * (1.0 - ty);
+	double w01 = tx * (1.0 - ty);
+	double w10 = (1.0 - tx) * ty;
+	double w11 = tx * ty;
+
+	for (i = 0; i < num_detectors; i++) {
+		geometry->u[i] = w00 * n00[i] + w01 * n01[i] + w10 * n10[i] + w11 * n11[i];
+		geometry->v[i] = w00 * n00[num_detectors + i] + w01 * n01[num_detectors + i]
+				+ w10 * n10[num_detectors + i] + w11 * n11[num_detectors + i];
+		geometry->time_delay[i] = w00 * n00[2*num_detectors + i] + w01 * n01[2*num_detectors + i]
+				+ w10 * n10[2*num_detectors + i] + w11 * n11[2*num_detectors + i];
+	}
+
+	SG_network_matrix(geometry);
+}
@@ -0,0 +1,74 @@
+#ifndef SRC_C_SKY_GEOMETRY_H_
+#define SRC_C_SKY_GEOMETRY_H_
+
+#include <stddef.h>
+
+#include "detector_network.h"
+#include "sky.h"
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* Everything the network statistic needs from the sky position: the polarization independent antenna
+ * patterns u and v and the time delay of each detector, and the matrix O that makes the network vectors
+ * (u, v) orthonormal, w_plus = O11 u + O12 v and w_minus = O21 u + O22 v.
+ *
+ * With n the direction to the source and ex, ey the polarization basis in the plane of the sky,
+ *     u = ex.D.ex - ey.D.ey,   v = ex.D.ey + ey.D.ex,   time delay = location.n / c
+ * for the detector tensor D. This is Detector_Antenna_Patterns_compute and Detector_time_delay without
+ * the matrix products.
+ */
+typedef struct sky_geometry_s {
+	size_t num_detectors;
+
+	/* Per detector, the detector tensor (row major, 9 values) and the location divided by c (3 values). */
+	double *tensor;
+	double *location;
+
+	/* Filled by SG_compute or SG_table_lookup */
+	double *u;
+	double *v;
+	double *time_delay;
+	double o11, o12, o21, o22;
+
+} sky_geometry_t;
+
+sky_geometry_t* SG_alloc(detector_network_t *net);
+
+void SG_free(sky_geometry_t *geometry);
+
+/* Closed form evaluation at one sky position. */
+void SG_compute(sky_geometry_t *geometry, sky_t *sky);
+
+/* u, v and the time delay of every detector on a grid of num_ra right ascensions covering [-pi, pi) and
+ * num_dec declinations covering [-pi/2, pi/2]. Built once per network and read only after that, so it can be
+ * shared between threads.
+ */
+typedef struct sky_geometry_table_s {
+	size_t num_detectors;
+	size_t num_ra;
+	size_t num_dec;
+	double ra_step;
+	double dec_step;
+
+	/* 3 * num_detectors values per node (u, v and time delays), right ascension varying fastest. */
+	double *nodes;
+
+} sky_geometry_table_t;
+
+sky_geometry_table_t* SG_table_alloc(detector_network_t *net, size_t num_ra, size_t num_dec);
+
+void SG_table_free(sky_geometry_table_t *table);
+
+/* Bilinear interpolation of u, v and the time delays, after which O is formed from the interpolated u and v.
+ * The error is second order in the grid steps; a one degree grid gives u and v to about 2e-4
+ * and the time delays to about 1.5e-6 s.
+ */
+void SG_table_lookup(const sky_geometry_table_t *table, sky_t *sky, sky_geometry_t *geometry);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* SRC_C_SKY_GEOMETRY_H_ */
@@ -1,13 +1,28 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <gsl/gsl_complex.h>
-#include <gsl/gsl_fft_complex.h>
 
+#include "fft.h"
 #include "sampling_system.h"
 #include "strain.h"
 
+/* The last generation handed out to a network strain */
+static size_t strain_generation = 0;
+
+static size_t network_strain_next_generation() {
+	size_t generation;
+
+#ifdef _OPENMP
+	#pragma omp critical (strain_generation)
+#endif
+	generation = ++strain_generation;
+
+	return generation;
+}
+
 strain_half_fft_t* strain_half_fft_alloc(size_t num_time_samples) {
 	strain_half_fft_t *signal = (strain_half_fft_t*) malloc( sizeof(strain_half_fft_t) );
 	if (signal == NULL) {
@@ -94,12 +109,10 @@ strain_full_fft_t* strain_half_to_full(strain_half_fft_t *one_sided) {
 
 strain_t* strain_full_fft_to_strain( strain_full_fft_t* fft) {
 	size_t j;
-	gsl_fft_complex_wavetable *fft_wavetable;
-	gsl_fft_complex_workspace *fft_workspace;
-	fft_wavetable = gsl_fft_complex_wavetable_alloc( fft->full_len );
-	fft_workspace = gsl_fft_complex_workspace_alloc( fft->full_len );
+	fft_plan_t *plan = FFT_plan_get( fft->full_len, FFT_BACKWARD, FFT_DOUBLE );
+	fft_workspace_t *fft_workspace = FFT_workspace_alloc( fft->full_len );
 
-	/* GSL needs an input linear array arranged as (real, complex) pairs in sequence. */
+	/* The FFT needs an input linear array arranged as (real, complex) pairs in sequence. */
 	double *template_ifft = (double*) malloc( 2 * fft->full_len * sizeof(double) );
 	if (template_ifft == NULL) {
 		fprintf(stderr, "Error. Unable to allocate memory for the template_ifft. Aborting.\n");
@@ -111,23 +124,29 @@ strain_t* strain_full_fft_to_strain( strain_full_fft_t* fft) {
 	}
 
 	/* Compute the ifft */
-	gsl_fft_complex_inverse( template_ifft, 1, fft->full_len, fft_wavetable, fft_workspace );
+	FFT_execute( plan, template_ifft, fft_workspace );
 
 	strain_t *strain = strain_alloc(fft->full_len);
 
 	for (j = 0; j < fft->full_len; j++) {
-		/* Only save the real part */
-		strain->samples[j] = template_ifft[2*j + 0];
+		/* Only save the real part. The backward transform is unnormalized. */
+		strain->samples[j] = template_ifft[2*j + 0] / fft->full_len;
 	}
 
 	free(template_ifft);
-	gsl_fft_complex_workspace_free( fft_workspace );
-	gsl_fft_complex_wavetable_free( fft_wavetable );
+	FFT_workspace_free( fft_workspace );
 
 	return strain;
 }
 
 network_strain_half_fft_t* network_strain_half_fft_alloc(size_t num_strains, size_t num_time_samples) {
+	return network_strain_half_fft_alloc_realizations(num_strains, num_time_samples, 1);
+}
+
+network_strain_half_fft_t* network_strain_half_fft_alloc_realizations(size_t num_strains, size_t num_time_samples,
+		size_t num_realizations) {
+	assert(num_realizations > 0);
+
 	size_t i;
 
 	network_strain_half_fft_t *network_strain = (network_strain_half_fft_t*) malloc( sizeof(network_strain_half_fft_t) );
@@ -138,14 +157,23 @@ network_strain_half_fft_t* network_strain_half_fft_alloc(size_t num_strains, siz
 
 	network_strain->num_strains = num_strains;
 	network_strain->num_time_samples = num_time_samples;
-
-	network_strain->strains = (strain_half_fft_t**) malloc( network_strain->num_strains * sizeof(strain_half_fft_t*) );
-	if (network_strain->strains == NULL) {
-		fprintf(stderr, "Error. Unable to allocate memory for the network_strain_half_fft.strains. Exiting.\n");
-	}
-
-	for (i = 0; i < network_strain->num_strains; i++) {
-		network_strain->strains[i] = strain_half_fft_alloc( network_strain->num_time_samples );
+	network_strain->num_realizations = num_realizations;
+	network_strain->generation = network_strain_next_generation();
+	network_strain->realization = 0;
+
+	size_t half_fft_len = SS_half_size(num_time_samples);
+	network_strain->arena = AR_alloc( num_realizations * num_strains * (half_fft_len * sizeof(gsl_complex) + sizeof(strain_half_fft_t*)
+			+ 2 * ARENA_ALIGNMENT) + ARENA_ALIGNMENT, AR_get_default_pages() );
+
+	network_strain->strains = (strain_half_fft_t**) AR_malloc( network_strain->arena,
+			num_realizations * num_strains * sizeof(strain_half_fft_t*) );
+
+	for (i = 0; i < num_realizations * num_strains; i++) {
+		strain_half_fft_t *strain = (strain_half_fft_t*) AR_malloc( network_strain->arena, sizeof(strain_half_fft_t) );
+		strain->full_len = num_time_samples;
+		strain->half_fft_len = half_fft_len;
+		strain->half_fft = (gsl_complex*) AR_malloc( network_strain->arena, half_fft_len * sizeof(gsl_complex) );
+		network_strain->strains[i] = strain;
 	}
 
 	return network_strain;
@@ -153,11 +181,49 @@ network_strain_half_fft_t* network_strain_half_fft_alloc(size_t num_strains, siz
 
 void network_strain_half_fft_free(network_strain_half_fft_t *network_strain) {
 	assert(network_strain != NULL);
+	assert(network_strain->arena != NULL);
+
+	AR_free(network_strain->arena);
+	network_strain->arena = NULL;
+	network_strain->strains = NULL;
 
-	size_t i;
-	for (i = 0; i < network_strain->num_strains; i++) {
-		strain_half_fft_free(network_strain->strains[i]);
-	}
 	free(network_strain);
 	network_strain = NULL;
 }
+
+void network_strain_half_fft_changed(network_strain_half_fft_t *network_strain) {
+	assert(network_strain != NULL);
+	assert(network_strain->arena != NULL);
+
+	network_strain->generation = network_strain_next_generation();
+}
+
+network_strain_half_fft_t* network_strain_half_fft_copy(const network_strain_half_fft_t *network_strain) {
+	assert(network_strain != NULL);
+
+	size_t i;
+	network_strain_half_fft_t *copy = network_strain_half_fft_alloc_realizations( network_strain->num_strains,
+			network_strain->num_time_samples, network_strain->num_realizations );
+
+	for (i = 0; i < network_strain->num_realizations * network_strain->num_strains; i++) {
+		memcpy(copy->strains[i]->half_fft, network_strain->strains[i]->half_fft,
+				network_strain->strains[i]->half_fft_len * sizeof(gsl_complex));
+	}
+
+	return copy;
+}
+
+void network_strain_half_fft_realization(const network_strain_half_fft_t *network_strain, size_t r,
+		network_strain_half_fft_t *view) {
+	assert(network_strain != NULL);
+	assert(view != NULL);
+	assert(r < network_strain->num_realizations);
+
+	view->num_strains = network_strain->num_strains;
+	view->num_time_samples = network_strain->num_time_samples;
+	view->num_realizations = 1;
+	view->strains = network_strain->strains + r * network_strain->num_strains;
+	view->arena = NULL;
+	view->generation = network_strain->generation;
+	view->realization = r;
+}
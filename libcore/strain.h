@@ -5,6 +5,8 @@
 
 #include <gsl/gsl_complex.h>
 
+#include "arena.h"
+
 #if defined (__cplusplus)
 extern "C" {
 #endif
@@ -33,12 +35,30 @@ typedef struct strain_s {
 
 } strain_t;
 
+/* One strain per detector. With several noise realizations of the same configuration, strains holds
+ * num_realizations * num_strains entries, realization by realization, so strains[i] is always detector i of
+ * the first realization.
+ *
+ * The strains and their half-FFTs are 64 byte aligned blocks of one arena, so they are contiguous and go
+ * with network_strain_half_fft_free; do not free them one at a time.
+ */
 typedef struct network_strain_half_fft_s {
 	size_t num_strains;
 	size_t num_time_samples;
+	size_t num_realizations;
 
 	strain_half_fft_t **strains;
 
+	/* NULL for the views made by network_strain_half_fft_realization */
+	arena_t *arena;
+
+	/* Identifies the contents of the half-FFTs for the caches that hold data derived from them. A fresh value
+	 * is taken on allocation and by network_strain_half_fft_changed, never 0. A view keeps the generation of
+	 * its network strain and records its realization; realization is 0 otherwise.
+	 */
+	size_t generation;
+	size_t realization;
+
 } network_strain_half_fft_t;
 
 
@@ -55,8 +75,21 @@ strain_full_fft_t* strain_half_to_full(strain_half_fft_t *one_sided);
 strain_t* strain_full_fft_to_strain( strain_full_fft_t* fft);
 
 network_strain_half_fft_t* network_strain_half_fft_alloc(size_t num_strains, size_t num_time_samples);
+
+network_strain_half_fft_t* network_strain_half_fft_alloc_realizations(size_t num_strains, size_t num_time_samples,
+		size_t num_realizations);
+
+/* Makes view a single realization network strain that refers to realization r of network_strain. */
+void network_strain_half_fft_realization(const network_strain_half_fft_t *network_strain, size_t r,
+		network_strain_half_fft_t *view);
 void network_strain_half_fft_free(network_strain_half_fft_t *strains);
 
+/* Call after writing the half-FFTs in place, so that data filtered from the old contents is not reused. */
+void network_strain_half_fft_changed(network_strain_half_fft_t *network_strain);
+
+/* Deep copy, written by the calling thread so that on a NUMA machine it is placed on that thread's node. */
+network_strain_half_fft_t* network_strain_half_fft_copy(const network_strain_half_fft_t *network_strain);
+
 #if defined (__cplusplus)
 }
 #endif
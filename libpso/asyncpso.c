@@ -0,0 +1,322 @@
+#include "pso.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <gsl/gsl_vector.h>
+#include <gsl/gsl_errno.h>
+#include <gsl/gsl_math.h>
+
+#include "ptapso_maxphase.h"
+
+#include "parallel.h"
+
+/*! \file
+\brief Asynchronous (barrier-free) PSO.
+
+The synchronous versions, \ref lbestpso and \ref gbestpso, evaluate the whole swarm and then update it, so
+every iteration waits for the slowest particle. Here each particle is moved and re-evaluated as soon as its
+own fitness value is known, using the best locations published so far by its neighbors.
+*/
+
+/*! The pbest of a particle as seen by the other particles. It is written only by the thread that holds the
+particle, under a sequence count: odd while a write is in progress. A reader copies it and retries if the
+count was odd or changed meanwhile, so neither side ever takes a lock. */
+struct asyncPublished {
+	size_t seq;
+	double fitVal;
+	double *coord;
+};
+
+static void async_publish(struct asyncPublished *pub, size_t nDim, double fitVal, const double *coord){
+	size_t lpCoord;
+	size_t seq;
+
+#ifdef HAVE_OPENMP
+	#pragma omp atomic read seq_cst
+#endif
+	seq = pub->seq;
+
+#ifdef HAVE_OPENMP
+	#pragma omp atomic write seq_cst
+#endif
+	pub->seq = seq + 1;
+#ifdef HAVE_OPENMP
+	#pragma omp flush
+#endif
+
+#ifdef HAVE_OPENMP
+	#pragma omp atomic write
+#endif
+	pub->fitVal = fitVal;
+	/* gcc does not count the operand of an atomic write as a use */
+	(void) fitVal;
+	for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+#ifdef HAVE_OPENMP
+		#pragma omp atomic write
+#endif
+		pub->coord[lpCoord] = coord[lpCoord];
+	}
+
+#ifdef HAVE_OPENMP
+	#pragma omp flush
+	#pragma omp atomic write seq_cst
+#endif
+	pub->seq = seq + 2;
+}
+
+/* Copies a published pbest into coord (if not NULL) and returns its fitness */
+static double async_read(struct asyncPublished *pub, size_t nDim, double *coord){
+	size_t lpCoord;
+	size_t seqBefore, seqAfter;
+	double fitVal;
+
+	for (;;){
+#ifdef HAVE_OPENMP
+		#pragma omp atomic read seq_cst
+#endif
+		seqBefore = pub->seq;
+		if (seqBefore % 2 != 0)
+			continue;
+
+#ifdef HAVE_OPENMP
+		#pragma omp atomic read
+#endif
+		fitVal = pub->fitVal;
+		if (coord != NULL){
+			for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+				double x;
+#ifdef HAVE_OPENMP
+				#pragma omp atomic read
+#endif
+				x = pub->coord[lpCoord];
+				coord[lpCoord] = x;
+			}
+		}
+
+#ifdef HAVE_OPENMP
+		#pragma omp flush
+		#pragma omp atomic read seq_cst
+#endif
+		seqAfter = pub->seq;
+		if (seqAfter == seqBefore)
+			return fitVal;
+	}
+}
+
+/*! Common driver of \ref async_lbestpso and \ref async_gbestpso. nNbrs is the number of neighbors on each
+side of a particle in the ring, or 0 for the whole swarm. */
+static void asyncpso(size_t nDim, fitness_function_ptr fitfunc, void *ffParams,
+		struct psoParamStruct *psoParams, struct returnData *psoResults, size_t nNbrs){
+
+	gsl_rng *rngGen = psoParams->rngGen;
+	const size_t popsize = psoParams->popsize;
+	const size_t maxSteps = psoParams->maxSteps;
+	/* As many evaluations as the synchronous versions make */
+	const size_t maxEvals = (maxSteps - 1) * popsize;
+	size_t lpParticles, lpCoord;
+	size_t evalsIssued = 0;
+	size_t evalsDone = 0;
+	/* Stopping criteria besides the number of evaluations. An iteration is popsize evaluations here, and the
+	   diameter of a swarm that is never all in one place is not used. */
+	struct psoStopState stop;
+	int stopped = 0;
+	double bestFitVal = GSL_POSINF;
+	size_t funcEvalsDone = 0;
+
+	struct swarmInfo *swarm = swarm_alloc(popsize, nDim);
+	struct asyncPublished published[popsize];
+	gsl_rng *partRng[popsize];
+	/* Iterations completed by each particle */
+	size_t partIter[popsize];
+
+	/* FIFO of the particles waiting for their next evaluation */
+	size_t queue[popsize];
+	size_t queueHead = 0;
+	size_t queueCount = popsize;
+
+	if (maxSteps < 2){
+		fprintf(stderr, "Error. asyncpso: maxSteps must be at least 2. Exiting.\n");
+		exit(-1);
+	}
+
+	psoStop_init(&stop);
+	swarm_init(swarm, psoParams);
+	/* Each particle draws from its own stream, so it does not matter which thread moves it. The counter-based
+	   generator is keyed by particle already. */
+	for (lpParticles = 0; lpParticles < popsize; lpParticles++){
+		partRng[lpParticles] = NULL;
+		if (!psoParams->counterRng){
+			partRng[lpParticles] = gsl_rng_alloc(rngGen->type);
+			gsl_rng_set(partRng[lpParticles], gsl_rng_get(rngGen));
+		}
+
+		published[lpParticles].seq = 0;
+		published[lpParticles].fitVal = GSL_POSINF;
+		published[lpParticles].coord = (double*) malloc( nDim * sizeof(double) );
+		if (published[lpParticles].coord == NULL){
+			fprintf(stderr, "Error. asyncpso: Unable to allocate memory for the published pbest. Exiting.\n");
+			exit(-1);
+		}
+		async_publish(&published[lpParticles], nDim, GSL_POSINF, swarm->partPbest + lpParticles * nDim);
+
+		partIter[lpParticles] = 0;
+		queue[lpParticles] = lpParticles;
+	}
+
+#ifdef HAVE_OPENMP
+	#pragma omp parallel
+#endif
+	{
+		size_t lpNbrs;
+		double *nbrCoord = (double*) malloc( nDim * sizeof(double) );
+
+		for (;;){
+			size_t part = popsize;
+			double *pbest, *lbest;
+			unsigned char computeOK;
+			double nbrFitVal;
+
+			/* Take the particle that has waited longest. The queue is empty only when every particle is
+			   being evaluated by another thread, and those threads finish the run. */
+#ifdef HAVE_OPENMP
+			#pragma omp critical (asyncpso_queue)
+#endif
+			{
+				if (!stopped && evalsIssued < maxEvals && queueCount > 0){
+					part = queue[queueHead];
+					queueHead = (queueHead + 1) % popsize;
+					queueCount--;
+					evalsIssued++;
+				}
+			}
+			if (part == popsize)
+				break;
+			pbest = swarm->partPbest + part * nDim;
+			lbest = swarm->partLocalBest + part * nDim;
+
+			/* Evaluate fitness */
+			swarm->partSnrCurr[part] = fitfunc(&swarm->coordView[part].vector, ffParams);
+			/* Check if fitness function was actually evaluated or not */
+			computeOK = ((struct fitFuncParams *)ffParams)->fitEvalFlag[parallel_get_thread_num()];
+			if (computeOK){
+				swarm->partFitEvals[part]++;
+			}
+			partIter[part]++;
+
+			/* Update and publish pbest if needed */
+			if (swarm->partSnrPbest[part] > swarm->partSnrCurr[part]){
+				swarm->partSnrPbest[part] = swarm->partSnrCurr[part];
+				memcpy(pbest, swarm->partCoord + part * nDim, nDim * sizeof(double));
+				async_publish(&published[part], nDim, swarm->partSnrPbest[part], pbest);
+			}
+
+			/* Best pbest in the neighborhood, the particle itself included, as published right now */
+			swarm->partSnrLbest[part] = swarm->partSnrPbest[part];
+			memcpy(lbest, pbest, nDim * sizeof(double));
+			for (lpNbrs = 0; lpNbrs < (nNbrs > 0 ? 2 * nNbrs : popsize); lpNbrs++){
+				size_t nbr;
+				if (nNbrs > 0){
+					/* part - nNbrs, ..., part - 1, part + 1, ..., part + nNbrs on the ring */
+					nbr = (lpNbrs < nNbrs) ? (part + popsize - nNbrs + lpNbrs) % popsize
+							: (part + lpNbrs - nNbrs + 1) % popsize;
+				} else {
+					nbr = lpNbrs;
+				}
+				if (nbr == part)
+					continue;
+				nbrFitVal = async_read(&published[nbr], nDim, NULL);
+				if (nbrFitVal < swarm->partSnrLbest[part]){
+					nbrFitVal = async_read(&published[nbr], nDim, nbrCoord);
+					/* It may have improved again between the two reads */
+					if (nbrFitVal < swarm->partSnrLbest[part]){
+						swarm->partSnrLbest[part] = nbrFitVal;
+						memcpy(lbest, nbrCoord, nDim * sizeof(double));
+					}
+				}
+			}
+
+			/* Update inertia weight, with the particle's own iteration count */
+			swarm->partInertia[part] = psoParams->dcLaw_a-(psoParams->dcLaw_b/psoParams->dcLaw_c)*partIter[part];
+			if (swarm->partInertia[part] < psoParams->dcLaw_d)
+				swarm->partInertia[part] = psoParams->dcLaw_d;
+			/* Random weights, then velocity and position update */
+			if (psoParams->counterRng){
+				swarm_draw_weights_counter(swarm, part, 1, psoParams->rngSeed, partIter[part]);
+			} else {
+				swarm_draw_weights(swarm, part, 1, partRng[part]);
+			}
+			swarm_update(swarm, part, 1, psoParams);
+
+			/* Back to the end of the queue */
+#ifdef HAVE_OPENMP
+			#pragma omp critical (asyncpso_queue)
+#endif
+			{
+				queue[(queueHead + queueCount) % popsize] = part;
+				queueCount++;
+				evalsDone++;
+				funcEvalsDone += computeOK;
+
+				if (swarm->partSnrPbest[part] < bestFitVal)
+					bestFitVal = swarm->partSnrPbest[part];
+				if (!stopped && psoStop_update(&stop, psoParams, NULL, evalsDone / popsize, bestFitVal))
+					stopped = 1;
+				if (!stopped && psoParams->maxFuncEvals > 0 && funcEvalsDone >= psoParams->maxFuncEvals){
+					stop.reason = PSO_STOP_FUNC_EVALS;
+					stopped = 1;
+				}
+			}
+		}
+
+		free(nbrCoord);
+	}
+
+	/* Prepare output: gbest is the best pbest */
+	psoResults->totalIterations = evalsDone / popsize;
+	psoResults->stopReason = stop.reason;
+	psoResults->lastImprovementIter = stop.lastImprovementIter;
+	psoResults->totalFuncEvals = 0;
+	psoResults->bestFitVal = GSL_POSINF;
+	for (lpParticles = 0; lpParticles < popsize; lpParticles++){
+		psoResults->totalFuncEvals += swarm->partFitEvals[lpParticles];
+		if (swarm->partSnrPbest[lpParticles] < psoResults->bestFitVal){
+			psoResults->bestFitVal = swarm->partSnrPbest[lpParticles];
+			for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+				gsl_vector_set(psoResults->bestLocation, lpCoord, swarm->partPbest[lpParticles * nDim + lpCoord]);
+			}
+		}
+	}
+
+	for (lpParticles = 0; lpParticles < popsize; lpParticles++){
+		free(published[lpParticles].coord);
+		if (partRng[lpParticles] != NULL){
+			gsl_rng_free(partRng[lpParticles]);
+		}
+	}
+	swarm_free(swarm);
+}
+
+/*!
+Asynchronous local best PSO: ring topology with one neighbor on each side, as in \ref lbestpso. The
+neighborhood best is taken over the neighbors' pbest, since their current locations are not all known at
+any one time. Local minimization of gbest and the debug dump file are not used.
+*/
+void async_lbestpso(size_t nDim, /*!< Number of search dimensions */
+            fitness_function_ptr fitfunc, /*!< Pointer to Fitness function */
+			void *ffParams, /*!< Fitness function parameter structure */
+            struct psoParamStruct *psoParams, /*!< PSO parameter structure */
+			struct returnData *psoResults /*!< Output structure */){
+	asyncpso(nDim, fitfunc, ffParams, psoParams, psoResults, 1);
+}
+
+/*!
+Asynchronous global best PSO: every particle follows the best pbest of the whole swarm, as in \ref gbestpso.
+*/
+void async_gbestpso(size_t nDim, /*!< Number of search dimensions */
+            fitness_function_ptr fitfunc, /*!< Pointer to Fitness function */
+			void *ffParams, /*!< Fitness function parameter structure */
+            struct psoParamStruct *psoParams, /*!< PSO parameter structure */
+			struct returnData *psoResults /*!< Output structure */){
+	asyncpso(nDim, fitfunc, ffParams, psoParams, psoResults, 0);
+}
@@ -12,6 +12,7 @@
 #include "ptapso_maxphase.h"
 
 #include "inspiral_pso_fitness.h"
+#include "cpu_dispatch.h"
 #include "inspiral_chirp.h"
 #include "inspiral_chirp_time.h"
 #include "random.h"
@@ -34,16 +35,44 @@ pso_fitness_function_parameters_t* pso_fitness_function_parameters_alloc(
 		exit(-1);
 	}
 
-	params->workspace = (coherent_network_workspace_t**) malloc( parallel_get_max_threads() * sizeof(coherent_network_workspace_t*) );
-	if (params->workspace == NULL) {
+	size_t num_threads = parallel_get_max_threads();
+	params->workspace = (coherent_network_workspace_t**) malloc( num_threads * sizeof(coherent_network_workspace_t*) );
+	params->thread_cpu = (size_t*) malloc( num_threads * sizeof(size_t) );
+	params->thread_node = (size_t*) malloc( num_threads * sizeof(size_t) );
+	params->thread_network = (detector_network_t**) malloc( num_threads * sizeof(detector_network_t*) );
+	params->thread_strain = (network_strain_half_fft_t**) malloc( num_threads * sizeof(network_strain_half_fft_t*) );
+	if (params->workspace == NULL || params->thread_cpu == NULL || params->thread_node == NULL
+			|| params->thread_network == NULL || params->thread_strain == NULL) {
 		fprintf(stderr, "Error. Unable to allocate memory for params->workspace. Exiting.\n");
 		exit(-1);
 	}
 
-	for (i = 0; i < parallel_get_max_threads(); i++) {
-		params->workspace[i] = CN_workspace_alloc(
-				network_strain->num_time_samples, network, network->detector[0]->asd->len,
-				f_low, f_high);
+	params->context = CN_context_alloc(
+			network_strain->num_time_samples, network, network->detector[0]->asd->len,
+			f_low, f_high);
+
+	for (i = 0; i < num_threads; i++) {
+		params->workspace[i] = NULL;
+		params->thread_cpu[i] = 0;
+		params->thread_node[i] = 0;
+		params->thread_network[i] = network;
+		params->thread_strain[i] = network_strain;
+	}
+
+	/* Each thread allocates its own workspace, so that its pages are first touched, and placed, on the node
+	   that thread runs on. Any thread the runtime did not start gets a workspace from the master. */
+#ifdef HAVE_OPENMP
+	#pragma omp parallel num_threads(num_threads)
+#endif
+	{
+		size_t t = parallel_get_thread_num();
+		params->workspace[t] = CN_workspace_alloc_shared(params->context, network);
+		parallel_get_cpu_and_node(&params->thread_cpu[t], &params->thread_node[t]);
+	}
+	for (i = 0; i < num_threads; i++) {
+		if (params->workspace[i] == NULL) {
+			params->workspace[i] = CN_workspace_alloc_shared(params->context, network);
+		}
 	}
 
 	/* Setup the parameter structure for the pso fitness function */
@@ -51,8 +80,16 @@ pso_fitness_function_parameters_t* pso_fitness_function_parameters_alloc(
 	params->f_high = f_high;
 	params->network = network;
 	params->network_strain = network_strain;
+	params->template_cache = NULL;
+	params->sky_table = NULL;
+	params->threads_per_evaluation = 1;
+	params->num_nodes = 0;
+	params->replica_network = NULL;
+	params->replica_strain = NULL;
 
-	fprintf(stderr, "Number of threads: %lu\n", parallel_get_max_threads());
+	fprintf(stderr, "Number of threads: %lu\n", num_threads);
+	CPU_report(stderr);
+	fprintf(stderr, "Workspace bytes per thread: %lu\n", CN_workspace_bytes_per_thread(params->workspace[0]));
 
 	return params;
 }
@@ -70,9 +107,106 @@ void pso_fitness_function_parameters_free(pso_fitness_function_parameters_t *par
 	free(params->workspace);
 	params->workspace = NULL;
 
+	if (params->replica_network != NULL) {
+		for (i = 0; i < params->num_nodes; i++) {
+			if (params->replica_network[i] != NULL) {
+				Detector_Network_free(params->replica_network[i]);
+				free(params->replica_network[i]);
+				network_strain_half_fft_free(params->replica_strain[i]);
+			}
+		}
+		free(params->replica_network);
+		free(params->replica_strain);
+	}
+
+	free(params->thread_cpu);
+	free(params->thread_node);
+	free(params->thread_network);
+	free(params->thread_strain);
+
+	CN_context_free(params->context);
+	params->context = NULL;
+
 	free(params);
 }
 
+void pso_fitness_function_parameters_replicate(pso_fitness_function_parameters_t *params) {
+	assert(params != NULL);
+
+	size_t i;
+	size_t num_threads = parallel_get_max_threads();
+
+	if (params->replica_network != NULL) {
+		return;
+	}
+
+	params->num_nodes = 0;
+	for (i = 0; i < num_threads; i++) {
+		params->num_nodes = GSL_MAX( params->num_nodes, params->thread_node[i] + 1 );
+	}
+
+	params->replica_network = (detector_network_t**) calloc( params->num_nodes, sizeof(detector_network_t*) );
+	params->replica_strain = (network_strain_half_fft_t**) calloc( params->num_nodes, sizeof(network_strain_half_fft_t*) );
+	if (params->replica_network == NULL || params->replica_strain == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the replicated strain. Exiting.\n");
+		exit(-1);
+	}
+
+	/* The first thread to reach a node copies the data, so the copy is first touched on that node. A thread
+	   that has since moved to a node none of the threads started on keeps reading the originals. */
+#ifdef HAVE_OPENMP
+	#pragma omp parallel num_threads(num_threads)
+#endif
+	{
+		size_t t = parallel_get_thread_num();
+		size_t cpu, node;
+		parallel_get_cpu_and_node(&cpu, &node);
+
+		if (node < params->num_nodes) {
+#ifdef HAVE_OPENMP
+			#pragma omp critical (pso_replicate)
+#endif
+			{
+				if (params->replica_network[node] == NULL) {
+					params->replica_network[node] = Detector_Network_copy(params->network);
+					params->replica_strain[node] = network_strain_half_fft_copy(params->network_strain);
+				}
+			}
+			params->thread_network[t] = params->replica_network[node];
+			params->thread_strain[t] = params->replica_strain[node];
+		}
+	}
+}
+
+void pso_fitness_function_placement_report(pso_fitness_function_parameters_t *params) {
+	assert(params != NULL);
+
+	size_t i, n, num_replicas = 0;
+
+	for (i = 0; i < params->num_nodes; i++) {
+		if (params->replica_network[i] != NULL) {
+			num_replicas++;
+		}
+	}
+
+	fprintf(stderr, "Threads bound to places: %s\n", parallel_threads_bound() ? "yes"
+			: "no (set OMP_PROC_BIND and OMP_PLACES to keep each thread on its node)");
+	fprintf(stderr, "Strain and spectral density copies: %lu\n", num_replicas);
+	for (i = 0; i < parallel_get_max_threads(); i++) {
+		fprintf(stderr, "Thread %lu: cpu %lu, workspace on node %lu, ", i, params->thread_cpu[i], params->thread_node[i]);
+		for (n = 0; n < params->num_nodes; n++) {
+			if (params->thread_strain[i] == params->replica_strain[n]) {
+				break;
+			}
+		}
+		if (n < params->num_nodes) {
+			fprintf(stderr, "strain copy on node %lu\n", n);
+		} else {
+			fprintf(stderr, "shared strain\n");
+		}
+	}
+}
+
 /* this routine was written for the PSO code. */
 void CN_template_chirp_time(double f_low, double chirp_time0, double chirp_time1_5, inspiral_chirp_time_t *ct) {
 	assert(ct != NULL);
@@ -130,6 +264,12 @@ double pso_fitness_function(gsl_vector *xVec, void  *inParamsPointer){
 		double chirp_time_0 = gsl_vector_get(realCoord, 2);
 		double chirp_time_1_5 = gsl_vector_get(realCoord, 3);
 
+		/* With a template cache the chirp times are moved to the cache grid, so that the template does not
+		   depend on which particle first computed it. */
+		if (splParams->template_cache != NULL) {
+			TC_snap(splParams->template_cache, &chirp_time_0, &chirp_time_1_5);
+		}
+
 		inspiral_chirp_time_t chirp_time;
 		CN_template_chirp_time(splParams->f_low, chirp_time_0, chirp_time_1_5, &chirp_time);
 
@@ -142,12 +282,12 @@ double pso_fitness_function(gsl_vector *xVec, void  *inParamsPointer){
 		sky.dec = dec;
 
 		coherent_network_statistic(
-				splParams->network,
+				splParams->thread_network[parallel_get_thread_num()],
 				splParams->f_low,
 				splParams->f_high,
 				&chirp_time,
 				&sky,
-				splParams->network_strain,
+				splParams->thread_strain[parallel_get_thread_num()],
 				splParams->workspace[parallel_get_thread_num()],
 				&fitFuncVal,
 				NULL);
@@ -163,13 +303,101 @@ double pso_fitness_function(gsl_vector *xVec, void  *inParamsPointer){
    return fitFuncVal;
 }
 
-int pso_estimate_parameters(char *pso_settings_filename, pso_fitness_function_parameters_t *splParams, gslseed_t seed, pso_result_t* result) {
-	assert(pso_settings_filename != NULL);
-	assert(splParams != NULL);
-	assert(result != NULL);
+void pso_fitness_function_batch(size_t num_points, gsl_vector **xVec, void *inParamsPointer, double *fitFuncVal,
+		unsigned char *fitEvalFlag)
+{
+	assert(xVec != NULL);
+	assert(inParamsPointer != NULL);
+	assert(fitFuncVal != NULL);
+	assert(fitEvalFlag != NULL);
 
-	clock_t time_start = clock();
+	size_t p;
+	long c;
+	struct fitFuncParams *inParams = (struct fitFuncParams *)inParamsPointer;
+	struct pso_fitness_function_parameters_s *splParams = (struct pso_fitness_function_parameters_s *)inParams->splParams;
+	gsl_vector *realCoord = inParams->realCoord[parallel_get_thread_num()];
+
+	/* The valid points, packed */
+	size_t num_valid = 0;
+	size_t valid[num_points];
+	inspiral_chirp_time_t chirp_time[num_points];
+	sky_t sky[num_points];
+	double snr[num_points];
 
+	for (p = 0; p < num_points; p++) {
+		s2rvector(xVec[p],inParams->rmin,inParams->rangeVec,realCoord);
+
+		if (!chkstdsrchrng(xVec[p])) {
+			fitFuncVal[p] = GSL_POSINF;
+			fitEvalFlag[p] = 0;
+			continue;
+		}
+		fitEvalFlag[p] = 1;
+
+		double chirp_time_0 = gsl_vector_get(realCoord, 2);
+		double chirp_time_1_5 = gsl_vector_get(realCoord, 3);
+		if (splParams->template_cache != NULL) {
+			TC_snap(splParams->template_cache, &chirp_time_0, &chirp_time_1_5);
+		}
+
+		CN_template_chirp_time(splParams->f_low, chirp_time_0, chirp_time_1_5, &chirp_time[num_valid]);
+		sky[num_valid].ra = gsl_vector_get(realCoord, 0);
+		sky[num_valid].dec = gsl_vector_get(realCoord, 1);
+		valid[num_valid] = p;
+		num_valid++;
+	}
+
+	/* At most CN_BATCH_SIZE points per call, but enough calls to keep every thread busy */
+	size_t num_threads = GSL_MAX( 1, parallel_get_max_threads() / splParams->threads_per_evaluation );
+	size_t chunk = GSL_MAX( 1, GSL_MIN( CN_BATCH_SIZE, (num_valid + num_threads - 1) / num_threads ) );
+	long num_chunks = (num_valid + chunk - 1) / chunk;
+
+#ifdef HAVE_OPENMP
+	#pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+#endif
+	for (c = 0; c < num_chunks; c++) {
+		size_t start = c * chunk;
+		size_t count = GSL_MIN( chunk, num_valid - start );
+
+		coherent_network_statistic_batch(
+				splParams->thread_network[parallel_get_thread_num()],
+				splParams->f_low,
+				splParams->f_high,
+				count,
+				&chirp_time[start],
+				&sky[start],
+				splParams->thread_strain[parallel_get_thread_num()],
+				splParams->workspace[parallel_get_thread_num()],
+				&snr[start]);
+	}
+
+	/* PSO is finding minimums */
+	for (p = 0; p < num_valid; p++) {
+		fitFuncVal[valid[p]] = -1.0 * snr[p];
+	}
+}
+
+/* The PSO driver named by pso_version in the pso settings file */
+typedef void (*pso_driver_ptr)(size_t, fitness_function_ptr, void *, struct psoParamStruct *, struct returnData *);
+
+static pso_driver_ptr pso_driver_name_to_ptr(const char *pso_version) {
+	if (pso_version != NULL) {
+		if (strcmp(pso_version, "lbest")==0) {
+			return lbestpso;
+		} else if (strcmp(pso_version, "gbest")==0) {
+			return gbestpso;
+		} else if (strcmp(pso_version, "async_lbest")==0) {
+			return async_lbestpso;
+		} else if (strcmp(pso_version, "async_gbest")==0) {
+			return async_gbestpso;
+		}
+	}
+	fprintf(stderr, "Error. pso_version in the pso settings file must be 'lbest', 'gbest', 'async_lbest' or 'async_gbest'. Exiting.\n");
+	exit(-1);
+}
+
+/* The search space of the fitness function: right-ascension, declination and the two chirp times. */
+static struct fitFuncParams* pso_search_space_alloc(pso_fitness_function_parameters_t *splParams) {
 	/* Estimate right-ascension, declination, and chirp times. */
 	unsigned int nDim = 4, lpc;
 	/* [0] = RA
@@ -182,14 +410,6 @@ int pso_estimate_parameters(char *pso_settings_filename, pso_fitness_function_pa
 	double rmax[4] = {M_PI, 	0.5*M_PI, 	43.4673, 	1.0840};
 	double rangeVec[4];
 
-	/* Error handling off */
-	gsl_error_handler_t *old_handler = gsl_set_error_handler_off ();
-
-	/* Initialize random number generator */
-	gsl_rng *rngGen = gsl_rng_alloc(gsl_rng_taus);
-	/* Soumya version gsl_rng_set(rngGen,2571971); */
-	gsl_rng_set(rngGen, seed);
-
     /* Allocate fitness function parameter struct.
 	 */
 	struct fitFuncParams *inParams = ffparam_alloc(nDim);
@@ -200,59 +420,250 @@ int pso_estimate_parameters(char *pso_settings_filename, pso_fitness_function_pa
 		gsl_vector_set(inParams->rmin,lpc,rmin[lpc]);
 		gsl_vector_set(inParams->rangeVec,lpc,rangeVec[lpc]);
 	}
-	/* Set up pointer to fitness function. Use the prototype
-	declaration given in the header file for the fitness function. */
-	double (*fitfunc)(gsl_vector *, void *) = pso_fitness_function;
-	/* Set up special parameters, if any, needed by the fitness function used.
-	   These should be provided in a structure that should be defined in
-	   the fitness function's header file.
-	 */
 	/* ============================================ */
 	/* Pass on the special parameters through the generic fitness function parameter
 	struct */
 	inParams->splParams = splParams;
 
-	/* Set up storage for output from ptapso. */
-	struct returnData *psoResults = returnData_alloc(nDim);
+	return inParams;
+}
 
+/* The swarm parameters from the pso settings file. The generator and its seed are set for each trial. */
+static void pso_settings_load(settings_file_t *settings_file, struct psoParamStruct *psoParams) {
+	psoParams->popsize = atoi(settings_file_get_value(settings_file, "popsize"));;
+	psoParams->maxSteps= atoi(settings_file_get_value(settings_file, "maxSteps"));;
+	psoParams->c1 = atof(settings_file_get_value(settings_file, "c1"));;
+	psoParams->c2 = atof(settings_file_get_value(settings_file, "c2"));;
+	psoParams->max_velocity = atof(settings_file_get_value(settings_file, "max_velocity"));;
+	psoParams->dcLaw_a = atof(settings_file_get_value(settings_file, "dcLaw_a"));;
+	psoParams->dcLaw_b = atof(settings_file_get_value(settings_file, "dcLaw_b"));;
+	psoParams->dcLaw_c = psoParams->maxSteps;
+	psoParams->dcLaw_d = atof(settings_file_get_value(settings_file, "dcLaw_d"));;
+	psoParams->locMinIter = atof(settings_file_get_value(settings_file, "locMinIter"));
+	psoParams->locMinStpSz = atof(settings_file_get_value(settings_file, "locMinStpSz"));
+	psoParams->rngGen = NULL;
+	psoParams->counterRng = 0;
+	psoParams->rngSeed = 0;
+	psoParams->batchFitfunc = pso_fitness_function_batch;
+	psoParams->debugDumpFile = NULL; /*fopen("ptapso_dump.txt","w"); */
+
+	/* Optional: stop before maxSteps when gbest has not improved by more than stallTol for stallSteps
+	 * iterations, when the swarm has shrunk below minSwarmDiameter (standardized coordinates) or after
+	 * maxFuncEvals fitness evaluations. 0 switches a criterion off, which is the default.
+	 */
+	const char *stallSteps = settings_file_get_value(settings_file, "stallSteps");
+	const char *stallTol = settings_file_get_value(settings_file, "stallTol");
+	const char *minSwarmDiameter = settings_file_get_value(settings_file, "minSwarmDiameter");
+	const char *maxFuncEvals = settings_file_get_value(settings_file, "maxFuncEvals");
+	psoParams->stallSteps = (stallSteps != NULL) ? atoi(stallSteps) : 0;
+	psoParams->stallTol = (stallTol != NULL) ? atof(stallTol) : 0.0;
+	psoParams->minSwarmDiameter = (minSwarmDiameter != NULL) ? atof(minSwarmDiameter) : 0.0;
+	psoParams->maxFuncEvals = (maxFuncEvals != NULL) ? strtoul(maxFuncEvals, NULL, 10) : 0;
+	if (psoParams->stallTol < 0.0 || psoParams->minSwarmDiameter < 0.0) {
+		fprintf(stderr, "Error. stallTol and minSwarmDiameter in the pso settings file must not be negative. Exiting.\n");
+		exit(-1);
+	}
 
-	/* nelder-meade method .. look up */
-	/* Set up the pso parameter structure.*/
+	/* Optional: 'philox' draws the random numbers of the swarm from a counter-based generator, which makes the
+	 * run independent of the number of threads and lets the swarm update run in parallel. Defaults to 'gsl',
+	 * one sequential gsl_rng stream as before.
+	 */
+	const char *pso_rng = settings_file_get_value(settings_file, "pso_rng");
+	if (pso_rng != NULL) {
+		if (strcmp(pso_rng, "philox") == 0) {
+			psoParams->counterRng = 1;
+		} else if (strcmp(pso_rng, "gsl") != 0) {
+			fprintf(stderr, "Error. pso_rng in the pso settings file must be 'gsl' or 'philox'. Exiting.\n");
+			exit(-1);
+		}
+	}
+}
 
-	/* Load the pso settings */
-	settings_file_t *settings_file = settings_file_open(pso_settings_filename);
-	if (settings_file == NULL) {
-		printf("Error opening the PSO settings file (%s). Aborting.\n", pso_settings_filename);
-		abort();
+/* Builds the template cache and the sky table if the pso settings file asks for them, otherwise sets them to
+ * NULL. They only depend on the data, so one of each serves every workspace searching it, in every team.
+ */
+static void pso_settings_shared_alloc(settings_file_t *settings_file, double f_low, double f_high,
+		detector_network_t *network, template_cache_t **out_template_cache, sky_geometry_table_t **out_sky_table) {
+	*out_template_cache = NULL;
+	*out_sky_table = NULL;
+
+	/* Optional: keep up to template_cache_mb megabytes of intrinsic templates, keyed on the chirp times rounded
+	 * to template_cache_quantum seconds. Defaults to no cache.
+	 */
+	const char *template_cache_mb = settings_file_get_value(settings_file, "template_cache_mb");
+	if (template_cache_mb != NULL && atof(template_cache_mb) > 0.0) {
+		const char *quantum = settings_file_get_value(settings_file, "template_cache_quantum");
+		size_t max_bytes = (size_t) (atof(template_cache_mb) * 1024.0 * 1024.0);
+
+		/* A template covers the band bins of the stationary phase lookup of the workspaces */
+		asd_t *asd = network->detector[0]->asd;
+		stationary_phase_workspace_t *lookup = SP_workspace_alloc(f_low, f_high, asd->len, asd->f);
+		*out_template_cache = TC_alloc( lookup->len, max_bytes, (quantum != NULL) ? atof(quantum) : 1.0e-6 );
+		SP_workspace_free(lookup);
 	}
 
-	struct psoParamStruct psoParams;
-	psoParams.popsize = atoi(settings_file_get_value(settings_file, "popsize"));;
-	psoParams.maxSteps= atoi(settings_file_get_value(settings_file, "maxSteps"));;
-	psoParams.c1 = atof(settings_file_get_value(settings_file, "c1"));;
-	psoParams.c2 = atof(settings_file_get_value(settings_file, "c2"));;
-	psoParams.max_velocity = atof(settings_file_get_value(settings_file, "max_velocity"));;
-	psoParams.dcLaw_a = atof(settings_file_get_value(settings_file, "dcLaw_a"));;
-	psoParams.dcLaw_b = atof(settings_file_get_value(settings_file, "dcLaw_b"));;
-	psoParams.dcLaw_c = psoParams.maxSteps;
-	psoParams.dcLaw_d = atof(settings_file_get_value(settings_file, "dcLaw_d"));;
-	psoParams.locMinIter = atof(settings_file_get_value(settings_file, "locMinIter"));
-	psoParams.locMinStpSz = atof(settings_file_get_value(settings_file, "locMinStpSz"));
-	psoParams.rngGen = rngGen;
-	psoParams.debugDumpFile = NULL; /*fopen("ptapso_dump.txt","w"); */
-
-	const char *pso_version = settings_file_get_value(settings_file, "pso_version");
-	if (strcmp(pso_version, "lbest")==0) {
-		lbestpso(nDim, fitfunc, inParams, &psoParams, psoResults);
-	} else if (strcmp(pso_version, "gbest")==0) {
-		gbestpso(nDim, fitfunc, inParams, &psoParams, psoResults);
-	} else {
-		fprintf(stderr, "Error. pso_version in the pso settings file must be 'lbest' or 'gbest'. Exiting.\n");
-		exit(-1);
+	/* Optional: interpolate the antenna patterns and time delays from a grid of sky_table_ra_points right
+	 * ascensions by sky_table_dec_points declinations. Defaults to the exact values.
+	 */
+	const char *sky_table_ra_points = settings_file_get_value(settings_file, "sky_table_ra_points");
+	const char *sky_table_dec_points = settings_file_get_value(settings_file, "sky_table_dec_points");
+	if (sky_table_ra_points != NULL && sky_table_dec_points != NULL && atoi(sky_table_ra_points) > 0) {
+		*out_sky_table = SG_table_alloc( network, atoi(sky_table_ra_points), atoi(sky_table_dec_points) );
+	}
+}
+
+static void pso_settings_shared_free(template_cache_t *template_cache, sky_geometry_table_t *sky_table) {
+	if (template_cache != NULL) {
+		TC_free(template_cache);
+	}
+	if (sky_table != NULL) {
+		SG_table_free(sky_table);
 	}
+}
 
-	settings_file_close(settings_file);
+/* Sets up the workspaces of splParams as asked for by the optional settings of the pso settings file, with the
+ * template cache and sky table (either may be NULL) from pso_settings_shared_alloc.
+ */
+static void pso_settings_apply(settings_file_t *settings_file, template_cache_t *template_cache,
+		sky_geometry_table_t *sky_table, pso_fitness_function_parameters_t *splParams) {
+	/* Optional: choose how the network statistic is computed. Defaults to the two-sided engine. */
+	const char *engine_name = settings_file_get_value(settings_file, "network_statistic_engine");
+	if (engine_name != NULL) {
+		size_t i;
+		CN_ENGINE engine = CN_engine_name_to_id(engine_name);
+		for (i = 0; i < parallel_get_max_threads(); i++) {
+			CN_workspace_set_engine(splParams->workspace[i], engine);
+		}
+	}
+
+	/* Optional: 'single' evaluates the fused engine in float. Defaults to double. */
+	const char *precision_name = settings_file_get_value(settings_file, "network_statistic_precision");
+	if (precision_name != NULL) {
+		size_t i;
+		FFT_PRECISION precision = CN_precision_name_to_id(precision_name);
+		for (i = 0; i < parallel_get_max_threads(); i++) {
+			CN_workspace_set_precision(splParams->workspace[i], precision);
+		}
+	}
+
+	/* Optional: 1 evaluates the statistic at a reduced rate and refines the peak. Defaults to 0. */
+	const char *baseband = settings_file_get_value(settings_file, "network_statistic_baseband");
+	if (baseband != NULL) {
+		size_t i;
+		if (atoi(baseband) && splParams->workspace[0]->precision == FFT_SINGLE) {
+			fprintf(stderr, "Error. network_statistic_baseband is only implemented in double precision. Exiting.\n");
+			exit(-1);
+		}
+		for (i = 0; i < parallel_get_max_threads(); i++) {
+			CN_workspace_set_baseband(splParams->workspace[i], atoi(baseband));
+		}
+	}
+
+	/* Optional: only consider coalescence times between tc_window_start and tc_window_end, in seconds from the
+	 * start of the data, e.g. around a trigger from another pipeline.
+	 */
+	const char *tc_window_start = settings_file_get_value(settings_file, "tc_window_start");
+	const char *tc_window_end = settings_file_get_value(settings_file, "tc_window_end");
+	if (tc_window_start != NULL && tc_window_end != NULL) {
+		size_t i;
+		asd_t *asd = splParams->network->detector[0]->asd;
+		size_t num_time_samples = splParams->network_strain->num_time_samples;
+		double sampling_frequency = num_time_samples * (asd->f[1] - asd->f[0]);
+		double start_secs = atof(tc_window_start);
+		double end_secs = atof(tc_window_end);
+
+		if (start_secs < 0.0 || end_secs < start_secs) {
+			fprintf(stderr, "Error. tc_window_start and tc_window_end must satisfy 0 <= start <= end. Exiting.\n");
+			exit(-1);
+		}
+
+		size_t start = (size_t) floor(start_secs * sampling_frequency);
+		size_t end = GSL_MIN( (size_t) ceil(end_secs * sampling_frequency), num_time_samples - 1 );
+		for (i = 0; i < parallel_get_max_threads(); i++) {
+			CN_workspace_set_tc_window(splParams->workspace[i], start, end - start + 1);
+		}
+	}
+
+	if (template_cache != NULL) {
+		size_t i;
+		splParams->template_cache = template_cache;
+		for (i = 0; i < parallel_get_max_threads(); i++) {
+			CN_workspace_set_template_cache(splParams->workspace[i], template_cache);
+		}
+	}
+
+	if (sky_table != NULL) {
+		size_t i;
+		splParams->sky_table = sky_table;
+		for (i = 0; i < parallel_get_max_threads(); i++) {
+			CN_workspace_set_sky_table(splParams->workspace[i], sky_table);
+		}
+	}
+
+	/* Optional: threads used inside each evaluation of the network statistic, for small swarms on large
+	 * machines. The particles share the remaining threads. Defaults to 1.
+	 */
+	const char *threads_per_evaluation = settings_file_get_value(settings_file, "threads_per_evaluation");
+	if (threads_per_evaluation != NULL && atoi(threads_per_evaluation) > 1) {
+		size_t i;
+		splParams->threads_per_evaluation = GSL_MIN( (size_t) atoi(threads_per_evaluation), parallel_get_max_threads() );
+		/* Inside a team of pso_estimate_parameters_trials the levels have been allowed already */
+		if (parallel_get_level() == 0) {
+			parallel_set_max_active_levels(2);
+		}
+		for (i = 0; i < parallel_get_max_threads(); i++) {
+			CN_workspace_set_threads(splParams->workspace[i], splParams->threads_per_evaluation);
+		}
+	}
+
+	/* Optional: 1 gives each NUMA node its own copy of the strain and spectral densities. Defaults to 0, one
+	 * copy read by every thread. Pair it with OMP_PROC_BIND and OMP_PLACES so the threads stay on their node.
+	 */
+	const char *numa_replicate = settings_file_get_value(settings_file, "numa_replicate");
+	if (numa_replicate != NULL && atoi(numa_replicate) != 0) {
+		pso_fitness_function_parameters_replicate(splParams);
+	}
+}
 
+/* Detaches the template cache and sky table attached by pso_settings_apply. Their owner frees them. */
+static void pso_settings_release(pso_fitness_function_parameters_t *splParams) {
+	size_t i;
+
+	if (splParams->template_cache != NULL) {
+		for (i = 0; i < parallel_get_max_threads(); i++) {
+			CN_workspace_set_template_cache(splParams->workspace[i], NULL);
+		}
+		splParams->template_cache = NULL;
+	}
+
+	if (splParams->sky_table != NULL) {
+		for (i = 0; i < parallel_get_max_threads(); i++) {
+			CN_workspace_set_sky_table(splParams->workspace[i], NULL);
+		}
+		splParams->sky_table = NULL;
+	}
+}
+
+/* One search with the given seed. Everything it uses is allocated by the caller and may be reused. */
+static void pso_run_trial(pso_driver_ptr driver, struct fitFuncParams *inParams, struct psoParamStruct *psoParams,
+		struct returnData *psoResults, gslseed_t seed, pso_result_t *result) {
+	pso_fitness_function_parameters_t *splParams = (pso_fitness_function_parameters_t*) inParams->splParams;
+	size_t cache_hits = 0, cache_misses = 0;
+
+	/* Set up pointer to fitness function. Use the prototype
+	declaration given in the header file for the fitness function. */
+	double (*fitfunc)(gsl_vector *, void *) = pso_fitness_function;
+
+	/* Soumya version gsl_rng_set(rngGen,2571971); */
+	gsl_rng_set(psoParams->rngGen, seed);
+	psoParams->rngSeed = seed;
+
+	if (splParams->template_cache != NULL) {
+		cache_hits = TC_hits(splParams->template_cache);
+		cache_misses = TC_misses(splParams->template_cache);
+	}
+
+	driver(inParams->nDim, fitfunc, inParams, psoParams, psoResults);
 
 	/* convert values to function ranges, instead of pso ranges */
 	// use the 0 index to convert the value
@@ -267,8 +678,68 @@ int pso_estimate_parameters(char *pso_settings_filename, pso_fitness_function_pa
 
 	result->total_iterations = psoResults->totalIterations;
 	result->total_func_evals = psoResults->totalFuncEvals;
+	result->stop_reason = psoResults->stopReason;
+	result->last_improvement_iteration = psoResults->lastImprovementIter;
+	fprintf(stderr, "PSO stopped by %s after %lu iterations, gbest last improved at iteration %lu\n",
+			psoStop_reason_name(result->stop_reason), result->total_iterations, result->last_improvement_iteration);
+
+	/* The cache outlives the trial, so count only the lookups made while it ran. Concurrent trials share the
+	   cache, and then these include the lookups of the trials running alongside. */
+	result->template_cache_hits = 0;
+	result->template_cache_misses = 0;
+	if (splParams->template_cache != NULL) {
+		result->template_cache_hits = TC_hits(splParams->template_cache) - cache_hits;
+		result->template_cache_misses = TC_misses(splParams->template_cache) - cache_misses;
+		fprintf(stderr, "Template cache: %lu hits, %lu misses\n", result->template_cache_hits, result->template_cache_misses);
+	}
+}
+
+int pso_estimate_parameters(char *pso_settings_filename, pso_fitness_function_parameters_t *splParams, gslseed_t seed, pso_result_t* result) {
+	assert(pso_settings_filename != NULL);
+	assert(splParams != NULL);
+	assert(result != NULL);
+
+	clock_t time_start = clock();
+
+	/* Error handling off */
+	gsl_error_handler_t *old_handler = gsl_set_error_handler_off ();
+
+	/* Initialize random number generator */
+	gsl_rng *rngGen = gsl_rng_alloc(gsl_rng_taus);
+
+	struct fitFuncParams *inParams = pso_search_space_alloc(splParams);
+
+	/* Set up storage for output from ptapso. */
+	struct returnData *psoResults = returnData_alloc(inParams->nDim);
+
+	/* Load the pso settings */
+	settings_file_t *settings_file = settings_file_open(pso_settings_filename);
+	if (settings_file == NULL) {
+		printf("Error opening the PSO settings file (%s). Aborting.\n", pso_settings_filename);
+		abort();
+	}
+
+	struct psoParamStruct psoParams;
+	pso_settings_load(settings_file, &psoParams);
+	psoParams.rngGen = rngGen;
+
+	template_cache_t *template_cache;
+	sky_geometry_table_t *sky_table;
+	pso_settings_shared_alloc(settings_file, splParams->f_low, splParams->f_high, splParams->network,
+			&template_cache, &sky_table);
+	pso_settings_apply(settings_file, template_cache, sky_table, splParams);
+	pso_fitness_function_placement_report(splParams);
+
+	pso_driver_ptr driver = pso_driver_name_to_ptr( settings_file_get_value(settings_file, "pso_version") );
+
+	settings_file_close(settings_file);
+
+	pso_run_trial(driver, inParams, &psoParams, psoResults, seed, result);
 	result->computation_time_secs = ((double) (clock() - time_start)) / CLOCKS_PER_SEC;
 
+	pso_settings_release(splParams);
+	pso_settings_shared_free(template_cache, sky_table);
+
 	/* Free allocated memory */
 	ffparam_free(inParams);
 	returnData_free(psoResults);
@@ -276,3 +747,120 @@ int pso_estimate_parameters(char *pso_settings_filename, pso_fitness_function_pa
 
 	return 0;
 }
+
+int pso_estimate_parameters_trials(char *pso_settings_filename, double f_low, double f_high,
+		detector_network_t *network, network_strain_half_fft_t *network_strain,
+		size_t num_trials, const gslseed_t *seeds, size_t num_teams,
+		pso_result_t *results, pso_trial_callback_ptr callback, void *callback_data) {
+	assert(pso_settings_filename != NULL);
+	assert(network != NULL);
+	assert(network_strain != NULL);
+	assert(seeds != NULL);
+	assert(num_teams > 0);
+
+	size_t num_threads = parallel_get_max_threads();
+	size_t next_trial = 0;
+
+	/* No more teams than trials or threads */
+	num_teams = GSL_MIN( num_teams, GSL_MAX( num_trials, 1 ) );
+	num_teams = GSL_MIN( num_teams, num_threads );
+
+	/* Error handling off */
+	gsl_set_error_handler_off ();
+
+	/* Read once, then only looked up by the teams */
+	settings_file_t *settings_file = settings_file_open(pso_settings_filename);
+	if (settings_file == NULL) {
+		printf("Error opening the PSO settings file (%s). Aborting.\n", pso_settings_filename);
+		abort();
+	}
+
+	struct psoParamStruct psoParamsSettings;
+	pso_settings_load(settings_file, &psoParamsSettings);
+	pso_driver_ptr driver = pso_driver_name_to_ptr( settings_file_get_value(settings_file, "pso_version") );
+
+	/* One template cache and sky table for all the teams, so a template computed by one is a hit for the others */
+	template_cache_t *template_cache;
+	sky_geometry_table_t *sky_table;
+	pso_settings_shared_alloc(settings_file, f_low, f_high, network, &template_cache, &sky_table);
+
+	fprintf(stderr, "Concurrent trials: %lu teams of about %lu threads for %lu trials\n",
+			num_teams, num_threads / num_teams, num_trials);
+
+	/* The teams, the particles of each team and the threads inside each evaluation */
+	parallel_set_max_active_levels(3);
+
+#ifdef HAVE_OPENMP
+	#pragma omp parallel num_threads(num_teams)
+#endif
+	{
+		size_t team = parallel_get_thread_num();
+		/* The threads left over go to the first teams */
+		size_t team_threads = num_threads / num_teams + (team < num_threads % num_teams ? 1 : 0);
+
+		/* Each team has its own workspaces, generator and swarm, kept for all the trials it runs. They are
+		   allocated by the team itself so their pages are placed where it runs. */
+		parallel_set_num_threads(team_threads);
+
+		pso_fitness_function_parameters_t *splParams =
+				pso_fitness_function_parameters_alloc(f_low, f_high, network, network_strain);
+		pso_settings_apply(settings_file, template_cache, sky_table, splParams);
+		/* Once, for the threads of the first team */
+		if (team == 0) {
+			pso_fitness_function_placement_report(splParams);
+		}
+
+		gsl_rng *rngGen = gsl_rng_alloc(gsl_rng_taus);
+		struct fitFuncParams *inParams = pso_search_space_alloc(splParams);
+		struct returnData *psoResults = returnData_alloc(inParams->nDim);
+		struct psoParamStruct psoParams = psoParamsSettings;
+		psoParams.rngGen = rngGen;
+
+		for (;;) {
+			size_t trial = num_trials;
+			pso_result_t result;
+			double time_start;
+
+#ifdef HAVE_OPENMP
+			#pragma omp critical (pso_trials_next)
+#endif
+			{
+				if (next_trial < num_trials) {
+					trial = next_trial;
+					next_trial++;
+				}
+			}
+			if (trial == num_trials) {
+				break;
+			}
+
+			/* Wall clock, since clock() would add up the time of all the threads of every team */
+			time_start = parallel_get_wtime();
+			pso_run_trial(driver, inParams, &psoParams, psoResults, seeds[trial], &result);
+			result.computation_time_secs = parallel_get_wtime() - time_start;
+
+			if (results != NULL) {
+				results[trial] = result;
+			}
+			if (callback != NULL) {
+#ifdef HAVE_OPENMP
+				#pragma omp critical (pso_trials_callback)
+#endif
+				{
+					callback(trial, seeds[trial], &result, callback_data);
+				}
+			}
+		}
+
+		pso_settings_release(splParams);
+		ffparam_free(inParams);
+		returnData_free(psoResults);
+		gsl_rng_free(rngGen);
+		pso_fitness_function_parameters_free(splParams);
+	}
+
+	pso_settings_shared_free(template_cache, sky_table);
+	settings_file_close(settings_file);
+
+	return 0;
+}
@@ -32,6 +32,13 @@ typedef struct pso_result_s {
 	size_t total_iterations;
 	size_t total_func_evals;
 	double computation_time_secs;
+	size_t template_cache_hits;
+	size_t template_cache_misses;
+
+	/* Why the search stopped (enum psoStopReason of pso.h) and the iteration at which the best fitness
+	 * last improved. */
+	int stop_reason;
+	size_t last_improvement_iteration;
 
 } pso_result_t;
 
@@ -40,7 +47,36 @@ typedef struct pso_fitness_function_parameters_s {
 	double f_high;
 	detector_network_t *network;
 	network_strain_half_fft_t *network_strain;
+
+	/* One read-only context shared by the workspaces, one workspace per thread. */
+	coherent_network_context_t *context;
 	coherent_network_workspace_t **workspace;
+
+	/* Shared by the workspaces of all threads, and by all the teams of pso_estimate_parameters_trials, when
+	 * enabled in the pso settings file, otherwise NULL.
+	 */
+	template_cache_t *template_cache;
+
+	/* Shared sky geometry table when enabled in the pso settings file, otherwise NULL. Shared like the cache. */
+	sky_geometry_table_t *sky_table;
+
+	/* Threads inside each evaluation. The particles are spread over max threads / threads_per_evaluation. */
+	size_t threads_per_evaluation;
+
+	/* The cpu and NUMA node of each thread, recorded when it allocated its workspace. */
+	size_t *thread_cpu;
+	size_t *thread_node;
+
+	/* The network and strain each thread reads. These are network and network_strain unless they have been
+	 * replicated, in which case they are the copies on the thread's node.
+	 */
+	detector_network_t **thread_network;
+	network_strain_half_fft_t **thread_strain;
+
+	/* One copy per NUMA node after pso_fitness_function_parameters_replicate, indexed by node, otherwise NULL. */
+	size_t num_nodes;
+	detector_network_t **replica_network;
+	network_strain_half_fft_t **replica_strain;
 } pso_fitness_function_parameters_t;
 
 pso_fitness_function_parameters_t* pso_fitness_function_parameters_alloc(
@@ -48,10 +84,40 @@ pso_fitness_function_parameters_t* pso_fitness_function_parameters_alloc(
 
 void pso_fitness_function_parameters_free(pso_fitness_function_parameters_t *params);
 
+/* Gives every NUMA node in use its own copy of the network (with the spectral densities) and of the strain
+ * half-FFTs, made by the first thread found on that node, and points each thread at the copy on its node.
+ * Only worthwhile when the threads are bound to places, see pso_fitness_function_placement_report.
+ */
+void pso_fitness_function_parameters_replicate(pso_fitness_function_parameters_t *params);
+
+/* Prints where each thread, its workspace and the data it reads were placed. */
+void pso_fitness_function_placement_report(pso_fitness_function_parameters_t *params);
+
 double pso_fitness_function(gsl_vector *xVec, void  *inParamsPointer);
 
+/* Batch form of pso_fitness_function. The valid points are split over the threads and each thread evaluates
+ * its share with coherent_network_statistic_batch.
+ */
+void pso_fitness_function_batch(size_t num_points, gsl_vector **xVec, void *inParamsPointer, double *fitFuncVal,
+		unsigned char *fitEvalFlag);
+
 int pso_estimate_parameters(char *pso_settings_file, pso_fitness_function_parameters_t *splParams, gslseed_t seed, pso_result_t* result);
 
+/* Called as each trial of pso_estimate_parameters_trials finishes, by one team at a time. */
+typedef void (*pso_trial_callback_ptr)(size_t trial, gslseed_t seed, pso_result_t *result, void *callback_data);
+
+/* Runs num_trials independent searches of the same data, trial i with seeds[i], num_teams of them at a time.
+ * The threads are split into num_teams teams. Each team has its own workspaces, generator and swarm, allocated
+ * once and reused for every trial it takes, and all the teams read the one network and network_strain. The pso
+ * settings file is read once. Trial i goes to results[i] (if results is not NULL), and callback (if not NULL) is
+ * called as soon as it finishes. A trial gives the same result as pso_estimate_parameters with the same seed
+ * and number of threads per team.
+ */
+int pso_estimate_parameters_trials(char *pso_settings_file, double f_low, double f_high,
+		detector_network_t *network, network_strain_half_fft_t *network_strain,
+		size_t num_trials, const gslseed_t *seeds, size_t num_teams,
+		pso_result_t *results, pso_trial_callback_ptr callback, void *callback_data);
+
 void CN_template_chirp_time(double f_low, double chirp_time0, double chirp_time1_5, inspiral_chirp_time_t *ct);
 
 #if defined (__cplusplus)
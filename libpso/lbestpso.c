@@ -1,6 +1,7 @@
 #include "pso.h"
 #include <stdio.h>
 #include <stddef.h>
+#include <string.h>
 #include <gsl/gsl_multimin.h>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
@@ -38,11 +39,6 @@ void lbestpso(size_t nDim, /*!< Number of search dimensions */
             struct psoParamStruct *psoParams, /*!< PSO parameter structure */
 			struct returnData *psoResults /*!< Output structure */){
 				
-	/* 
-	  Random numbers can be generated on the fly or read from a file. If a
-	  valid file is specified, generation of random numbers is overriden.
-	*/
-	gsl_rng *rngGen = psoParams->rngGen;
 	
 	/* Initialize local minimizer of gbest */
 	gsl_multimin_function func2minimz;
@@ -66,22 +62,28 @@ void lbestpso(size_t nDim, /*!< Number of search dimensions */
 	const size_t popsize = psoParams->popsize;
 	/* Number of iterations */
 	const size_t maxSteps = psoParams->maxSteps;
-	/* Information about a particles is stored in a struct array.
+	/* Information about the particles is stored in a structure of arrays.
 	*/
-    struct particleInfo pop[popsize];
+	struct swarmInfo *swarm = swarm_alloc(popsize, nDim);
 	/* initialize particles */
-	for (lpParticles = 0; lpParticles < popsize; lpParticles++){
-	      initPsoParticles(&pop[lpParticles], nDim, rngGen);
-    }	
+	swarm_init(swarm, psoParams);
 	/* Variables needed to find and track gbest */
 	double gbestFitVal = GSL_POSINF;
 	gsl_vector *gbestCoord = gsl_vector_alloc(nDim);
-	gsl_vector *partSnrCurrCol = gsl_vector_alloc(popsize);
+	gsl_vector_view partSnrCurrView = gsl_vector_view_array(swarm->partSnrCurr, popsize);
+	gsl_vector *partSnrCurrCol = &partSnrCurrView.vector;
 	size_t bestfitParticle;
 	double currBestFitVal;
 	/* Variables needed to keep track of number of fitness function evaluations */
 	unsigned char computeOK;
 	size_t funcCount;
+	/* Used with the batch fitness function */
+	gsl_vector *batchCoord[popsize];
+	double batchFitVal[popsize];
+	unsigned char batchEvalFlag[popsize];
+	/* Stopping criteria besides maxSteps */
+	struct psoStopState stop;
+	psoStop_init(&stop);
 	/* Variables needed in PSO dynamical equation update */
 	size_t lpNbrs; /* Loop counter over nearest neighbors */
 	size_t nNbrs = 3;
@@ -89,13 +91,6 @@ void lbestpso(size_t nDim, /*!< Number of search dimensions */
 	double nbrFitVal; /*Fitness of a neighbor */
 	size_t lbestPart; /* local best particle */
 	double lbestFit; /* Fitness of local best particle */
-	/* Variables needed for PSO dynamical equations */
-	size_t lpCoord;
-	gsl_vector *accVecPbest = gsl_vector_alloc(nDim);
-	gsl_vector *accVecLbest = gsl_vector_alloc(nDim);
-	gsl_vector *chi1Vec = gsl_vector_alloc(nDim);
-	gsl_vector *chi2Vec = gsl_vector_alloc(nDim);
-	
 	/* 
 	   Start PSO iterations from the second iteration since the first is used
 	   above for initialization.
@@ -105,32 +100,44 @@ void lbestpso(size_t nDim, /*!< Number of search dimensions */
 
 		if (psoParams->debugDumpFile != NULL){
 			fprintf(psoParams->debugDumpFile,"Loop %zu \n",lpPsoIter);
-			particleInfoDump(psoParams->debugDumpFile,pop,popsize);
+			swarmDump(psoParams->debugDumpFile,swarm);
 		}		
         /* Calculate fitness values */
+		if (psoParams->batchFitfunc != NULL){
+			for (lpParticles = 0; lpParticles < popsize; lpParticles++){
+				batchCoord[lpParticles] = &swarm->coordView[lpParticles].vector;
+			}
+			/* The batch fitness function does its own parallelization */
+			psoParams->batchFitfunc(popsize, batchCoord, ffParams, batchFitVal, batchEvalFlag);
+		}
 #ifdef HAVE_OMP
 		#pragma omp parallel for
 #endif
 		for (lpParticles = 0; lpParticles < popsize; lpParticles++){
-			/* Evaluate fitness */
-			pop[lpParticles].partSnrCurr = fitfunc(pop[lpParticles].partCoord,ffParams);
-			//fprintf(stderr, "Done evaluating the fitness function...\n");
-			/* Separately store all fitness values -- needed to find best particle */
-			gsl_vector_set(partSnrCurrCol,lpParticles,pop[lpParticles].partSnrCurr);
-			/* Check if fitness function was actually evaluated or not */
-	        computeOK = ((struct fitFuncParams *)ffParams)->fitEvalFlag[parallel_get_thread_num()];
+			if (psoParams->batchFitfunc != NULL){
+				swarm->partSnrCurr[lpParticles] = batchFitVal[lpParticles];
+				computeOK = batchEvalFlag[lpParticles];
+			}
+			else{
+				/* Evaluate fitness */
+				swarm->partSnrCurr[lpParticles] = fitfunc(&swarm->coordView[lpParticles].vector,ffParams);
+				//fprintf(stderr, "Done evaluating the fitness function...\n");
+				/* Check if fitness function was actually evaluated or not */
+				computeOK = ((struct fitFuncParams *)ffParams)->fitEvalFlag[parallel_get_thread_num()];
+			}
+			/* partSnrCurrCol views all the fitness values -- needed to find best particle */
 	        funcCount = 0;
 	        if (computeOK){
 			    /* Increment fitness function evaluation count */
 	            funcCount = 1;
 			}
-	        pop[lpParticles].partFitEvals += funcCount;
+	        swarm->partFitEvals[lpParticles] += funcCount;
 			/* Update pbest fitness and coordinates if needed */
-	        if (pop[lpParticles].partSnrPbest > pop[lpParticles].partSnrCurr){
-	            pop[lpParticles].partSnrPbest = pop[lpParticles].partSnrCurr;
+	        if (swarm->partSnrPbest[lpParticles] > swarm->partSnrCurr[lpParticles]){
+	            swarm->partSnrPbest[lpParticles] = swarm->partSnrCurr[lpParticles];
 
 	            /* This is causing a segfault using openmp */
-	            gsl_vector_memcpy(pop[lpParticles].partPbest,pop[lpParticles].partCoord);
+	            memcpy(swarm->partPbest + lpParticles * nDim, swarm->partCoord + lpParticles * nDim, nDim * sizeof(double));
 	        }
 	    }
 		
@@ -138,13 +145,13 @@ void lbestpso(size_t nDim, /*!< Number of search dimensions */
 
 		/* Find the best particle in the current iteration */
 		bestfitParticle = gsl_vector_min_index(partSnrCurrCol);
-	    currBestFitVal = pop[bestfitParticle].partSnrCurr; 
+	    currBestFitVal = swarm->partSnrCurr[bestfitParticle]; 
 	    if (gbestFitVal > currBestFitVal){
 		/* 
 		   Do local minimization iterations since gbest has changed.
 		*/
 		   	gsl_multimin_fminimizer_set(minimzrState,&func2minimz,
-			                            pop[bestfitParticle].partCoord,
+			                            &swarm->coordView[bestfitParticle].vector,
 										locMinStp);
 			funcCount = 0;
 			
@@ -157,20 +164,22 @@ void lbestpso(size_t nDim, /*!< Number of search dimensions */
 				   one for the nmsimplex2 algorithm as GSL routines 
 				   do not return this information.*/
 				funcCount += nDim+1;
-				pop[bestfitParticle].partSnrCurr = gsl_multimin_fminimizer_minimum(minimzrState);
-                gsl_vector_memcpy(pop[bestfitParticle].partCoord, minimzrState->x);
+				swarm->partSnrCurr[bestfitParticle] = gsl_multimin_fminimizer_minimum(minimzrState);
+                gsl_vector_memcpy(&swarm->coordView[bestfitParticle].vector, minimzrState->x);
 			}
 			
-	        pop[bestfitParticle].partFitEvals += funcCount;
+	        swarm->partFitEvals[bestfitParticle] += funcCount;
 			/* Update particle pbest */
-			pop[bestfitParticle].partSnrPbest = pop[bestfitParticle].partSnrCurr;
-			gsl_vector_memcpy(pop[bestfitParticle].partPbest,pop[bestfitParticle].partCoord);
+			swarm->partSnrPbest[bestfitParticle] = swarm->partSnrCurr[bestfitParticle];
+			memcpy(swarm->partPbest + bestfitParticle * nDim, swarm->partCoord + bestfitParticle * nDim, nDim * sizeof(double));
 			/* Update gbest */
-			gbestFitVal = pop[bestfitParticle].partSnrCurr;
-			gsl_vector_memcpy(gbestCoord,pop[bestfitParticle].partCoord);
-			/* Update list of fitness Values */
-			gsl_vector_set(partSnrCurrCol,bestfitParticle,pop[bestfitParticle].partSnrCurr);
+			gbestFitVal = swarm->partSnrCurr[bestfitParticle];
+			gsl_vector_memcpy(gbestCoord,&swarm->coordView[bestfitParticle].vector);
 		}
+
+		/* No need to move the swarm again if PSO stops here */
+		if (psoStop_update(&stop, psoParams, swarm, lpPsoIter, gbestFitVal))
+			break;
 		
 		/* Get lbest */
 	    for (lpParticles = 0; lpParticles < popsize; lpParticles++){
@@ -193,67 +202,31 @@ void lbestpso(size_t nDim, /*!< Number of search dimensions */
 					   lbestFit = nbrFitVal;
 				   }
 			   }
-	           if (lbestFit < pop[lpParticles].partSnrLbest){
-	               pop[lpParticles].partSnrLbest = lbestFit;
-	               gsl_vector_memcpy(pop[lpParticles].partLocalBest,
-				                     pop[lbestPart].partCoord);
+	           if (lbestFit < swarm->partSnrLbest[lpParticles]){
+	               swarm->partSnrLbest[lpParticles] = lbestFit;
+	               memcpy(swarm->partLocalBest + lpParticles * nDim,
+				                     swarm->partCoord + lbestPart * nDim, nDim * sizeof(double));
 	           }
 		}
         
 
 	    for (lpParticles = 0; lpParticles < popsize; lpParticles++){
 			/* Update inertia Weight */
-		    pop[lpParticles].partInertia = psoParams->dcLaw_a-(psoParams->dcLaw_b/psoParams->dcLaw_c)*lpPsoIter;
-			if (pop[lpParticles].partInertia < psoParams->dcLaw_d)
-				pop[lpParticles].partInertia = psoParams->dcLaw_d;
-		    /* Acceleration vector to pbest */
-			gsl_vector_memcpy(accVecPbest,pop[lpParticles].partPbest);
-			gsl_vector_sub(accVecPbest,pop[lpParticles].partCoord);
-			/* Acceleration vector to lbest */
-			gsl_vector_memcpy(accVecLbest,pop[lpParticles].partLocalBest);
-			gsl_vector_sub(accVecLbest,pop[lpParticles].partCoord);
-			/* Random weights for acceleration components */
-			for (lpCoord = 0; lpCoord < nDim; lpCoord++){
-				gsl_vector_set(chi1Vec,lpCoord,gsl_rng_uniform(rngGen));
-			}
-			for (lpCoord = 0; lpCoord < nDim; lpCoord++){
-				gsl_vector_set(chi2Vec,lpCoord,gsl_rng_uniform(rngGen));
-			}
-			/* Multiply random weights */
-			gsl_vector_mul(accVecPbest,chi1Vec);
-			gsl_vector_mul(accVecLbest,chi2Vec);
-			/* Scale with acceleration constants */
-			gsl_vector_scale(accVecPbest,psoParams->c1);
-			gsl_vector_scale(accVecLbest,psoParams->c2);
-            /* Velocity update 			
-		        pop(k,partVelCols)=partInertia*pop(k,partVelCols)+...
-		                           c1*(pop(k,partPbestCols)-pop(k,partCoordCols))*chi1+...
-		                           c2*(pop(k,partLocalBestCols)-pop(k,partCoordCols))*chi2;
-			*/
-			gsl_vector_scale(pop[lpParticles].partVel,pop[lpParticles].partInertia);
-			gsl_vector_add(pop[lpParticles].partVel,accVecPbest);
-			gsl_vector_add(pop[lpParticles].partVel,accVecLbest);
-			/*
-			  Apply max. velocity threshold
-		        maxvBustCompPos = find(pop(k,partVelCols) > max_velocity);
-		        maxvBustCompNeg = find(pop(k,partVelCols) < -max_velocity);
-		        if ~isempty(maxvBustCompPos)
-		            pop(k,partVelCols(maxvBustCompPos))= max_velocity;
-		        end
-		        if ~isempty(maxvBustCompNeg)
-		            pop(k,partVelCols(maxvBustCompNeg))= -max_velocity(1);
-		        end
-			*/
-			limitVecComponent(pop[lpParticles].partVel, - psoParams->max_velocity, psoParams->max_velocity);
-			/* 
-				Position Update
-			*/
-	        gsl_vector_add(pop[lpParticles].partCoord,pop[lpParticles].partVel);        
+		    swarm->partInertia[lpParticles] = psoParams->dcLaw_a-(psoParams->dcLaw_b/psoParams->dcLaw_c)*lpPsoIter;
+			if (swarm->partInertia[lpParticles] < psoParams->dcLaw_d)
+				swarm->partInertia[lpParticles] = psoParams->dcLaw_d;
 	    }
+		/* Random weights for acceleration components, then velocity update, max. velocity threshold and
+		   position update of the whole swarm
+	        pop(k,partVelCols)=partInertia*pop(k,partVelCols)+...
+	                           c1*(pop(k,partPbestCols)-pop(k,partCoordCols))*chi1+...
+	                           c2*(pop(k,partLocalBestCols)-pop(k,partCoordCols))*chi2;
+		*/
+		swarm_advance(swarm, psoParams, lpPsoIter);
 		
 		if (psoParams->debugDumpFile != NULL){
 			fprintf(psoParams->debugDumpFile,"After dynamical update\n");   
-			particleInfoDump(psoParams->debugDumpFile,pop,popsize);
+			swarmDump(psoParams->debugDumpFile,swarm);
 			fprintf(psoParams->debugDumpFile,"--------\n");			      
 	    }
 
@@ -261,11 +234,13 @@ void lbestpso(size_t nDim, /*!< Number of search dimensions */
 	}
 	
 	/* Prepare output */
-	psoResults->totalIterations = lpPsoIter-1;
+	psoResults->totalIterations = (stop.reason == PSO_STOP_MAX_STEPS) ? lpPsoIter-1 : lpPsoIter;
+	psoResults->stopReason = stop.reason;
+	psoResults->lastImprovementIter = stop.lastImprovementIter;
 	/* 	actualEvaluations = sum(pop(:,partFitEvalsCols)); */
 	psoResults->totalFuncEvals = 0;
 	for (lpParticles = 0; lpParticles < popsize; lpParticles ++){
-		psoResults->totalFuncEvals += pop[lpParticles].partFitEvals;
+		psoResults->totalFuncEvals += swarm->partFitEvals[lpParticles];
 	}
 	gsl_vector_memcpy(psoResults->bestLocation, gbestCoord);
 	psoResults->bestFitVal = gbestFitVal;
@@ -275,13 +250,6 @@ void lbestpso(size_t nDim, /*!< Number of search dimensions */
 	/* Deallocate vectors */
 	gsl_vector_free(locMinStp);
 	gsl_vector_free(gbestCoord);
-	gsl_vector_free(partSnrCurrCol);
-	gsl_vector_free(accVecPbest);
-    gsl_vector_free(accVecLbest); 
-	gsl_vector_free(chi1Vec);
-	gsl_vector_free(chi2Vec); 
-	/* Deallocate members of pop */
-	for(lpParticles = 0; lpParticles < popsize; lpParticles++){
-		particleinfo_free(&pop[lpParticles]);
-	}
+	/* Deallocate the swarm */
+	swarm_free(swarm);
 }
@@ -11,6 +11,23 @@
 	#include "config.h"
 #endif
 
+#ifdef __linux__
+	#include <sys/syscall.h>
+	#include <unistd.h>
+#endif
+
+void parallel_get_cpu_and_node(size_t *cpu, size_t *node) {
+	unsigned int c = 0, n = 0;
+#if defined(__linux__) && defined(SYS_getcpu)
+	if (syscall(SYS_getcpu, &c, &n, NULL) != 0) {
+		c = 0;
+		n = 0;
+	}
+#endif
+	*cpu = c;
+	*node = n;
+}
+
 #ifdef HAVE_OPENMP
 	#include "omp.h"
 
@@ -22,7 +39,28 @@ size_t parallel_get_max_threads() {
 	return omp_get_max_threads();
 }
 
+size_t parallel_get_level() {
+	return omp_get_level();
+}
+
+void parallel_set_num_threads(size_t num_threads) {
+	omp_set_num_threads(num_threads);
+}
+
+void parallel_set_max_active_levels(size_t levels) {
+	omp_set_max_active_levels(levels);
+}
+
+int parallel_threads_bound() {
+	return omp_get_proc_bind() != omp_proc_bind_false;
+}
+
+double parallel_get_wtime() {
+	return omp_get_wtime();
+}
+
 #else
+	#include <time.h>
 
 size_t parallel_get_thread_num() {
 	return 0;
@@ -32,4 +70,24 @@ size_t parallel_get_max_threads() {
 	return 1;
 }
 
+size_t parallel_get_level() {
+	return 0;
+}
+
+void parallel_set_num_threads(size_t num_threads) {
+}
+
+void parallel_set_max_active_levels(size_t levels) {
+}
+
+int parallel_threads_bound() {
+	return 0;
+}
+
+double parallel_get_wtime() {
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + 1e-9 * now.tv_nsec;
+}
+
 #endif
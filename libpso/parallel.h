@@ -21,6 +21,25 @@ extern "C" {
 size_t parallel_get_thread_num();
 size_t parallel_get_max_threads();
 
+/* Number of parallel regions enclosing the caller, 0 outside any. */
+size_t parallel_get_level();
+
+/* Number of threads of the parallel regions that follow. */
+void parallel_set_num_threads(size_t num_threads);
+
+/* Allows parallel regions nested up to this depth to use more than one thread. */
+void parallel_set_max_active_levels(size_t levels);
+
+/* 1 if the threads are bound to places (OMP_PROC_BIND and OMP_PLACES), so that each keeps its core and
+ * NUMA node for the whole run. */
+int parallel_threads_bound();
+
+/* Elapsed wall-clock time in seconds since some fixed point in the past, for timing runs that use several threads. */
+double parallel_get_wtime();
+
+/* The cpu and NUMA node the calling thread is running on, or 0 and 0 where the system does not say. */
+void parallel_get_cpu_and_node(size_t *cpu, size_t *node);
+
 #if defined (__cplusplus)
 }
 #endif
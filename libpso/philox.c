@@ -0,0 +1,56 @@
+/*
+ * philox.c
+ */
+
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif
+
+#include "philox.h"
+
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]) {
+	uint32_t c0 = ctr[0], c1 = ctr[1], c2 = ctr[2], c3 = ctr[3];
+	uint32_t k0 = key[0], k1 = key[1];
+	int r;
+
+	for (r = 0; r < PHILOX_ROUNDS; r++) {
+		uint64_t p0 = (uint64_t) PHILOX_M0 * c0;
+		uint64_t p1 = (uint64_t) PHILOX_M1 * c2;
+
+		c0 = (uint32_t) (p1 >> 32) ^ c1 ^ k0;
+		c1 = (uint32_t) p1;
+		c2 = (uint32_t) (p0 >> 32) ^ c3 ^ k1;
+		c3 = (uint32_t) p0;
+
+		k0 += PHILOX_W0;
+		k1 += PHILOX_W1;
+	}
+
+	out[0] = c0;
+	out[1] = c1;
+	out[2] = c2;
+	out[3] = c3;
+}
+
+/* The top 53 bits of hi:lo, scaled to [0,1) */
+static double philox_to_double(uint32_t hi, uint32_t lo) {
+	uint64_t bits = (((uint64_t) hi << 32) | lo) >> 11;
+	return bits * (1.0 / 9007199254740992.0);
+}
+
+void philox_uniform2(unsigned long seed, uint32_t stream, size_t iteration, size_t particle, size_t coordinate,
+		double out[2]) {
+	uint32_t key[2] = { (uint32_t) seed, (uint32_t) ((uint64_t) seed >> 32) };
+	uint32_t ctr[4] = { (uint32_t) iteration, (uint32_t) particle, (uint32_t) coordinate, stream };
+	uint32_t bits[4];
+
+	philox4x32(ctr, key, bits);
+	out[0] = philox_to_double(bits[0], bits[1]);
+	out[1] = philox_to_double(bits[2], bits[3]);
+}
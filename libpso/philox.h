@@ -0,0 +1,35 @@
+/*
+ * philox.h
+ *
+ * Counter-based random numbers (Philox4x32-10, Salmon et al., "Parallel random numbers: as easy as 1, 2, 3",
+ * SC11). Each output is a pure function of a key and a counter, so a value can be computed by any thread, in
+ * any order, and a run gives the same numbers whatever the number of threads.
+ */
+
+#ifndef LIBPSO_PHILOX_H_
+#define LIBPSO_PHILOX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined (__cplusplus)
+extern "C" {
+#endif
+
+/* What the numbers are used for, so that the streams of the PSO never overlap */
+#define PHILOX_STREAM_INIT 0
+#define PHILOX_STREAM_WEIGHTS 1
+
+/* Philox4x32 with 10 rounds: out = bijection of ctr under key */
+void philox4x32(const uint32_t ctr[4], const uint32_t key[2], uint32_t out[4]);
+
+/* Two independent uniform numbers in [0,1), with 53 random bits each, for the given seed, stream, iteration,
+ * particle and coordinate. */
+void philox_uniform2(unsigned long seed, uint32_t stream, size_t iteration, size_t particle, size_t coordinate,
+		double out[2]);
+
+#if defined (__cplusplus)
+}
+#endif
+
+#endif /* LIBPSO_PHILOX_H_ */
@@ -6,7 +6,9 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #include <gsl/gsl_multimin.h>
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_matrix.h>
@@ -15,6 +17,7 @@
 
 #include "ptapso_maxphase.h"
 #include "parallel.h"
+#include "philox.h"
 
 #include "pso.h"
 
@@ -30,51 +33,240 @@ double dummyfitfunc(const gsl_vector *xVec, void *dffParams){
 	return funcVal;
 }
 
-/*! Initializer of particle position, velocity, and other properties. */
-void initPsoParticles(struct particleInfo *p, size_t nDim, gsl_rng *rngGen){
+/*! Allocate a swarm. The matrices and the per-particle values are zeroed blocks of one arena. */
+struct swarmInfo * swarm_alloc(size_t popsize, size_t nDim){
+	size_t lpParticles;
+	size_t nElems = popsize * nDim;
+	struct swarmInfo *s = (struct swarmInfo *)malloc(sizeof(struct swarmInfo));
+	if (s == NULL){
+		fprintf(stderr, "Error. Unable to allocate memory for the swarm. Exiting.\n");
+		exit(-1);
+	}
 
-	double rngNum;
-	size_t lpCoord;
+	/* One chunk for the 12 arrays and their alignment padding */
+	s->arena = AR_alloc((6 * nElems + 4 * popsize) * sizeof(double) + popsize * (sizeof(size_t) + sizeof(gsl_vector_view))
+			+ 12 * ARENA_ALIGNMENT, AR_get_default_pages());
 
-	particleinfo_alloc(p,nDim);
+	s->popsize = popsize;
+	s->nDim = nDim;
+	s->partCoord = (double *)AR_calloc(s->arena, nElems, sizeof(double));
+	s->partVel = (double *)AR_calloc(s->arena, nElems, sizeof(double));
+	s->partPbest = (double *)AR_calloc(s->arena, nElems, sizeof(double));
+	s->partLocalBest = (double *)AR_calloc(s->arena, nElems, sizeof(double));
+	s->chi1 = (double *)AR_calloc(s->arena, nElems, sizeof(double));
+	s->chi2 = (double *)AR_calloc(s->arena, nElems, sizeof(double));
+	s->partSnrPbest = (double *)AR_calloc(s->arena, popsize, sizeof(double));
+	s->partSnrCurr = (double *)AR_calloc(s->arena, popsize, sizeof(double));
+	s->partSnrLbest = (double *)AR_calloc(s->arena, popsize, sizeof(double));
+	s->partInertia = (double *)AR_calloc(s->arena, popsize, sizeof(double));
+	s->partFitEvals = (size_t *)AR_calloc(s->arena, popsize, sizeof(size_t));
+	s->coordView = (gsl_vector_view *)AR_malloc(s->arena, popsize * sizeof(gsl_vector_view));
 
-	for (lpCoord = 0; lpCoord < nDim; lpCoord++){
-		rngNum = gsl_rng_uniform(rngGen);
-		gsl_vector_set(p->partCoord,lpCoord,rngNum);
+	for (lpParticles = 0; lpParticles < popsize; lpParticles++){
+		s->coordView[lpParticles] = gsl_vector_view_array(s->partCoord + lpParticles * nDim, nDim);
 	}
 
-	for (lpCoord = 0; lpCoord < nDim; lpCoord++){
-		rngNum = gsl_rng_uniform(rngGen);
-		rngNum = - gsl_vector_get(p->partCoord,lpCoord)
-			     + rngNum;
-		gsl_vector_set(p->partVel,lpCoord,rngNum);
+	return s;
+}
+
+/*! Free the storage assigned to a swarm */
+void swarm_free(struct swarmInfo *s){
+	AR_free(s->arena);
+	s->arena = NULL;
+	free(s);
+}
+
+/*! Initializer of particle positions, velocities, and other properties. */
+void swarm_init(struct swarmInfo *s, const struct psoParamStruct *psoParams){
+	size_t lpParticles, lpCoord;
+	const size_t nDim = s->nDim;
+	double u[2];
+
+	for (lpParticles = 0; lpParticles < s->popsize; lpParticles++){
+		double *x = s->partCoord + lpParticles * nDim;
+		double *v = s->partVel + lpParticles * nDim;
+
+		if (psoParams->counterRng){
+			for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+				philox_uniform2(psoParams->rngSeed, PHILOX_STREAM_INIT, 0, lpParticles, lpCoord, u);
+				x[lpCoord] = u[0];
+				v[lpCoord] = - x[lpCoord] + u[1];
+			}
+		}
+		else{
+			for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+				x[lpCoord] = gsl_rng_uniform(psoParams->rngGen);
+			}
+			for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+				v[lpCoord] = - x[lpCoord] + gsl_rng_uniform(psoParams->rngGen);
+			}
+		}
+		memcpy(s->partPbest + lpParticles * nDim, x, nDim * sizeof(double));
+
+		s->partSnrPbest[lpParticles] = GSL_POSINF;
+		s->partSnrCurr[lpParticles] = 0;
+		s->partSnrLbest[lpParticles] = GSL_POSINF;
+		s->partInertia[lpParticles] = 0;
+		s->partFitEvals[lpParticles] = 0;
+	}
+}
+
+void swarm_draw_weights(struct swarmInfo *s, size_t first, size_t count, gsl_rng *rngGen){
+	size_t lpParticles, lpCoord;
+	const size_t nDim = s->nDim;
+
+	for (lpParticles = first; lpParticles < first + count; lpParticles++){
+		for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+			s->chi1[lpParticles * nDim + lpCoord] = gsl_rng_uniform(rngGen);
+		}
+		for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+			s->chi2[lpParticles * nDim + lpCoord] = gsl_rng_uniform(rngGen);
+		}
+	}
+}
+
+void swarm_draw_weights_counter(struct swarmInfo *s, size_t first, size_t count, unsigned long seed, size_t iteration){
+	size_t lpParticles, lpCoord;
+	const size_t nDim = s->nDim;
+	double u[2];
+
+	for (lpParticles = first; lpParticles < first + count; lpParticles++){
+		for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+			philox_uniform2(seed, PHILOX_STREAM_WEIGHTS, iteration, lpParticles, lpCoord, u);
+			s->chi1[lpParticles * nDim + lpCoord] = u[0];
+			s->chi2[lpParticles * nDim + lpCoord] = u[1];
+		}
+	}
+}
+
+/*! The update of every coordinate of every particle is independent, so after scaling the velocities by the
+inertia weights the rest is a single loop over the count * nDim elements, which the compiler vectorizes.
+The operations are those of the per-particle vector version, in the same order:
+	v = inertia * v + c1 * (pbest - x) * chi1 + c2 * (lbest - x) * chi2, clamped to [-max_velocity, max_velocity]
+	x = x + v
+*/
+void swarm_update(struct swarmInfo *s, size_t first, size_t count, const struct psoParamStruct *psoParams){
+	size_t lpParticles, lpCoord, k;
+	const size_t nDim = s->nDim;
+	const size_t n = count * nDim;
+	const double c1 = psoParams->c1;
+	const double c2 = psoParams->c2;
+	const double maxVel = psoParams->max_velocity;
+	double *restrict x = s->partCoord + first * nDim;
+	double *restrict v = s->partVel + first * nDim;
+	const double *restrict pbest = s->partPbest + first * nDim;
+	const double *restrict lbest = s->partLocalBest + first * nDim;
+	const double *restrict chi1 = s->chi1 + first * nDim;
+	const double *restrict chi2 = s->chi2 + first * nDim;
+
+	for (lpParticles = 0; lpParticles < count; lpParticles++){
+		const double inertia = s->partInertia[first + lpParticles];
+		for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+			v[lpParticles * nDim + lpCoord] *= inertia;
+		}
+	}
+
+	for (k = 0; k < n; k++){
+		double vel = (v[k] + ((pbest[k] - x[k]) * chi1[k]) * c1) + ((lbest[k] - x[k]) * chi2[k]) * c2;
+		vel = (vel < -maxVel) ? -maxVel : ((vel > maxVel) ? maxVel : vel);
+		v[k] = vel;
+		x[k] += vel;
 	}
+}
+
+void swarm_advance(struct swarmInfo *s, const struct psoParamStruct *psoParams, size_t iteration){
+	size_t lpChunks;
+	size_t nChunks = GSL_MIN(parallel_get_max_threads(), s->popsize);
+
+	if (!psoParams->counterRng){
+		swarm_draw_weights(s, 0, s->popsize, psoParams->rngGen);
+		swarm_update(s, 0, s->popsize, psoParams);
+		return;
+	}
+
+	/* One contiguous chunk of particles per thread */
+#ifdef HAVE_OPENMP
+	#pragma omp parallel for if (nChunks > 1)
+#endif
+	for (lpChunks = 0; lpChunks < nChunks; lpChunks++){
+		size_t first = lpChunks * s->popsize / nChunks;
+		size_t last = (lpChunks + 1) * s->popsize / nChunks;
+		swarm_draw_weights_counter(s, first, last - first, psoParams->rngSeed, iteration);
+		swarm_update(s, first, last - first, psoParams);
+	}
+}
+
+double swarm_diameter(const struct swarmInfo *s){
+	size_t lpParticles, lpCoord;
+	const size_t nDim = s->nDim;
+	double diameter = 0;
 
-	if(gsl_vector_memcpy(p->partPbest, p->partCoord))
-		printf("Error in copying vectors\n");
+	for (lpCoord = 0; lpCoord < nDim; lpCoord++){
+		double xMin = s->partCoord[lpCoord];
+		double xMax = xMin;
+		for (lpParticles = 1; lpParticles < s->popsize; lpParticles++){
+			double x = s->partCoord[lpParticles * nDim + lpCoord];
+			xMin = (x < xMin) ? x : xMin;
+			xMax = (x > xMax) ? x : xMax;
+		}
+		diameter = GSL_MAX(diameter, xMax - xMin);
+	}
+	return diameter;
+}
 
-	p->partSnrPbest = GSL_POSINF;
-	p->partSnrCurr = 0;
-	p->partSnrLbest = GSL_POSINF;
-	p->partInertia = 0;
-	p->partFitEvals = 0;
+void psoStop_init(struct psoStopState *stop){
+	stop->refFitVal = GSL_POSINF;
+	stop->lastImprovementIter = 0;
+	stop->reason = PSO_STOP_MAX_STEPS;
 }
 
+int psoStop_update(struct psoStopState *stop, const struct psoParamStruct *psoParams, const struct swarmInfo *s,
+			size_t iteration, double gbestFitVal){
+	size_t lpParticles, funcEvals = 0;
 
-/*! Allocate storage for members of particleInfo structure */
-void particleinfo_alloc(struct particleInfo *p, size_t nDim){
-	p->partCoord = gsl_vector_alloc(nDim); /* Current coordinates */
-	p->partVel = gsl_vector_alloc(nDim);  /* Current velocity */
-	p->partPbest = gsl_vector_alloc(nDim); /* Coordinates of pbest */
-	p->partLocalBest = gsl_vector_alloc(nDim); /* Coordinates of neighborhood best */
+	/* Improvements smaller than stallTol add up until they count */
+	if (stop->refFitVal - gbestFitVal > psoParams->stallTol){
+		stop->refFitVal = gbestFitVal;
+		stop->lastImprovementIter = iteration;
+	}
+
+	if (psoParams->stallSteps > 0 && iteration - stop->lastImprovementIter >= psoParams->stallSteps){
+		stop->reason = PSO_STOP_STALL;
+		return 1;
+	}
+	if (s == NULL){
+		return 0;
+	}
+	if (psoParams->minSwarmDiameter > 0 && swarm_diameter(s) < psoParams->minSwarmDiameter){
+		stop->reason = PSO_STOP_DIAMETER;
+		return 1;
+	}
+	if (psoParams->maxFuncEvals > 0){
+		for (lpParticles = 0; lpParticles < s->popsize; lpParticles++){
+			funcEvals += s->partFitEvals[lpParticles];
+		}
+		if (funcEvals >= psoParams->maxFuncEvals){
+			stop->reason = PSO_STOP_FUNC_EVALS;
+			return 1;
+		}
+	}
+	return 0;
 }
 
-/*! Free the storage assigned to members of particleInfo structure */
-void particleinfo_free(struct particleInfo *p){
-	gsl_vector_free(p->partCoord);
-	gsl_vector_free(p->partVel);
-	gsl_vector_free(p->partPbest);
-	gsl_vector_free(p->partLocalBest);
+const char* psoStop_reason_name(int reason){
+	switch (reason){
+	case PSO_STOP_MAX_STEPS:
+		return "maxSteps";
+	case PSO_STOP_STALL:
+		return "stallSteps";
+	case PSO_STOP_DIAMETER:
+		return "minSwarmDiameter";
+	case PSO_STOP_FUNC_EVALS:
+		return "maxFuncEvals";
+	default:
+		fprintf(stderr, "Error. psoStop_reason_name: Invalid stop reason (%d). Exiting.\n", reason);
+		exit(-1);
+	}
 }
 
 /*! Allocate storage for returnData struct members */
@@ -92,55 +284,54 @@ void returnData_free(struct returnData *psoResults){
 }
 
 
-/*! Dump information stored in particleInfo struct */
-void particleinfo_fwrite(FILE *outF, struct particleInfo *p){
+/*! Dump the coordinates and velocity of one particle */
+void swarm_fwrite(FILE *outF, const struct swarmInfo *s, size_t part){
 
-	size_t nDim = p->partCoord->size;
+	size_t nDim = s->nDim;
 	size_t lpc;
 
 	fprintf(outF,"Particle locations in standardized coordinates\n");
 	for (lpc = 0; lpc < nDim; lpc++){
-		fprintf(outF,"%f ",gsl_vector_get(p->partCoord,lpc));
+		fprintf(outF,"%f ",s->partCoord[part * nDim + lpc]);
 	}
 	fprintf(outF,"\n");
 	fprintf(outF,"Particle velocities in standardized coordinates\n");
 	for (lpc = 0; lpc < nDim; lpc++){
-		fprintf(outF,"%f ",gsl_vector_get(p->partVel,lpc));
+		fprintf(outF,"%f ",s->partVel[part * nDim + lpc]);
 	}
 	fprintf(outF,"\n -------- \n");
 }
 
-/*! Dump particleInfo struct array information as a matrix
+/*! Dump the swarm as a matrix
 with all information pertaining to one particle in a row.
 */
-void particleInfoDump(FILE *outF, struct particleInfo *p, size_t popsize){
+void swarmDump(FILE *outF, const struct swarmInfo *s){
 	if (outF == NULL) {
 		return;
 	}
 
-	size_t nDim = p[0].partCoord->size;
+	size_t nDim = s->nDim;
 	size_t lpParticles, lpCoord;
 
-	for (lpParticles = 0; lpParticles < popsize; lpParticles++){
+	for (lpParticles = 0; lpParticles < s->popsize; lpParticles++){
 		for(lpCoord = 0; lpCoord < nDim; lpCoord++){
-			fprintf(outF,"%lf ",gsl_vector_get(p[lpParticles].partCoord,lpCoord));
+			fprintf(outF,"%lf ",s->partCoord[lpParticles * nDim + lpCoord]);
 		}
 		for(lpCoord = 0; lpCoord < nDim; lpCoord++){
-			fprintf(outF,"%lf ",gsl_vector_get(p[lpParticles].partVel,lpCoord));
+			fprintf(outF,"%lf ",s->partVel[lpParticles * nDim + lpCoord]);
 		}
 		for(lpCoord = 0; lpCoord < nDim; lpCoord++){
-			fprintf(outF,"%lf ",gsl_vector_get(p[lpParticles].partPbest,lpCoord));
+			fprintf(outF,"%lf ",s->partPbest[lpParticles * nDim + lpCoord]);
 		}
-		fprintf(outF,"%lf ",p[lpParticles].partSnrPbest);
-		fprintf(outF,"%lf ",p[lpParticles].partSnrCurr);
-		fprintf(outF,"%lf ",p[lpParticles].partSnrLbest);
-		fprintf(outF,"%lf ",p[lpParticles].partInertia);
+		fprintf(outF,"%lf ",s->partSnrPbest[lpParticles]);
+		fprintf(outF,"%lf ",s->partSnrCurr[lpParticles]);
+		fprintf(outF,"%lf ",s->partSnrLbest[lpParticles]);
+		fprintf(outF,"%lf ",s->partInertia[lpParticles]);
 		for(lpCoord = 0; lpCoord < nDim; lpCoord++){
-			fprintf(outF,"%lf ",gsl_vector_get(p[lpParticles].partLocalBest,lpCoord));
+			fprintf(outF,"%lf ",s->partLocalBest[lpParticles * nDim + lpCoord]);
 		}
 		fprintf(outF,"X ");
-		fprintf(outF,"%zu ",p[lpParticles].partFitEvals);
+		fprintf(outF,"%zu ",s->partFitEvals[lpParticles]);
 		fprintf(outF,"\n");
 	}
 }
-
@@ -4,12 +4,19 @@
 #include <gsl/gsl_vector.h>
 #include <gsl/gsl_rng.h>
 
+#include "arena.h"
+
 #if defined (__cplusplus)
 extern "C" {
 #endif
 
 typedef double (*fitness_function_ptr)(gsl_vector *, void *);
 
+/*! Evaluates the fitness of several points in one call: the number of points, their coordinates, the fitness
+function parameter structure, the fitness values (output) and, for each point, 1 if the fitness was actually
+evaluated or 0 if it was not (output). */
+typedef void (*batch_fitness_function_ptr)(size_t, gsl_vector **, void *, double *, unsigned char *);
+
 /*!\file
 \brief Header file for \ref ptapso.c
 */
@@ -17,7 +24,8 @@ typedef double (*fitness_function_ptr)(gsl_vector *, void *);
 /*! \brief PSO parameter structure 
 
 Notes: 
-   - The stopping criterion for PSO here is the number of iterations.
+   - PSO stops after maxSteps iterations, or earlier when one of the optional criteria (stallSteps,
+     minSwarmDiameter, maxFuncEvals) is met. See \ref psoStop_update.
    - Particle inertia weight decays linearly over iterations as: max(A1 - (A2/A3)*k,A4)
 where k is the iteration number.
 */
@@ -44,6 +52,27 @@ struct psoParamStruct {
 	*/
 	double locMinStpSz;
 	gsl_rng *rngGen; /*!< Pointer to GSL random number generator */
+	/*! 0 draws the random numbers of the swarm from rngGen, one after the other. 1 draws them from the
+	   counter-based generator of \ref philox.h keyed by rngSeed, a function of (iteration, particle,
+	   coordinate): the run is then the same for any number of threads, and the dynamical update runs
+	   in parallel.
+	*/
+	int counterRng;
+	unsigned long rngSeed; /*!< Key of the counter-based generator */
+	/*! Stop when gbest has not improved by more than stallTol for this many iterations. 0 switches this
+	   criterion off. */
+	size_t stallSteps;
+	double stallTol; /*!< Smallest improvement of gbest that counts for stallSteps */
+	/*! Stop when the swarm fits in a box of this size along every coordinate (in standardized coordinates).
+	   0 switches this criterion off. */
+	double minSwarmDiameter;
+	/*! Stop once this many fitness evaluations have been made. 0 switches this criterion off. */
+	size_t maxFuncEvals;
+	/*! Optional batch form of the fitness function. When set, the fitness values of
+	   all the particles are obtained from one call per iteration instead of one
+	   call per particle. Set to NULL if not used.
+	*/
+	batch_fitness_function_ptr batchFitfunc;
 	/*! Pointer to ascii file where to dump info. Set to NULL if not dumping. */
 	FILE *debugDumpFile;
 };
@@ -54,19 +83,44 @@ struct returnData {
     size_t totalFuncEvals; /*!< total number of fitness evaluations */
     gsl_vector *bestLocation; /*!< Final global best location */
     double bestFitVal; /*!< Best fitness values found */
+    int stopReason; /*!< Why PSO stopped, one of enum psoStopReason */
+    size_t lastImprovementIter; /*!< Iteration at which gbest last improved by more than stallTol */
 };
 
-/*! Struct to contain particle information (instead of the plain matrix used in the Matlab code). */
-struct particleInfo{
-	gsl_vector *partCoord; /*!< Current coordinates */
-	gsl_vector *partVel;  /*!<  Current velocity */
-	gsl_vector *partPbest; /*!<  Coordinates of pbest */
-	gsl_vector *partLocalBest; /*!<  Coordinates of neighborhood best */
-	double partSnrPbest; /*!<  pbest fitness value */
-	double partSnrCurr;  /*!<  Current fitness value */
-	double partSnrLbest; /*!<  Best fitness in neighborhood */
-	double partInertia;  /*!<  Current inertia weight */
-	size_t partFitEvals; /*!<  Number of fitness function evaluations */
+/*! Why PSO stopped */
+enum psoStopReason {
+	PSO_STOP_MAX_STEPS = 0, /*!< maxSteps iterations done */
+	PSO_STOP_STALL,         /*!< gbest stalled for stallSteps iterations */
+	PSO_STOP_DIAMETER,      /*!< The swarm shrank below minSwarmDiameter */
+	PSO_STOP_FUNC_EVALS     /*!< maxFuncEvals fitness evaluations made */
+};
+
+/*! State of the stopping criteria over a run, see \ref psoStop_update. */
+struct psoStopState {
+	double refFitVal; /*!< gbest fitness when it last improved by more than stallTol */
+	size_t lastImprovementIter; /*!< Iteration at which that happened */
+	int reason; /*!< One of enum psoStopReason */
+};
+
+/*! The swarm, stored as arrays over the particles (structure of arrays). The coordinates, velocities, pbest
+and neighborhood best of particle k are row k of popsize x nDim matrices, so that the dynamical update of the
+whole swarm is one loop over contiguous memory (see \ref swarm_update). */
+struct swarmInfo{
+	size_t popsize; /*!<  Number of particles */
+	size_t nDim; /*!<  Number of search dimensions */
+	double *partCoord; /*!< Current coordinates */
+	double *partVel;  /*!<  Current velocities */
+	double *partPbest; /*!<  Coordinates of pbest */
+	double *partLocalBest; /*!<  Coordinates of neighborhood best */
+	double *chi1; /*!<  Random weights of the pbest term of the next update */
+	double *chi2; /*!<  Random weights of the lbest term of the next update */
+	double *partSnrPbest; /*!<  pbest fitness values */
+	double *partSnrCurr;  /*!<  Current fitness values */
+	double *partSnrLbest; /*!<  Best fitness in neighborhood */
+	double *partInertia;  /*!<  Current inertia weights */
+	size_t *partFitEvals; /*!<  Number of fitness function evaluations */
+	gsl_vector_view *coordView; /*!<  Row k of partCoord as a gsl_vector, to pass to the fitness function */
+	arena_t *arena; /*!<  Holds all of the above, each array on an ARENA_ALIGNMENT boundary */
 };
 
 /*! Struct to allow fitness functions without a const gsl_vector * input
@@ -94,19 +148,58 @@ void gbestpso(size_t nDim, /*!< Number of search dimensions */
             struct psoParamStruct *psoParams, /*!< PSO parameter structure */
 			struct returnData *psoResults /*!< Output structure */);
 
-void initPsoParticles(struct particleInfo *, size_t , gsl_rng *);
+/*! Asynchronous versions of \ref lbestpso and \ref gbestpso: each particle is moved and re-evaluated as soon as
+its own fitness is known, without waiting for the rest of the swarm. Same interface; the batch fitness
+function is not used. */
+void async_lbestpso(size_t nDim, fitness_function_ptr fitfunc, void *ffParams,
+			struct psoParamStruct *psoParams, struct returnData *psoResults);
+
+void async_gbestpso(size_t nDim, fitness_function_ptr fitfunc, void *ffParams,
+			struct psoParamStruct *psoParams, struct returnData *psoResults);
+
+struct swarmInfo * swarm_alloc(size_t popsize, size_t nDim);
+
+void swarm_free(struct swarmInfo *);
+
+/*! Random initial positions and velocities, from rngGen or the counter-based generator as set in the PSO
+parameters. */
+void swarm_init(struct swarmInfo *, const struct psoParamStruct *);
+
+/*! Draws chi1 and chi2 of count particles from particle first on: for each particle, nDim values of chi1
+then nDim values of chi2. */
+void swarm_draw_weights(struct swarmInfo *, size_t first, size_t count, gsl_rng *);
+
+/*! The same from the counter-based generator, for the given iteration. Any subset of the particles can be
+drawn, in any order, with the same result. */
+void swarm_draw_weights_counter(struct swarmInfo *, size_t first, size_t count, unsigned long seed, size_t iteration);
+
+/*! Velocity update with clamping to max_velocity, then position update, of count particles from particle
+first on, with their inertia weights, partLocalBest, chi1 and chi2. */
+void swarm_update(struct swarmInfo *, size_t first, size_t count, const struct psoParamStruct *);
+
+/*! Draws the random weights of the whole swarm for the given iteration and updates it. With the
+counter-based generator the particles are split between the threads. */
+void swarm_advance(struct swarmInfo *, const struct psoParamStruct *, size_t iteration);
+
+/*! Largest extent of the swarm along any coordinate. */
+double swarm_diameter(const struct swarmInfo *);
+
+void psoStop_init(struct psoStopState *);
 
-void particleinfo_alloc(struct particleInfo *, size_t);
+/*! Records gbest after the given iteration and returns 1 if PSO should stop there, with the reason in the
+state. The diameter and the evaluation count are taken from the swarm, unless it is NULL. */
+int psoStop_update(struct psoStopState *, const struct psoParamStruct *, const struct swarmInfo *,
+			size_t iteration, double gbestFitVal);
 
-void particleinfo_free(struct particleInfo *);
+const char* psoStop_reason_name(int reason);
 
 struct returnData * returnData_alloc(size_t );
 
 void returnData_free(struct returnData *);
 
-void particleinfo_fwrite(FILE *, struct particleInfo *);
+void swarm_fwrite(FILE *, const struct swarmInfo *, size_t);
 
-void particleInfoDump(FILE *, struct particleInfo *, size_t );
+void swarmDump(FILE *, const struct swarmInfo *);
 
 #if defined (__cplusplus)
 }
@@ -25,10 +25,13 @@
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 
+#include "arena.h"
+#include "complex_vector.h"
 #include "detector_antenna_patterns.h"
 #include "inspiral_chirp.h"
 #include "detector.h"
 #include "detector_network.h"
+#include "fft.h"
 #include "strain.h"
 #include "inspiral_stationary_phase.h"
 #include "inspiral_network_statistic.h"
@@ -42,8 +45,6 @@
 
 
 void load_shihan_inspiral_data( const char* hdf_filename, strain_half_fft_t *strain){
-	size_t i, j;
-
 	size_t num_time_samples = hdf5_get_num_time_samples( hdf_filename );
 	size_t half_size = SS_half_size( num_time_samples );
 
@@ -53,9 +54,7 @@ void load_shihan_inspiral_data( const char* hdf_filename, strain_half_fft_t *str
 	hdf5_load_array( hdf_filename, "/shihan/whitened_data_real", real_array);
 	hdf5_load_array( hdf_filename, "/shihan/whitened_data_imag", imag_array);
 
-	for (j = 0; j < half_size; j++) {
-		strain->half_fft[j] = gsl_complex_rect(real_array[j], imag_array[j]);
-	}
+	CV_interleave( half_size, real_array, imag_array, (double*) strain->half_fft );
 
 	free(real_array);
 	free(imag_array);
@@ -73,6 +72,28 @@ void pso_result_print(pso_result_t *result) {
 			result->total_iterations, result->total_func_evals, result->computation_time_secs);
 }
 
+/* Number of doubles a result is sent to rank 0 in */
+#define PSO_RESULT_BUFF_LEN 10
+
+/* Sends each result to rank 0 as soon as its trial finishes */
+void pso_result_send(size_t trial, gslseed_t seed, pso_result_t *result, void *callback_data) {
+	double buff[PSO_RESULT_BUFF_LEN];
+	int tag = 0;
+
+	buff[0] = result->ra;
+	buff[1] = result->dec;
+	buff[2] = result->chirp_t0;
+	buff[3] = result->chirp_t1_5;
+	buff[4] = result->snr;
+	buff[5] = result->total_iterations;
+	buff[6] = result->total_func_evals;
+	buff[7] = result->computation_time_secs;
+	buff[8] = result->stop_reason;
+	buff[9] = result->last_improvement_iteration;
+
+	MPI_Send(buff, PSO_RESULT_BUFF_LEN, MPI_DOUBLE, 0, tag, MPI_COMM_WORLD);
+}
+
 int i_am_master() {
 	int rank;
 	MPI_Comm_rank(MPI_COMM_WORLD, &rank);
@@ -86,7 +107,9 @@ int main(int argc, char* argv[]) {
 	double cpu_time_used;
 	time_start = clock();
 
-	MPI_Init(&argc, &argv);
+	/* The results are sent by whichever team finished the trial, one at a time */
+	int thread_level;
+	MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &thread_level);
 
 	/* somehow these need to be set */
 	if (argc != 6) {
@@ -121,6 +144,28 @@ int main(int argc, char* argv[]) {
 	const double f_high = atof(settings_file_get_value(settings_file, "f_high"));
 	const double sampling_frequency = atof(settings_file_get_value(settings_file, "sampling_frequency"));
 
+	/* Optional: back the strain and workspace arenas with huge pages (none, transparent or explicit). */
+	const char *huge_pages = settings_file_get_value(settings_file, "huge_pages");
+	if (huge_pages != NULL) {
+		AR_set_default_pages( AR_pages_name_to_id(huge_pages) );
+	}
+
+	/* Optional: number of trials each rank runs at the same time, each by its own team of threads. Defaults
+	 * to 1. More than one needs an MPI library that allows calls from any thread, one at a time.
+	 */
+	size_t num_concurrent_trials = 1;
+	const char *concurrent_trials = settings_file_get_value(settings_file, "pso_concurrent_trials");
+	if (concurrent_trials != NULL && atoi(concurrent_trials) > 1) {
+		num_concurrent_trials = atoi(concurrent_trials);
+		if (thread_level < MPI_THREAD_SERIALIZED) {
+			if (rank == 0) {
+				fprintf(stderr, "Warning. The MPI library does not allow calls from other threads, "
+						"so pso_concurrent_trials is ignored.\n");
+			}
+			num_concurrent_trials = 1;
+		}
+	}
+
 	settings_file_close(settings_file);
 
 	detector_network_mapping_t *dmap = Detector_Network_Mapping_load( arg_detector_mapping_file );
@@ -138,16 +183,13 @@ int main(int argc, char* argv[]) {
 	/* Random number generator */
 	gsl_rng *rng = random_alloc(seed);
 
-	pso_fitness_function_parameters_t *fitness_function_params =
-			pso_fitness_function_parameters_alloc(f_low, f_high, net, network_strain);
-
 	gslseed_t *seeds = (gslseed_t*) malloc ( arg_num_pso_evaluations * sizeof(gslseed_t) );
 	for (i = 0; i < arg_num_pso_evaluations; i++) {
 		seeds[i] = random_seed(rng);
 	}
 
 
-	double buff[8];
+	double buff[PSO_RESULT_BUFF_LEN];
 	int num_workers;
 	int num_jobs = arg_num_pso_evaluations;
 	MPI_Status status;
@@ -160,7 +202,7 @@ int main(int argc, char* argv[]) {
 
 		/* Rank 0 will accept the results and write them to file. */
 		while (num_jobs_done != num_jobs) {
-			MPI_Recv(buff, 8, MPI_DOUBLE, MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &status);
+			MPI_Recv(buff, PSO_RESULT_BUFF_LEN, MPI_DOUBLE, MPI_ANY_SOURCE, tag, MPI_COMM_WORLD, &status);
 			num_jobs_done++;
 
 			pso_result_t pso_result;
@@ -172,6 +214,8 @@ int main(int argc, char* argv[]) {
 			pso_result.total_iterations = buff[5];
 			pso_result.total_func_evals = buff[6];
 			pso_result.computation_time_secs = buff[7];
+			pso_result.stop_reason = buff[8];
+			pso_result.last_improvement_iteration = buff[9];
 
 			pso_result_print(&pso_result);
 
@@ -184,43 +228,37 @@ int main(int argc, char* argv[]) {
 			fclose(fid);
 		}
 	} else {
-		/* All other ranks are workers. */
-		int num_jobs_completed = 0;
-
-		while(1) {
-			/* get seed number to process */
-			int r = (rank-1) + (num_jobs_completed * num_workers);
-			if (r >= num_jobs) {
-				break;
-			}
-
-			pso_result_t pso_result;
-			pso_estimate_parameters(arg_pso_settings_file, fitness_function_params, seeds[r], &pso_result);
-			buff[0] = pso_result.ra;
-			buff[1] = pso_result.dec;
-			buff[2] = pso_result.chirp_t0;
-			buff[3] = pso_result.chirp_t1_5;
-			buff[4] = pso_result.snr;
-			buff[5] = pso_result.total_iterations;
-			buff[6] = pso_result.total_func_evals;
-			buff[7] = pso_result.computation_time_secs;
-
-			MPI_Send(buff, 8, MPI_DOUBLE, 0, tag, MPI_COMM_WORLD);
-			num_jobs_completed++;
+		/* All other ranks are workers. Worker rank takes seeds rank-1, rank-1 + num_workers, ... and runs them
+		   num_concurrent_trials at a time over the one copy of the data. */
+		size_t num_worker_jobs = 0;
+		gslseed_t *worker_seeds = (gslseed_t*) malloc ( num_jobs * sizeof(gslseed_t) );
+		int r;
+		for (r = rank-1; r < num_jobs; r += num_workers) {
+			worker_seeds[num_worker_jobs] = seeds[r];
+			num_worker_jobs++;
 		}
+
+		pso_estimate_parameters_trials(arg_pso_settings_file, f_low, f_high, net, network_strain,
+				num_worker_jobs, worker_seeds, num_concurrent_trials, NULL, pso_result_send, NULL);
+
+		free(worker_seeds);
 	}
 	MPI_Barrier(MPI_COMM_WORLD);
 
 	free(seeds);
 
-	pso_fitness_function_parameters_free(fitness_function_params);
-
 	/* Free the data */
 	network_strain_half_fft_free(network_strain);
 
 	Detector_Network_free(net);
 	random_free(rng);
 
+	/* Frees the FFT plans. Only the root process saves the FFTW wisdom. */
+	if (rank != 0) {
+		FFT_set_wisdom_filename("");
+	}
+	FFT_cleanup();
+
 	MPI_Finalize();
 
 	if (rank == 0) {
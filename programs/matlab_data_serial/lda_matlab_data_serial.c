@@ -29,10 +29,13 @@
 #include <gsl/gsl_rng.h>
 #include <gsl/gsl_randist.h>
 
+#include "arena.h"
+#include "complex_vector.h"
 #include "detector_antenna_patterns.h"
 #include "inspiral_chirp.h"
 #include "detector.h"
 #include "detector_network.h"
+#include "fft.h"
 #include "strain.h"
 #include "inspiral_stationary_phase.h"
 #include "inspiral_network_statistic.h"
@@ -46,8 +49,6 @@
 
 
 void load_shihan_inspiral_data( const char* hdf_filename, strain_half_fft_t *strain){
-	size_t i, j;
-
 	size_t num_time_samples = hdf5_get_num_time_samples( hdf_filename );
 	size_t half_size = SS_half_size( num_time_samples );
 
@@ -57,9 +58,7 @@ void load_shihan_inspiral_data( const char* hdf_filename, strain_half_fft_t *str
 	hdf5_load_array( hdf_filename, "/shihan/whitened_data_real", real_array);
 	hdf5_load_array( hdf_filename, "/shihan/whitened_data_imag", imag_array);
 
-	for (j = 0; j < half_size; j++) {
-		strain->half_fft[j] = gsl_complex_rect(real_array[j], imag_array[j]);
-	}
+	CV_interleave( half_size, real_array, imag_array, (double*) strain->half_fft );
 
 	free(real_array);
 	free(imag_array);
@@ -77,13 +76,26 @@ void pso_result_print(pso_result_t *result) {
 			result->total_iterations, result->total_func_evals, result->computation_time_secs);
 }
 
+/* Appends each result to the results file as soon as its trial finishes */
+void pso_result_stream(size_t trial, gslseed_t seed, pso_result_t *result, void *callback_data) {
+	const char *pso_results_file = (const char*) callback_data;
+
+	FILE *fid = fopen(pso_results_file, "a");
+	pso_result_save(fid, result);
+	fprintf(fid, "\n");
+	fclose(fid);
+
+	pso_result_print(result);
+	printf("\n");
+}
+
 int main(int argc, char* argv[]) {
 	size_t i;
 
 	/* somehow these need to be set */
-	if (argc != 6) {
+	if (argc != 6 && argc != 7) {
 		printf("argc = %d\n", argc);
-		printf("Error: Usage -> [settings file] [detector mapping file] [rng seed] [input pso settings file] [pso results file]!\n");
+		printf("Error: Usage -> [settings file] [detector mapping file] [rng seed] [input pso settings file] [pso results file] [optional: num pso trials]!\n");
 		exit(-1);
 	}
 
@@ -92,6 +104,8 @@ int main(int argc, char* argv[]) {
 	const gslseed_t seed = atoi(argv[3]);
 	char* arg_pso_settings_file = argv[4];
 	char* arg_pso_results_file = argv[5];
+	/* Trial i uses seed + i */
+	size_t num_trials = (argc == 7) ? atoi(argv[6]) : 1;
 
 	/* Load the general Settings */
 	settings_file_t *settings_file = settings_file_open(arg_settings_file);
@@ -107,6 +121,19 @@ int main(int argc, char* argv[]) {
 	const double f_high = atof(settings_file_get_value(settings_file, "f_high"));
 	const double sampling_frequency = atof(settings_file_get_value(settings_file, "sampling_frequency"));
 
+	/* Optional: back the strain and workspace arenas with huge pages (none, transparent or explicit). */
+	const char *huge_pages = settings_file_get_value(settings_file, "huge_pages");
+	if (huge_pages != NULL) {
+		AR_set_default_pages( AR_pages_name_to_id(huge_pages) );
+	}
+
+	/* Optional: number of trials run at the same time, each by its own team of threads. Defaults to 1. */
+	size_t num_concurrent_trials = 1;
+	const char *concurrent_trials = settings_file_get_value(settings_file, "pso_concurrent_trials");
+	if (concurrent_trials != NULL && atoi(concurrent_trials) > 1) {
+		num_concurrent_trials = atoi(concurrent_trials);
+	}
+
 	settings_file_close(settings_file);
 
 	detector_network_mapping_t *dmap = Detector_Network_Mapping_load( arg_detector_mapping_file );
@@ -119,26 +146,23 @@ int main(int argc, char* argv[]) {
 		load_shihan_inspiral_data( dmap->data_filenames[i], network_strain->strains[i] );
 	}
 
-	pso_fitness_function_parameters_t *fitness_function_params =
-				pso_fitness_function_parameters_alloc(f_low, f_high, net, network_strain);
-
-	pso_result_t pso_result;
-	pso_estimate_parameters(arg_pso_settings_file, fitness_function_params, seed, &pso_result);
-
-	FILE *fid = fopen(arg_pso_results_file, "a");
-	pso_result_save(fid, &pso_result);
-	fprintf(fid, "\n");
-	fclose(fid);
-
-	pso_result_print(&pso_result);
+	gslseed_t *seeds = (gslseed_t*) malloc( num_trials * sizeof(gslseed_t) );
+	for (i = 0; i < num_trials; i++) {
+		seeds[i] = seed + i;
+	}
 
+	pso_estimate_parameters_trials(arg_pso_settings_file, f_low, f_high, net, network_strain,
+			num_trials, seeds, num_concurrent_trials, NULL, pso_result_stream, arg_pso_results_file);
 
-	pso_fitness_function_parameters_free(fitness_function_params);
+	free(seeds);
 
 	/* Free the data */
 	network_strain_half_fft_free(network_strain);
 
 	Detector_Network_free(net);
 
+	/* Frees the FFT plans and saves the FFTW wisdom, if any */
+	FFT_cleanup();
+
 	return 0;
 }
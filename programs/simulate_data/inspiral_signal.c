@@ -17,6 +17,7 @@
 
 #include <gsl/gsl_randist.h>
 
+#include "complex_vector.h"
 #include "detector_antenna_patterns.h"
 #include "inspiral_chirp.h"
 #include "inspiral_chirp_time.h"
@@ -65,22 +66,28 @@ strain_half_fft_t* inspiral_template_half_fft(double f_low, double f_high, size_
 			sp_lookup,
 			sp);
 
-	/* This computes the unscaled (in terms of network snr) inspiral template */
-	for (j = 0; j < det->asd->len; ++j) {
-		gsl_complex v;
-		gsl_complex A;
-		gsl_complex B;
+	/* This computes the unscaled (in terms of network snr) inspiral template.
+	 * h_0 = spa_0 / asd and h_90 = -i h_0, so f_plus h_0 + f_cross h_90 = (f_plus - i f_cross) spa_0 / asd.
+	 */
+	size_t len = det->asd->len;
+	double *h_re = (double*) malloc( 3 * len * sizeof(double) );
+	if (h_re == NULL) {
+		fprintf(stderr, "Error. Unable to allocate memory for the inspiral template. Exiting.\n");
+		exit(-1);
+	}
+	double *h_im = h_re + len;
+	double *inverse_asd = h_im + len;
 
-		gsl_complex whitened_sf = gsl_complex_div_real(sp->spa_0[j], det->asd->asd[j]);
-		gsl_complex h_0 = whitened_sf;
+	for (j = 0; j < len; ++j) {
+		inverse_asd[j] = 1.0 / det->asd->asd[j];
+	}
 
-		v = gsl_complex_rect(0.0, -1.0);
-		gsl_complex h_90 = gsl_complex_mul(h_0, v);
+	CV_deinterleave( len, (const double*) sp->spa_0, h_re, h_im );
+	CV_scale_real( len, inverse_asd, h_re, h_im );
+	CV_scale( len, ap.f_plus, -ap.f_cross, h_re, h_im );
+	CV_interleave( len, h_re, h_im, (double*) signal->half_fft );
 
-		A = gsl_complex_mul_real( h_0, ap.f_plus );
-		B = gsl_complex_mul_real( h_90, ap.f_cross );
-		signal->half_fft[j] = gsl_complex_add( A, B );
-	}
+	free(h_re);
 	Detector_Antenna_Patterns_workspace_free(ap_ws);
 
 	SP_workspace_free(sp_lookup);
@@ -95,7 +102,9 @@ network_strain_half_fft_t* inspiral_template_unscaled(double f_low, double f_hig
 	/* One measured signal per detector */
 	network_strain_half_fft_t *network_strain = network_strain_half_fft_alloc( net->num_detectors, num_time_samples );
 	for (i = 0; i < net->num_detectors; i++) {
-		network_strain->strains[i] = inspiral_template_half_fft( f_low, f_high, num_time_samples, net->detector[i], source);
+		strain_half_fft_t *signal = inspiral_template_half_fft( f_low, f_high, num_time_samples, net->detector[i], source);
+		memcpy(network_strain->strains[i]->half_fft, signal->half_fft, signal->half_fft_len * sizeof(gsl_complex));
+		strain_half_fft_free(signal);
 	}
 
 	return network_strain;
@@ -131,6 +140,7 @@ network_strain_half_fft_t* inspiral_template(double f_low, double f_high, size_t
 			signal->half_fft[j] = gsl_complex_mul_real(signal->half_fft[j], scale_factor);
 		}
 	}
+	network_strain_half_fft_changed(network_strain);
 
 	return network_strain;
 }
@@ -5,6 +5,7 @@
 #include <assert.h>
 
 #include "detector_network.h"
+#include "fft.h"
 #include "simulation_file.h"
 #include "simulation_settings.h"
 
@@ -25,5 +26,7 @@ int main(int argc, char* argv[])
 
 	Detector_Network_free( net );
 
+	FFT_cleanup();
+
 	return 0;
 }
@@ -171,6 +171,7 @@ void simulate( simulation_settings_t *ps, detector_network_t *net) {
 
 		strain_full_fft_free(two_sided);
 	}
+	network_strain_half_fft_changed(network_strain_half_fft);
 
 	/* random number generator */
 	gsl_rng *rng = random_alloc( ps->alpha_seed );
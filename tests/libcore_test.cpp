@@ -13,6 +13,7 @@
 	#include <gtest/gtest.h>
 #endif
 
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -20,21 +21,30 @@
 #include <gsl/gsl_complex.h>
 #include <gsl/gsl_complex_math.h>
 #include <gsl/gsl_const_mksa.h>
+#include <gsl/gsl_fft_halfcomplex.h>
+#include <gsl/gsl_fft_real.h>
 
 #include "../libcore/sky.h"
+#include "../libcore/arena.h"
+#include "../libcore/complex_vector.h"
+#include "../libcore/cpu_dispatch.h"
 #include "../libcore/detector_antenna_patterns.h"
 #include "../libcore/detector_mapping.h"
 #include "../libcore/detector_network.h"
 #include "../libcore/detector_time_delay.h"
 #include "../libcore/detector.h"
+#include "../libcore/fft.h"
 #include "../libcore/hdf5_file.h"
 #include "../libcore/inspiral_chirp_factors.h"
 #include "../libcore/inspiral_chirp.h"
 #include "../libcore/inspiral_network_statistic.h"
+#include "../libcore/inspiral_network_statistic_fixed.h"
 #include "../libcore/inspiral_stationary_phase.h"
+#include "../libcore/inspiral_template_cache.h"
 #include "../libcore/random.h"
 #include "../libcore/sampling_system.h"
 #include "../libcore/settings_file.h"
+#include "../libcore/sky_geometry.h"
 #include "../libcore/spectral_density.h"
 #include "../libcore/strain.h"
 
@@ -64,6 +74,390 @@ TEST(SS_make_two_sided, matchesMatlab) {
 	}
 }
 
+TEST(FFT, backendsMatchDirectDFT) {
+#ifdef HAVE_FFTW3
+	const int num_backends = 3;
+	FFT_BACKEND backends[3] = {FFT_BACKEND_GSL, FFT_BACKEND_RADIX4, FFT_BACKEND_FFTW3};
+#else
+	const int num_backends = 2;
+	FFT_BACKEND backends[2] = {FFT_BACKEND_GSL, FFT_BACKEND_RADIX4};
+#endif
+	/* 12 is not a power of two, so the radix-4 backend falls back to GSL */
+	size_t lengths[7] = {1, 2, 4, 8, 32, 64, 12};
+
+	for (int b = 0; b < num_backends; b++) {
+		FFT_set_backend(backends[b]);
+
+		for (int l = 0; l < 7; l++) {
+			size_t n = lengths[l];
+			double *x = (double*) malloc( 2 * n * sizeof(double) );
+			double *y = (double*) malloc( 2 * n * sizeof(double) );
+			float *yf = (float*) malloc( 2 * n * sizeof(float) );
+			for (int j = 0; j < 2*n; j++) {
+				x[j] = sin(0.3*j + 0.1) + 0.25*j;
+				y[j] = x[j];
+				yf[j] = (float) x[j];
+			}
+
+			fft_workspace_t *ws = FFT_workspace_alloc(n);
+			FFT_execute( FFT_plan_get(n, FFT_FORWARD, FFT_DOUBLE), y, ws );
+			FFT_execute_float( FFT_plan_get(n, FFT_FORWARD, FFT_SINGLE), yf, ws );
+
+			for (int k = 0; k < n; k++) {
+				double re = 0.0;
+				double im = 0.0;
+				for (int j = 0; j < n; j++) {
+					double a = -2.0 * M_PI * ((j*k) % n) / n;
+					re += x[2*j]*cos(a) - x[2*j+1]*sin(a);
+					im += x[2*j]*sin(a) + x[2*j+1]*cos(a);
+				}
+				EXPECT_NEAR( y[2*k], re, 1e-10 );
+				EXPECT_NEAR( y[2*k+1], im, 1e-10 );
+				EXPECT_NEAR( yf[2*k], re, 1e-3 );
+				EXPECT_NEAR( yf[2*k+1], im, 1e-3 );
+			}
+
+			/* The backward transform is unnormalized */
+			FFT_execute( FFT_plan_get(n, FFT_BACKWARD, FFT_DOUBLE), y, ws );
+			for (int j = 0; j < 2*n; j++) {
+				EXPECT_NEAR( y[j], n * x[j], 1e-10 * n );
+			}
+
+			FFT_workspace_free(ws);
+			free(yf);
+			free(y);
+			free(x);
+		}
+	}
+
+	FFT_set_backend(FFT_BACKEND_AUTO);
+}
+
+TEST(FFT, manyMatchesSingle) {
+#ifdef HAVE_FFTW3
+	const int num_backends = 3;
+	FFT_BACKEND backends[3] = {FFT_BACKEND_GSL, FFT_BACKEND_RADIX4, FFT_BACKEND_FFTW3};
+#else
+	const int num_backends = 2;
+	FFT_BACKEND backends[2] = {FFT_BACKEND_GSL, FFT_BACKEND_RADIX4};
+#endif
+	size_t lengths[2] = {16, 12};
+	const size_t howmany = 3;
+
+	for (int b = 0; b < num_backends; b++) {
+		FFT_set_backend(backends[b]);
+
+		for (int l = 0; l < 2; l++) {
+			size_t n = lengths[l];
+			void *block = NULL;
+			ASSERT_EQ( 0, posix_memalign(&block, 64, (2 * howmany * n + 1) * sizeof(double)) );
+			double *y = (double*) malloc( 2 * howmany * n * sizeof(double) );
+			fft_workspace_t *ws = FFT_workspace_alloc(n);
+
+			/* Aligned, and one double off so that FFTW goes one transform at a time */
+			for (int offset = 0; offset < 2; offset++) {
+				double *x = (double*) block + offset;
+				for (int j = 0; j < 2 * howmany * n; j++) {
+					x[j] = sin(0.3*j + 0.1) + 0.25*j;
+					y[j] = x[j];
+				}
+
+				FFT_execute_many( FFT_plan_many_get(n, howmany, FFT_BACKWARD), x, ws );
+				for (int i = 0; i < howmany; i++) {
+					FFT_execute( FFT_plan_get(n, FFT_BACKWARD, FFT_DOUBLE), y + 2 * i * n, ws );
+				}
+				for (int j = 0; j < 2 * howmany * n; j++) {
+					EXPECT_NEAR( x[j], y[j], 1e-12 * n );
+				}
+			}
+
+			FFT_workspace_free(ws);
+			free(y);
+			free(block);
+		}
+	}
+
+	FFT_set_backend(FFT_BACKEND_AUTO);
+}
+
+TEST(FFT, gslWorkspaceKeptPerLength) {
+	/* One workspace used for alternating lengths, as the full, window and baseband transforms do */
+	size_t lengths[3] = {60, 12, 20};
+	fft_workspace_t *ws = FFT_workspace_alloc(60);
+	size_t bytes = 0;
+
+	FFT_set_backend(FFT_BACKEND_GSL);
+	for (int pass = 0; pass < 3; pass++) {
+		for (int l = 0; l < 3; l++) {
+			size_t n = lengths[l];
+			double y[120];
+			for (int j = 0; j < 2*n; j++) {
+				y[j] = (j == 2) ? 1.0 : 0.0;
+			}
+			/* The transform of a unit impulse at 1 is exp(-2 pi i k / n) */
+			FFT_execute( FFT_plan_get(n, FFT_FORWARD, FFT_DOUBLE), y, ws );
+			for (int k = 0; k < n; k++) {
+				EXPECT_NEAR( y[2*k], cos(2.0 * M_PI * k / n), 1e-12 );
+				EXPECT_NEAR( y[2*k+1], -sin(2.0 * M_PI * k / n), 1e-12 );
+			}
+		}
+		/* Nothing is reallocated after the first pass */
+		if (pass == 0) {
+			bytes = FFT_workspace_bytes(ws);
+		}
+		EXPECT_EQ(bytes, FFT_workspace_bytes(ws));
+	}
+	FFT_set_backend(FFT_BACKEND_AUTO);
+
+	FFT_workspace_free(ws);
+}
+
+TEST(FFT, prunedMatchesFullTransform) {
+	/* (n, offset, count): power of two, a window that wraps the sub transform, odd n, and count = n */
+	size_t cases[5][3] = { {64, 5, 7}, {64, 29, 16}, {60, 50, 10}, {45, 3, 4}, {16, 0, 16} };
+
+	for (int c = 0; c < 5; c++) {
+		size_t n = cases[c][0];
+		size_t offset = cases[c][1];
+		size_t count = cases[c][2];
+
+		double *x = (double*) malloc( 2 * n * sizeof(double) );
+		double *y = (double*) malloc( 2 * n * sizeof(double) );
+		double *scratch = (double*) malloc( 2 * n * sizeof(double) );
+		double *out = (double*) malloc( 2 * count * sizeof(double) );
+		for (int j = 0; j < 2*n; j++) {
+			x[j] = sin(0.7*j + 0.2) - 0.1*j;
+			y[j] = x[j];
+		}
+
+		fft_workspace_t *ws = FFT_workspace_alloc(n);
+		FFT_execute( FFT_plan_get(n, FFT_BACKWARD, FFT_DOUBLE), y, ws );
+
+		fft_pruned_plan_t *plan = FFT_pruned_plan_alloc(n, FFT_BACKWARD, offset, count);
+		FFT_execute_pruned(plan, x, out, scratch, ws);
+
+		for (int m = 0; m < count; m++) {
+			size_t t = (offset + m) % n;
+			EXPECT_NEAR( out[2*m], y[2*t], 1e-10 * n );
+			EXPECT_NEAR( out[2*m+1], y[2*t+1], 1e-10 * n );
+		}
+
+		FFT_pruned_plan_free(plan);
+		FFT_workspace_free(ws);
+		free(out);
+		free(scratch);
+		free(y);
+		free(x);
+	}
+}
+
+TEST(complex_vector, kernelsMatchComplexArithmetic) {
+	/* Odd length so both the vector loop and the remainder are used */
+	const size_t n = 11;
+	double a_re[n], a_im[n], b_re[n], b_im[n];
+	double out_re[n], out_im[n], acc_re[n], acc_im[n], abs2[n];
+	double z[2*n], zz[2*n];
+
+	for (int k = 0; k < n; k++) {
+		a_re[k] = 0.5 + k;
+		a_im[k] = 1.0 - 0.25*k;
+		b_re[k] = cos(0.3*k);
+		b_im[k] = sin(0.7*k) - 0.5;
+		acc_re[k] = 0.1*k;
+		acc_im[k] = -0.2*k;
+	}
+
+	CV_conj_mul(n, a_re, a_im, b_re, b_im, out_re, out_im);
+	for (int k = 0; k < n; k++) {
+		gsl_complex c = gsl_complex_mul( gsl_complex_conjugate(gsl_complex_rect(a_re[k], a_im[k])), gsl_complex_rect(b_re[k], b_im[k]) );
+		EXPECT_NEAR( out_re[k], GSL_REAL(c), 1e-14 );
+		EXPECT_NEAR( out_im[k], GSL_IMAG(c), 1e-14 );
+	}
+
+	CV_mul(n, a_re, a_im, b_re, b_im, out_re, out_im);
+	for (int k = 0; k < n; k++) {
+		gsl_complex c = gsl_complex_mul( gsl_complex_rect(a_re[k], a_im[k]), gsl_complex_rect(b_re[k], b_im[k]) );
+		EXPECT_NEAR( out_re[k], GSL_REAL(c), 1e-14 );
+		EXPECT_NEAR( out_im[k], GSL_IMAG(c), 1e-14 );
+	}
+
+	CV_fma(n, a_re, a_im, b_re, b_im, acc_re, acc_im);
+	for (int k = 0; k < n; k++) {
+		gsl_complex c = gsl_complex_mul( gsl_complex_rect(a_re[k], a_im[k]), gsl_complex_rect(b_re[k], b_im[k]) );
+		EXPECT_NEAR( acc_re[k], 0.1*k + GSL_REAL(c), 1e-14 );
+		EXPECT_NEAR( acc_im[k], -0.2*k + GSL_IMAG(c), 1e-14 );
+	}
+
+	CV_abs2(n, a_re, a_im, abs2);
+	CV_abs2_add(n, b_re, b_im, abs2);
+	for (int k = 0; k < n; k++) {
+		EXPECT_NEAR( abs2[k], gsl_complex_abs2(gsl_complex_rect(a_re[k], a_im[k]))
+				+ gsl_complex_abs2(gsl_complex_rect(b_re[k], b_im[k])), 1e-13 );
+	}
+
+	CV_interleave(n, a_re, a_im, z);
+	CV_conj_mul_interleaved(n, z, z, zz);
+	for (int k = 0; k < n; k++) {
+		EXPECT_NEAR( zz[2*k], a_re[k]*a_re[k] + a_im[k]*a_im[k], 1e-13 );
+		EXPECT_NEAR( zz[2*k+1], 0.0, 1e-13 );
+	}
+
+	CV_interleave(n, a_re, a_im, z);
+	CV_deinterleave(n, z, out_re, out_im);
+	CV_axpy(n, 2.0, a_re, a_im, out_re, out_im);
+	CV_scale(n, 0.0, 1.0, out_re, out_im);
+	for (int k = 0; k < n; k++) {
+		/* i * 3a */
+		EXPECT_NEAR( out_re[k], -3.0*a_im[k], 1e-14 );
+		EXPECT_NEAR( out_im[k], 3.0*a_re[k], 1e-14 );
+	}
+
+	CV_polar(n, NULL, b_re, out_re, out_im);
+	for (int k = 0; k < n; k++) {
+		EXPECT_NEAR( out_re[k], cos(b_re[k]), 1e-15 );
+		EXPECT_NEAR( out_im[k], sin(b_re[k]), 1e-15 );
+	}
+
+	/* Template phases reach thousands of radians. The last ones take the libm path, the very last one beyond int. */
+	double x[n] = {0.0, -1e-9, M_PI / 4.0, -M_PI / 2.0, 3.0, -100.5, 2.0e3 + 0.1, 12345.678, -9.87e5,
+			CV_SINCOS_MAX * 1.5, -1.0e10};
+	CV_sincos(n, x, out_re, out_im);
+	for (int k = 0; k < n; k++) {
+		EXPECT_NEAR( out_re[k], cos(x[k]), 1e-15 );
+		EXPECT_NEAR( out_im[k], sin(x[k]), 1e-15 );
+	}
+}
+
+TEST(SS_colour_timeseries, whitenUndoesColour) {
+	size_t num_time_samples = 16;
+	size_t len = SS_half_size(num_time_samples);
+
+	psd_t *psd = PSD_alloc(len);
+	psd->type = PSD_ONE_SIDED;
+	for (int k = 0; k < len; k++) {
+		psd->f[k] = k;
+		psd->psd[k] = 1.0 + k*k;
+	}
+
+	double x[16];
+	double y[16];
+	for (int j = 0; j < num_time_samples; j++) {
+		x[j] = cos(0.7*j) + 0.1*j;
+		y[j] = x[j];
+	}
+
+	SS_colour_timeseries(psd, num_time_samples, y);
+	SS_whiten_timeseries(psd, num_time_samples, y);
+
+	for (int j = 0; j < num_time_samples; j++) {
+		EXPECT_NEAR( y[j], x[j], 1e-12 );
+	}
+
+	PSD_free(psd);
+}
+
+/* The halfcomplex colouring of the original SS_colour_timeseries, or whitening if invert is set */
+static void SS_filter_reference(psd_t *psd, size_t n, int invert, double *x) {
+	asd_t *asd = ASD_alloc(psd->len);
+	ASD_init_from_psd(psd, asd);
+
+	gsl_fft_real_wavetable *real = gsl_fft_real_wavetable_alloc(n);
+	gsl_fft_halfcomplex_wavetable *hc = gsl_fft_halfcomplex_wavetable_alloc(n);
+	gsl_fft_real_workspace *work = gsl_fft_real_workspace_alloc(n);
+
+	gsl_fft_real_transform(x, 1, n, real, work);
+	for (size_t k = 0; k < n; k++) {
+		/* DC, (real, imag) pairs with the 1/sqrt(2) factor, and the Nyquist term */
+		size_t l = (k + 1) / 2;
+		double s = (k == 0 || k == n - 1) ? asd->asd[l] : asd->asd[l] / sqrt(2.0);
+		if (invert) {
+			x[k] /= s;
+		} else {
+			x[k] *= s;
+		}
+	}
+	gsl_fft_halfcomplex_inverse(x, 1, n, hc, work);
+
+	gsl_fft_real_workspace_free(work);
+	gsl_fft_halfcomplex_wavetable_free(hc);
+	gsl_fft_real_wavetable_free(real);
+	ASD_free(asd);
+}
+
+TEST(SS_colour_timeseries, matchesHalfcomplexReference) {
+	/* A power of two and a mixed-radix length */
+	size_t lengths[2] = {16, 12};
+
+	for (int i = 0; i < 2; i++) {
+		size_t num_time_samples = lengths[i];
+		size_t len = SS_half_size(num_time_samples);
+
+		psd_t *psd = PSD_alloc(len);
+		psd->type = PSD_ONE_SIDED;
+		for (int k = 0; k < len; k++) {
+			psd->f[k] = k;
+			psd->psd[k] = 1.0 + k*k;
+		}
+
+		for (int invert = 0; invert < 2; invert++) {
+			double y[16];
+			double ref[16];
+			for (int j = 0; j < num_time_samples; j++) {
+				y[j] = cos(0.7*j) + 0.1*j;
+				ref[j] = y[j];
+			}
+
+			if (invert) {
+				SS_whiten_timeseries(psd, num_time_samples, y);
+			} else {
+				SS_colour_timeseries(psd, num_time_samples, y);
+			}
+			SS_filter_reference(psd, num_time_samples, invert, ref);
+
+			for (int j = 0; j < num_time_samples; j++) {
+				EXPECT_DOUBLE_EQ( y[j], ref[j] );
+			}
+		}
+
+		PSD_free(psd);
+	}
+}
+
+/* The synthetic data of the coherent network tests: the first num_detectors of H1, L1, V1 and K1 with the one-sided
+ * PSD 1 + k at f = k, and num_realizations realizations of half FFTs sin(0.37 k (i + 1)) + i cos(1.3 k + i) for
+ * strain i. Returns a workspace for the band f_low to f_high.
+ */
+static coherent_network_workspace_t* CN_test_data_alloc(size_t num_detectors, size_t num_realizations,
+		size_t num_time_samples, double f_low, double f_high,
+		network_strain_half_fft_t **out_network_strain, detector_network_t **out_net) {
+	DETECTOR_ID ids[4] = {H1,L1,V1,K1};
+
+	network_strain_half_fft_t *network_strain = network_strain_half_fft_alloc_realizations(num_detectors,
+			num_time_samples, num_realizations);
+	for (int i = 0; i < num_realizations * num_detectors; i++) {
+		for (int k = 0; k < network_strain->strains[i]->half_fft_len; k++) {
+			network_strain->strains[i]->half_fft[k] = gsl_complex_rect(sin(0.37 * k * (i + 1)), cos(1.3 * k + i));
+		}
+	}
+
+	size_t len_f_array = network_strain->strains[0]->half_fft_len;
+
+	detector_network_t *net = Detector_Network_alloc( num_detectors );
+	for (int i = 0; i < num_detectors; i++) {
+		psd_t *psd = PSD_alloc(len_f_array);
+		for (int k = 0; k < len_f_array; k++) {
+			psd->f[k] = k;
+			psd->psd[k] = 1.0 + k;
+			psd->type = PSD_ONE_SIDED;
+		}
+		Detector_init(ids[i], psd, net->detector[i]);
+	}
+
+	*out_network_strain = network_strain;
+	*out_net = net;
+	return CN_workspace_alloc(num_time_samples, net, len_f_array, f_low, f_high);
+}
+
 TEST(find_index_low, left_end) {
 	size_t N = 100;
 	double f_array[N];
@@ -522,6 +916,247 @@ TEST(Detector_time_delay, matchesMatlab_T1) {
 
 
 
+TEST(sky_geometry, closedFormMatchesMatrixVersion) {
+	size_t num_detectors = 7;
+	DETECTOR_ID ids[7] = {L1, H1, H2, V1, K1, G1, T1};
+
+	detector_network_t *net = Detector_Network_alloc( num_detectors );
+	for (int i = 0; i < num_detectors; i++) {
+		psd_t *psd = PSD_alloc(10);
+		psd->type = PSD_ONE_SIDED;
+		Detector_init(ids[i], psd, net->detector[i]);
+	}
+
+	detector_antenna_patterns_workspace_t *ap_ws = Detector_Antenna_Patterns_workspace_alloc();
+	sky_geometry_t *geometry = SG_alloc(net);
+
+	double ras[4] = {1.0, -2.5, 3.1, 0.0};
+	double decs[4] = {1.0, -0.3, 1.5, -1.5};
+	for (int s = 0; s < 4; s++) {
+		sky_t sky;
+		sky.ra = ras[s];
+		sky.dec = decs[s];
+
+		SG_compute(geometry, &sky);
+
+		double A = 0.0, B = 0.0, C = 0.0;
+		for (int i = 0; i < num_detectors; i++) {
+			detector_antenna_patterns_t ap;
+			double td;
+			Detector_Antenna_Patterns_compute(net->detector[i], &sky, 0.0, ap_ws, &ap);
+			Detector_time_delay(net->detector[i], &sky, &td);
+
+			EXPECT_NEAR( geometry->u[i], ap.u, 1e-14 );
+			EXPECT_NEAR( geometry->v[i], ap.v, 1e-14 );
+			EXPECT_NEAR( geometry->time_delay[i], td, 1e-17 );
+
+			A += ap.u * ap.u;
+			B += ap.u * ap.v;
+			C += ap.v * ap.v;
+		}
+
+		/* O makes the network vectors orthonormal, O G O^T = I for the Gram matrix G = [A B; B C] */
+		double o[2][2] = {{geometry->o11, geometry->o12}, {geometry->o21, geometry->o22}};
+		double g[2][2] = {{A, B}, {B, C}};
+		for (int r = 0; r < 2; r++) {
+			for (int c = 0; c < 2; c++) {
+				double x = 0.0;
+				for (int k = 0; k < 2; k++) {
+					for (int l = 0; l < 2; l++) {
+						x += o[r][k] * g[k][l] * o[c][l];
+					}
+				}
+				EXPECT_NEAR( x, (r == c) ? 1.0 : 0.0, 1e-12 );
+			}
+		}
+	}
+
+	SG_free(geometry);
+	Detector_Antenna_Patterns_workspace_free(ap_ws);
+	Detector_Network_free(net);
+}
+
+TEST(sky_geometry, tableInterpolatesClosedForm) {
+	size_t num_detectors = 3;
+	DETECTOR_ID ids[3] = {H1, L1, V1};
+
+	detector_network_t *net = Detector_Network_alloc( num_detectors );
+	for (int i = 0; i < num_detectors; i++) {
+		psd_t *psd = PSD_alloc(10);
+		psd->type = PSD_ONE_SIDED;
+		Detector_init(ids[i], psd, net->detector[i]);
+	}
+
+	/* One degree grid */
+	sky_geometry_table_t *table = SG_table_alloc(net, 360, 181);
+	sky_geometry_t *exact = SG_alloc(net);
+	sky_geometry_t *interpolated = SG_alloc(net);
+
+	double max_uv_error = 0.0, max_td_error = 0.0;
+	for (int s = 0; s < 1000; s++) {
+		sky_t sky;
+		sky.ra = -M_PI + 2.0 * M_PI * fmod(0.618034 * s, 1.0);
+		sky.dec = -0.5 * M_PI + M_PI * fmod(0.414214 * s, 1.0);
+
+		SG_compute(exact, &sky);
+		SG_table_lookup(table, &sky, interpolated);
+		for (int i = 0; i < num_detectors; i++) {
+			max_uv_error = GSL_MAX( max_uv_error, fabs(interpolated->u[i] - exact->u[i]) );
+			max_uv_error = GSL_MAX( max_uv_error, fabs(interpolated->v[i] - exact->v[i]) );
+			max_td_error = GSL_MAX( max_td_error, fabs(interpolated->time_delay[i] - exact->time_delay[i]) );
+		}
+	}
+	printf("1 degree sky table: max |u, v error| %.3e, max |time delay error| %.3e s\n", max_uv_error, max_td_error);
+	EXPECT_LT( max_uv_error, 2e-4 );
+	EXPECT_LT( max_td_error, 2e-6 );
+
+	/* Exact on the nodes, including the wrap around in right ascension */
+	sky_t node;
+	node.ra = M_PI - 2.0 * M_PI / 360 * 3;
+	node.dec = -0.5 * M_PI + 17 * M_PI / 180;
+	SG_compute(exact, &node);
+	node.ra -= 2.0 * M_PI;
+	SG_table_lookup(table, &node, interpolated);
+	for (int i = 0; i < num_detectors; i++) {
+		EXPECT_NEAR( interpolated->u[i], exact->u[i], 1e-12 );
+		EXPECT_NEAR( interpolated->v[i], exact->v[i], 1e-12 );
+		EXPECT_NEAR( interpolated->time_delay[i], exact->time_delay[i], 1e-15 );
+	}
+	EXPECT_NEAR( interpolated->o11, exact->o11, 1e-10 );
+	EXPECT_NEAR( interpolated->o22, exact->o22, 1e-10 );
+
+	SG_free(interpolated);
+	SG_free(exact);
+	SG_table_free(table);
+	Detector_Network_free(net);
+}
+
+TEST(cpu_dispatch, pathsMatchGenericBitwise) {
+	/* 64 takes radix-4 passes only, 128 ends with a radix-2 pass. 37 leaves a remainder for every vector width. */
+	const size_t n = 37, nfft = 128, stride = 64;
+	CPU_PATH saved = CPU_get_path();
+	double x[n], abs2[2][n], c[2][n], s[2][n], m[2];
+	double fft[2][2*nfft], z_plus[2][2*n], z_minus[2][2*n];
+	float fft_float[2][2*nfft];
+	double ramp_re[3 * stride], ramp_im[3 * stride], w_plus[3], w_minus[3];
+	double data[6][n], *data_re[3], *data_im[3];
+	size_t i, j;
+
+	EXPECT_EQ( CPU_PATH_AVX2, CPU_path_name_to_id( CPU_path_id_to_name(CPU_PATH_AVX2) ) );
+
+	for (j = 0; j < n; j++) {
+		x[j] = 3.0 * sin(0.37 * j) + 100.0 * j;
+	}
+	for (i = 0; i < 3; i++) {
+		for (j = 0; j < n; j++) {
+			ramp_re[i*stride + j] = cos(0.01 * (i + 1) * j);
+			ramp_im[i*stride + j] = -sin(0.01 * (i + 1) * j);
+			data[2*i][j] = 1.0 + 0.1 * i - 0.02 * j;
+			data[2*i + 1][j] = 0.5 - 0.03 * i + 0.01 * j;
+		}
+		data_re[i] = data[2*i];
+		data_im[i] = data[2*i + 1];
+		w_plus[i] = 0.7 - 0.1 * i;
+		w_minus[i] = -0.2 + 0.15 * i;
+	}
+
+	/* Every supported path against the generic one */
+	for (int p = CPU_PATH_GENERIC; p <= CPU_detect_path(); p++) {
+		int r = (p == CPU_PATH_GENERIC) ? 0 : 1;
+		CPU_set_path( (CPU_PATH) p );
+		EXPECT_EQ( CPU_get_path(), p );
+
+		CPU_sincos(n, x, c[r], s[r]);
+		CPU_abs2_pair(n / 2, c[r], s[r], abs2[r]);
+		m[r] = CPU_max(n, x);
+		EXPECT_EQ( m[r], x[n - 1] );
+
+		for (size_t l = 64; l <= nfft; l *= 2) {
+			fft_workspace_t *ws = FFT_workspace_alloc(l);
+			for (j = 0; j < 2*l; j++) {
+				fft[r][j] = sin(0.3*j + 0.1) + 0.25*j;
+				fft_float[r][j] = (float) fft[r][j];
+			}
+			FFT_set_backend(FFT_BACKEND_RADIX4);
+			FFT_execute( FFT_plan_get(l, FFT_FORWARD, FFT_DOUBLE), fft[r], ws );
+			FFT_execute_float( FFT_plan_get(l, FFT_FORWARD, FFT_SINGLE), fft_float[r], ws );
+			FFT_workspace_free(ws);
+		}
+
+		ASSERT_EQ( CN_fixed_fused_block(3, n, c[r], s[r], ramp_re, ramp_im, stride, data_re, data_im, 0,
+				w_plus, w_minus, z_plus[r], z_minus[r]), 1 );
+
+		if (r == 1) {
+			EXPECT_EQ( memcmp(c[0], c[1], sizeof(c[0])), 0 ) << CPU_path_id_to_name( (CPU_PATH) p );
+			EXPECT_EQ( memcmp(s[0], s[1], sizeof(s[0])), 0 ) << CPU_path_id_to_name( (CPU_PATH) p );
+			EXPECT_EQ( memcmp(abs2[0], abs2[1], (n / 2) * sizeof(double)), 0 ) << CPU_path_id_to_name( (CPU_PATH) p );
+			EXPECT_EQ( m[0], m[1] );
+			EXPECT_EQ( memcmp(fft[0], fft[1], sizeof(fft[0])), 0 ) << CPU_path_id_to_name( (CPU_PATH) p );
+			EXPECT_EQ( memcmp(fft_float[0], fft_float[1], sizeof(fft_float[0])), 0 ) << CPU_path_id_to_name( (CPU_PATH) p );
+			EXPECT_EQ( memcmp(z_plus[0], z_plus[1], sizeof(z_plus[0])), 0 ) << CPU_path_id_to_name( (CPU_PATH) p );
+			EXPECT_EQ( memcmp(z_minus[0], z_minus[1], sizeof(z_minus[0])), 0 ) << CPU_path_id_to_name( (CPU_PATH) p );
+		}
+	}
+
+	FFT_set_backend(FFT_BACKEND_AUTO);
+	CPU_set_path(saved);
+}
+
+TEST(arena, alignedBlocksAndPeak) {
+	size_t i;
+	arena_t *arena = AR_alloc(1024, ARENA_PAGES_DEFAULT);
+
+	/* Odd sizes, one larger than a chunk */
+	size_t sizes[5] = { 1, 100, 3000, 64, 7 };
+	char *blocks[5];
+	for (i = 0; i < 5; i++) {
+		blocks[i] = (char*) AR_malloc(arena, sizes[i]);
+		EXPECT_EQ( ((uintptr_t) blocks[i]) % ARENA_ALIGNMENT, 0u );
+		memset(blocks[i], (int) i, sizes[i]);
+	}
+	for (i = 0; i < 5; i++) {
+		EXPECT_EQ( blocks[i][sizes[i] - 1], (char) i );
+	}
+
+	EXPECT_EQ( AR_peak_bytes(arena), 64u + 128u + 3008u + 64u + 64u );
+	EXPECT_GE( AR_reserved_bytes(arena), AR_peak_bytes(arena) );
+
+	double *zeros = (double*) AR_calloc(arena, 10, sizeof(double));
+	for (i = 0; i < 10; i++) {
+		EXPECT_EQ( zeros[i], 0.0 );
+	}
+
+	AR_free(arena);
+
+	EXPECT_EQ( AR_pages_name_to_id("transparent"), ARENA_PAGES_TRANSPARENT );
+	EXPECT_STREQ( AR_pages_id_to_name(ARENA_PAGES_EXPLICIT), "explicit" );
+}
+
+TEST(network_strain, copyIsDeep) {
+	size_t i, k;
+	network_strain_half_fft_t *strain = network_strain_half_fft_alloc_realizations(3, 64, 2);
+	for (i = 0; i < 6; i++) {
+		for (k = 0; k < strain->strains[i]->half_fft_len; k++) {
+			GSL_SET_COMPLEX( &strain->strains[i]->half_fft[k], i + 0.5 * k, i - 0.25 * k );
+		}
+	}
+
+	network_strain_half_fft_t *copy = network_strain_half_fft_copy(strain);
+	EXPECT_EQ( copy->num_strains, strain->num_strains );
+	EXPECT_EQ( copy->num_time_samples, strain->num_time_samples );
+	EXPECT_EQ( copy->num_realizations, strain->num_realizations );
+	for (i = 0; i < 6; i++) {
+		EXPECT_NE( copy->strains[i]->half_fft, strain->strains[i]->half_fft );
+		for (k = 0; k < strain->strains[i]->half_fft_len; k++) {
+			EXPECT_EQ( GSL_REAL(copy->strains[i]->half_fft[k]), GSL_REAL(strain->strains[i]->half_fft[k]) );
+			EXPECT_EQ( GSL_IMAG(copy->strains[i]->half_fft[k]), GSL_IMAG(strain->strains[i]->half_fft[k]) );
+		}
+	}
+
+	network_strain_half_fft_free(copy);
+	network_strain_half_fft_free(strain);
+}
+
 TEST(ChirpTime, matchesMatlab) {
 	// Inputs needed to compute the chirp times and other values
 	double m1 = 1.4 * GSL_CONST_MKSA_SOLAR_MASS;
@@ -596,11 +1231,7 @@ TEST(SP_workspace, coefficients) {
 	for (int i = 0; i < sp_workspace->len; i++) {
 		EXPECT_EQ( sp_workspace->g_coeff[i],  1.0);
 		EXPECT_EQ( sp_workspace->chirp_tc_coeff[i], 2.0 * M_PI );
-		EXPECT_EQ( sp_workspace->constant_coeff[i], -M_PI / 4.0 );
-		EXPECT_EQ( sp_workspace->chirp_time_0_coeff[i], 2.0 * M_PI * 3.0 / 5.0 );
-		EXPECT_EQ( sp_workspace->chirp_time_1_coeff[i],  2.0 * M_PI );
-		EXPECT_EQ( sp_workspace->chirp_time1_5_coeff[i], -3.0 * M_PI );
-		EXPECT_EQ( sp_workspace->chirp_time2_coeff[i], 6.0 * M_PI );
+		EXPECT_EQ( sp_workspace->u_coeff[i], 1.0 );
 	}
 
 	EXPECT_EQ( sp_workspace->f_low_index, 1);
@@ -661,6 +1292,56 @@ TEST(SP_compute, valuesMatcheMatlabVersion) {
 	SP_workspace_free(w);
 }
 
+TEST(SP_compute, intrinsicWithTimeDelayMatchesDirect) {
+	double detector_normalization_factor = 2.0;
+	double inspiral_coalesce_phase = 3.0;
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = 8.0;
+	double f_low = 20.0;
+	double f_high = 900.0;
+
+	/* Evenly spaced frequencies use the recurrence, the uneven ones a sin and cos per bin. */
+	size_t len_f_array = 2049;
+	double *f_array = (double*) malloc( len_f_array * sizeof(double) );
+
+	for (int spacing = 0; spacing < 2; spacing++) {
+		for (int i = 0; i < len_f_array; i++) {
+			f_array[i] = (spacing == 0) ? 0.5 * i : 0.5 * i + 1e-3 * (i % 3);
+		}
+
+		stationary_phase_workspace_t *w = SP_workspace_alloc(f_low, f_high, len_f_array, f_array);
+		EXPECT_EQ( spacing == 0, w->f_step > 0.0 );
+
+		stationary_phase_t *direct = SP_alloc(len_f_array);
+		stationary_phase_t *intrinsic = SP_alloc(len_f_array);
+		stationary_phase_t *shifted = SP_alloc(len_f_array);
+
+		SP_compute_intrinsic(inspiral_coalesce_phase, &ct, w, intrinsic);
+
+		double time_delays[3] = {0.0, 0.021, -0.0137};
+		for (int d = 0; d < 3; d++) {
+			SP_compute(time_delays[d], detector_normalization_factor, inspiral_coalesce_phase, &ct, w, direct);
+			SP_apply_time_delay(time_delays[d], detector_normalization_factor, intrinsic, w, shifted);
+
+			for (int i = 0; i < len_f_array; i++) {
+				EXPECT_NEAR( GSL_REAL(shifted->spa_0[i]), GSL_REAL(direct->spa_0[i]), 1e-12 );
+				EXPECT_NEAR( GSL_IMAG(shifted->spa_0[i]), GSL_IMAG(direct->spa_0[i]), 1e-12 );
+			}
+		}
+
+		SP_free(shifted);
+		SP_free(intrinsic);
+		SP_free(direct);
+		SP_workspace_free(w);
+	}
+
+	free(f_array);
+}
+
 TEST(SP_normalization, valuesMatchMatlabVersion) {
 	double f_low = 1.1;
 	double f_high = 9.0;
@@ -868,5 +1549,814 @@ TEST(coherent_network_statistic, CN_compute_valuesMatchMatlabVersion) {
 
 }
 
+TEST(coherent_network_statistic, CN_enginesMatchTwoSided) {
+	sky_t sky;
+	sky.ra = 1.0;
+	sky.dec = 1.0;
+
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = ct.chirp_time0 + ct.chirp_time1 - ct.chirp_time1_5 + ct.chirp_time2;
+
+	double f_low = 1.0;
+
+	size_t num_detectors = 4;
+	DETECTOR_ID ids[4] = {H1,L1,V1,K1};
+
+	size_t lengths[2] = {12, 16};
+
+	for (int n = 0; n < 2; n++) {
+		size_t num_time_samples = lengths[n];
+
+		network_strain_half_fft_t *network_strain = network_strain_half_fft_alloc(
+				num_detectors, num_time_samples);
+		for (int i = 0; i < num_detectors; i++) {
+			for (int k = 0; k < network_strain->strains[i]->half_fft_len; k++) {
+				network_strain->strains[i]->half_fft[k] = gsl_complex_rect(k + i, 2.0*k - i);
+			}
+		}
+
+		size_t len_f_array = network_strain->strains[0]->half_fft_len;
+
+		/* The band includes the Nyquist term */
+		double f_high = len_f_array - 1;
+
+		detector_network_t *net = Detector_Network_alloc( num_detectors );
+		for (int i = 0; i < num_detectors; i++) {
+			psd_t *psd = PSD_alloc(len_f_array);
+			for (int k = 0; k < len_f_array; k++) {
+				psd->f[k] = k;
+				psd->psd[k] = 1.0 + k;
+				psd->type = PSD_ONE_SIDED;
+			}
+			Detector_init(ids[i], psd, net->detector[i]);
+		}
+
+		coherent_network_workspace_t *ws = CN_workspace_alloc(
+				num_time_samples, net, len_f_array, f_low, f_high);
+
+		double two_sided_snr;
+		coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, ws, &two_sided_snr, NULL);
+
+		double *two_sided_ifft = (double*) malloc(num_time_samples * sizeof(double));
+		memcpy(two_sided_ifft, ws->temp_ifft, num_time_samples * sizeof(double));
+
+		EXPECT_GT( two_sided_snr, 0.0 );
+
+		CN_ENGINE engines[2] = {CN_ENGINE_ONE_SIDED, CN_ENGINE_FUSED};
+		for (int e = 0; e < 2; e++) {
+			double snr;
+			CN_workspace_set_engine(ws, engines[e]);
+			coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, ws, &snr, NULL);
+
+			EXPECT_NEAR( snr, two_sided_snr, 1e-12 );
+			for (int j = 0; j < num_time_samples; j++) {
+				EXPECT_NEAR( ws->temp_ifft[j], two_sided_ifft[j], 1e-9 * (1.0 + two_sided_ifft[j]) );
+			}
+		}
+
+		free(two_sided_ifft);
+		CN_workspace_free(ws);
+		Detector_Network_free(net);
+		network_strain_half_fft_free(network_strain);
+	}
+}
+
+/* Accuracy of the single precision path against the double one, on the Matlab reference data and on a
+ * longer series with large template phases.
+ */
+TEST(coherent_network_statistic, CN_singlePrecisionMatchesDouble) {
+	sky_t sky;
+	sky.ra = 1.0;
+	sky.dec = 1.0;
+
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = ct.chirp_time0 + ct.chirp_time1 - ct.chirp_time1_5 + ct.chirp_time2;
+
+	size_t num_detectors = 4;
+	DETECTOR_ID ids[4] = {H1,L1,V1,K1};
+
+	size_t lengths[2] = {10, 4096};
+	double f_lows[2] = {4.0, 20.0};
+	double f_highs[2] = {4.0, 1000.0};
+
+	for (int n = 0; n < 2; n++) {
+		size_t num_time_samples = lengths[n];
+
+		network_strain_half_fft_t *network_strain = network_strain_half_fft_alloc(
+				num_detectors, num_time_samples);
+		for (int i = 0; i < num_detectors; i++) {
+			for (int k = 0; k < network_strain->strains[i]->half_fft_len; k++) {
+				if (n == 0) {
+					network_strain->strains[i]->half_fft[k] = gsl_complex_rect(k, k);
+				} else {
+					network_strain->strains[i]->half_fft[k] = gsl_complex_rect(cos(0.1*k*k + i), sin(0.3*k - i));
+				}
+			}
+		}
+
+		size_t len_f_array = network_strain->strains[0]->half_fft_len;
+
+		detector_network_t *net = Detector_Network_alloc( num_detectors );
+		for (int i = 0; i < num_detectors; i++) {
+			psd_t *psd = PSD_alloc(len_f_array);
+			for (int k = 0; k < len_f_array; k++) {
+				psd->f[k] = k;
+				psd->psd[k] = (n == 0) ? 1.0 : 1.0 + 1e-3 * k;
+				psd->type = PSD_ONE_SIDED;
+			}
+			Detector_init(ids[i], psd, net->detector[i]);
+		}
+
+		coherent_network_workspace_t *ws = CN_workspace_alloc(
+				num_time_samples, net, len_f_array, f_lows[n], f_highs[n]);
+		CN_workspace_set_engine(ws, CN_ENGINE_FUSED);
+
+		double double_snr;
+		coherent_network_statistic(net, f_lows[n], f_highs[n], &ct, &sky, network_strain, ws, &double_snr, NULL);
+
+		double *double_ifft = (double*) malloc(num_time_samples * sizeof(double));
+		memcpy(double_ifft, ws->temp_ifft, num_time_samples * sizeof(double));
+
+		double single_snr;
+		CN_workspace_set_precision(ws, FFT_SINGLE);
+		coherent_network_statistic(net, f_lows[n], f_highs[n], &ct, &sky, network_strain, ws, &single_snr, NULL);
+
+		double max_ifft = 0.0;
+		double max_error = 0.0;
+		for (int j = 0; j < num_time_samples; j++) {
+			max_ifft = GSL_MAX(max_ifft, double_ifft[j]);
+			max_error = GSL_MAX(max_error, fabs(ws->temp_ifft[j] - double_ifft[j]));
+		}
+
+		fprintf(stderr, "N = %lu: network snr %0.9e (double) %0.9e (single), max |ifft error| / max ifft = %0.3e\n",
+				num_time_samples, double_snr, single_snr, max_error / max_ifft);
+
+		EXPECT_NEAR( single_snr, double_snr, 1e-5 * double_snr );
+		EXPECT_LT( max_error, 1e-5 * max_ifft );
+
+		free(double_ifft);
+		CN_workspace_free(ws);
+		Detector_Network_free(net);
+		network_strain_half_fft_free(network_strain);
+	}
+}
+
+TEST(coherent_network_statistic, CN_precision_names) {
+	EXPECT_EQ( FFT_DOUBLE, CN_precision_name_to_id( CN_precision_id_to_name(FFT_DOUBLE) ) );
+	EXPECT_EQ( FFT_SINGLE, CN_precision_name_to_id( CN_precision_id_to_name(FFT_SINGLE) ) );
+}
+
+TEST(coherent_network_statistic, CN_tcWindowMatchesFullSeries) {
+	sky_t sky;
+	sky.ra = 1.0;
+	sky.dec = 1.0;
+
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = ct.chirp_time0 + ct.chirp_time1 - ct.chirp_time1_5 + ct.chirp_time2;
+
+	size_t num_detectors = 4;
+	DETECTOR_ID ids[4] = {H1,L1,V1,K1};
+
+	size_t num_time_samples = 64;
+	double f_low = 2.0;
+	double f_high = 25.0;
+
+	network_strain_half_fft_t *network_strain = network_strain_half_fft_alloc(
+			num_detectors, num_time_samples);
+	for (int i = 0; i < num_detectors; i++) {
+		for (int k = 0; k < network_strain->strains[i]->half_fft_len; k++) {
+			network_strain->strains[i]->half_fft[k] = gsl_complex_rect(cos(0.4*k + i), sin(0.9*k*k - i));
+		}
+	}
+
+	size_t len_f_array = network_strain->strains[0]->half_fft_len;
+
+	detector_network_t *net = Detector_Network_alloc( num_detectors );
+	for (int i = 0; i < num_detectors; i++) {
+		psd_t *psd = PSD_alloc(len_f_array);
+		for (int k = 0; k < len_f_array; k++) {
+			psd->f[k] = k;
+			psd->psd[k] = 1.0 + k;
+			psd->type = PSD_ONE_SIDED;
+		}
+		Detector_init(ids[i], psd, net->detector[i]);
+	}
+
+	coherent_network_workspace_t *ws = CN_workspace_alloc(
+			num_time_samples, net, len_f_array, f_low, f_high);
+
+	CN_ENGINE engines[3] = {CN_ENGINE_TWO_SIDED, CN_ENGINE_ONE_SIDED, CN_ENGINE_FUSED};
+	size_t windows[3][2] = { {0, 8}, {21, 5}, {40, 24} };
+
+	for (int e = 0; e < 3; e++) {
+		CN_workspace_set_engine(ws, engines[e]);
+
+		double full_snr;
+		CN_workspace_set_tc_window(ws, 0, 0);
+		coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, ws, &full_snr, NULL);
+
+		double *full_ifft = (double*) malloc(num_time_samples * sizeof(double));
+		memcpy(full_ifft, ws->temp_ifft, num_time_samples * sizeof(double));
+
+		for (int w = 0; w < 3; w++) {
+			size_t start = windows[w][0];
+			size_t count = windows[w][1];
+			double max_value = 0.0;
+			double snr;
+
+			CN_workspace_set_tc_window(ws, start, count);
+			coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, ws, &snr, NULL);
+
+			for (int j = start; j < start + count; j++) {
+				EXPECT_NEAR( ws->temp_ifft[j], full_ifft[j], 1e-9 * (1.0 + full_ifft[j]) );
+				max_value = GSL_MAX(max_value, full_ifft[j]);
+			}
+			EXPECT_NEAR( snr, sqrt(max_value) / sqrt(2.0), 1e-9 );
+			EXPECT_LE( snr, full_snr );
+		}
+
+		free(full_ifft);
+	}
+
+	CN_workspace_free(ws);
+	Detector_Network_free(net);
+	network_strain_half_fft_free(network_strain);
+}
+
+TEST(coherent_network_statistic, CN_basebandRefinesPeak) {
+	sky_t sky;
+	sky.ra = 1.0;
+	sky.dec = 1.0;
+
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = ct.chirp_time0 + ct.chirp_time1 - ct.chirp_time1_5 + ct.chirp_time2;
+
+	size_t num_detectors = 4;
+	DETECTOR_ID ids[4] = {H1,L1,V1,K1};
+
+	/* 24 bins in the band, so the reduced IFFT length is 32 for 64 samples and 30 for 60 */
+	size_t lengths[2] = {64, 60};
+	double f_low = 2.0;
+	double f_high = 25.0;
+
+	for (int n = 0; n < 2; n++) {
+		size_t num_time_samples = lengths[n];
+
+		network_strain_half_fft_t *network_strain = network_strain_half_fft_alloc(
+				num_detectors, num_time_samples);
+		for (int i = 0; i < num_detectors; i++) {
+			for (int k = 0; k < network_strain->strains[i]->half_fft_len; k++) {
+				network_strain->strains[i]->half_fft[k] = gsl_complex_rect(cos(0.4*k + i), sin(0.9*k*k - i));
+			}
+		}
+
+		size_t len_f_array = network_strain->strains[0]->half_fft_len;
+
+		detector_network_t *net = Detector_Network_alloc( num_detectors );
+		for (int i = 0; i < num_detectors; i++) {
+			psd_t *psd = PSD_alloc(len_f_array);
+			for (int k = 0; k < len_f_array; k++) {
+				psd->f[k] = k;
+				psd->psd[k] = 1.0 + k;
+				psd->type = PSD_ONE_SIDED;
+			}
+			Detector_init(ids[i], psd, net->detector[i]);
+		}
+
+		coherent_network_workspace_t *ws = CN_workspace_alloc(
+				num_time_samples, net, len_f_array, f_low, f_high);
+
+		CN_ENGINE engines[2] = {CN_ENGINE_ONE_SIDED, CN_ENGINE_FUSED};
+		for (int e = 0; e < 2; e++) {
+			CN_workspace_set_engine(ws, engines[e]);
+
+			double full_snr;
+			CN_workspace_set_baseband(ws, 0);
+			coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, ws, &full_snr, NULL);
+
+			double *full_ifft = (double*) malloc(num_time_samples * sizeof(double));
+			memcpy(full_ifft, ws->temp_ifft, num_time_samples * sizeof(double));
+
+			double snr;
+			CN_workspace_set_baseband(ws, 1);
+			coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, ws, &snr, NULL);
+
+			size_t stride = num_time_samples / ws->baseband_len;
+			EXPECT_LT( ws->baseband_len, num_time_samples );
+			EXPECT_EQ( 2*stride - 1, ws->search_count );
+
+			/* The coarse samples and the refined ones are exact */
+			for (int r = 0; r < ws->baseband_len; r++) {
+				EXPECT_NEAR( ws->temp_ifft[r * stride], full_ifft[r * stride], 1e-9 * (1.0 + full_ifft[r * stride]) );
+			}
+			for (int m = 0; m < ws->search_count; m++) {
+				size_t t = (ws->search_start + m) % num_time_samples;
+				EXPECT_NEAR( ws->temp_ifft[t], full_ifft[t], 1e-9 * (1.0 + full_ifft[t]) );
+			}
+
+			EXPECT_NEAR( snr, full_snr, 1e-9 );
+
+			free(full_ifft);
+		}
+
+		CN_workspace_free(ws);
+		Detector_Network_free(net);
+		network_strain_half_fft_free(network_strain);
+	}
+}
+
+TEST(template_cache, hitsMissesAndEviction) {
+	const size_t len = 5;
+	double re[len], im[len], out_re[len], out_im[len];
+	double quantum = 1e-3;
+
+	/* Room for two templates, in one shard */
+	template_cache_t *cache = TC_alloc(len, 2 * (2 * len * sizeof(double) + 64), quantum);
+	ASSERT_EQ( TC_capacity(cache), 2 );
+
+	double t0 = 12.3456, t1_5 = 0.7891;
+	TC_snap(cache, &t0, &t1_5);
+	EXPECT_NEAR( t0, 12.346, 1e-12 );
+	EXPECT_NEAR( t1_5, 0.789, 1e-12 );
+
+	EXPECT_EQ( TC_get(cache, t0, t1_5, out_re, out_im), 0 );
+	for (int k = 0; k < len; k++) {
+		re[k] = k;
+		im[k] = -2.0 * k;
+	}
+	TC_put(cache, t0, t1_5, re, im);
+
+	/* Anything that rounds to the same grid point hits */
+	EXPECT_EQ( TC_get(cache, t0 + 0.4 * quantum, t1_5 - 0.4 * quantum, out_re, out_im), 1 );
+	for (int k = 0; k < len; k++) {
+		EXPECT_EQ( out_re[k], re[k] );
+		EXPECT_EQ( out_im[k], im[k] );
+	}
+
+	/* The least recently used of the three templates is evicted */
+	TC_put(cache, 1.0, 0.5, re, im);
+	EXPECT_EQ( TC_get(cache, t0, t1_5, out_re, out_im), 1 );
+	TC_put(cache, 2.0, 0.5, re, im);
+	EXPECT_EQ( TC_get(cache, 1.0, 0.5, out_re, out_im), 0 );
+	EXPECT_EQ( TC_get(cache, t0, t1_5, out_re, out_im), 1 );
+	EXPECT_EQ( TC_get(cache, 2.0, 0.5, out_re, out_im), 1 );
+
+	EXPECT_EQ( TC_hits(cache), 4 );
+	EXPECT_EQ( TC_misses(cache), 2 );
+
+	TC_free(cache);
+}
+
+TEST(coherent_network_statistic, CN_templateCacheMatchesDirect) {
+	sky_t sky;
+	sky.ra = 1.0;
+	sky.dec = 1.0;
+
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = ct.chirp_time0 + ct.chirp_time1 - ct.chirp_time1_5 + ct.chirp_time2;
+
+	double f_low = 1.0;
+	size_t num_detectors = 4;
+	DETECTOR_ID ids[4] = {H1,L1,V1,K1};
+	size_t num_time_samples = 16;
+
+	network_strain_half_fft_t *network_strain = network_strain_half_fft_alloc(num_detectors, num_time_samples);
+	for (int i = 0; i < num_detectors; i++) {
+		for (int k = 0; k < network_strain->strains[i]->half_fft_len; k++) {
+			network_strain->strains[i]->half_fft[k] = gsl_complex_rect(k + i, 2.0*k - i);
+		}
+	}
+
+	size_t len_f_array = network_strain->strains[0]->half_fft_len;
+	double f_high = len_f_array - 1;
+
+	detector_network_t *net = Detector_Network_alloc( num_detectors );
+	for (int i = 0; i < num_detectors; i++) {
+		psd_t *psd = PSD_alloc(len_f_array);
+		for (int k = 0; k < len_f_array; k++) {
+			psd->f[k] = k;
+			psd->psd[k] = 1.0 + k;
+			psd->type = PSD_ONE_SIDED;
+		}
+		Detector_init(ids[i], psd, net->detector[i]);
+	}
+
+	coherent_network_workspace_t *ws = CN_workspace_alloc(num_time_samples, net, len_f_array, f_low, f_high);
+	template_cache_t *cache = TC_alloc(ws->sp_lookup->len, 1 << 20, 1e-6);
+
+	CN_ENGINE engines[3] = {CN_ENGINE_TWO_SIDED, CN_ENGINE_ONE_SIDED, CN_ENGINE_FUSED};
+	for (int e = 0; e < 3; e++) {
+		double snr, cached_snr;
+		CN_workspace_set_engine(ws, engines[e]);
+
+		CN_workspace_set_template_cache(ws, NULL);
+		coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, ws, &snr, NULL);
+
+		/* The first engine misses, every evaluation after that hits */
+		CN_workspace_set_template_cache(ws, cache);
+		for (int r = 0; r < 2; r++) {
+			coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, ws, &cached_snr, NULL);
+			EXPECT_NEAR( cached_snr, snr, 1e-12 * snr );
+		}
+	}
+
+	EXPECT_EQ( TC_misses(cache), 1 );
+	EXPECT_EQ( TC_hits(cache), 5 );
+
+	CN_workspace_free(ws);
+	TC_free(cache);
+	Detector_Network_free(net);
+	network_strain_half_fft_free(network_strain);
+}
+
+TEST(coherent_network_statistic, CN_skySeriesMatchesStatistic) {
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = ct.chirp_time0 + ct.chirp_time1 - ct.chirp_time1_5 + ct.chirp_time2;
+
+	double f_low = 20.0;
+	double f_high = 400.0;
+	size_t num_detectors = 4;
+	size_t num_time_samples = 1024;
+
+	network_strain_half_fft_t *network_strain;
+	detector_network_t *net;
+	coherent_network_workspace_t *ws = CN_test_data_alloc(num_detectors, 1, num_time_samples, f_low, f_high,
+			&network_strain, &net);
+	CN_workspace_set_engine(ws, CN_ENGINE_ONE_SIDED);
+
+	double ra[5] = {1.0, -2.5, 0.2, 3.0, -0.7};
+	double dec[5] = {1.0, 0.3, -1.2, 0.0, -0.4};
+	sky_t sky[5];
+	double sky_snr[5];
+	for (int s = 0; s < 5; s++) {
+		sky[s].ra = ra[s];
+		sky[s].dec = dec[s];
+	}
+
+	CN_sky_series_compute(net, &ct, network_strain, ws);
+	CN_sky_series_statistic(net, 5, sky, ws, sky_snr);
+
+	double max_error = 0.0;
+	for (int s = 0; s < 5; s++) {
+		double snr;
+		coherent_network_statistic(net, f_low, f_high, &ct, &sky[s], network_strain, ws, &snr, NULL);
+		EXPECT_NEAR( sky_snr[s], snr, 1e-3 * snr );
+		max_error = GSL_MAX( max_error, fabs(sky_snr[s] - snr) / snr );
+	}
+	printf("sky series relative error %g\n", max_error);
+
+	CN_workspace_free(ws);
+	Detector_Network_free(net);
+	network_strain_half_fft_free(network_strain);
+}
+
+TEST(coherent_network_statistic, CN_batchMatchesSingle) {
+	double f_low = 20.0;
+	double f_high = 400.0;
+	size_t num_detectors = 4;
+	size_t num_time_samples = 1024;
+
+	network_strain_half_fft_t *network_strain;
+	detector_network_t *net;
+	coherent_network_workspace_t *ws = CN_test_data_alloc(num_detectors, 1, num_time_samples, f_low, f_high,
+			&network_strain, &net);
+
+	/* More points than one batch, so the last batch is partly filled */
+	const size_t num_points = CN_BATCH_SIZE + 3;
+	inspiral_chirp_time_t ct[num_points];
+	sky_t sky[num_points];
+	double batch_snr[num_points];
+	for (int p = 0; p < num_points; p++) {
+		ct[p].chirp_time0 = 4.0 + 0.1 * p;
+		ct[p].chirp_time1 = 5.0;
+		ct[p].chirp_time1_5 = 6.0 - 0.05 * p;
+		ct[p].chirp_time2 = 7.0;
+		ct[p].tc = ct[p].chirp_time0 + ct[p].chirp_time1 - ct[p].chirp_time1_5 + ct[p].chirp_time2;
+		sky[p].ra = -3.0 + 0.8 * p;
+		sky[p].dec = -1.2 + 0.35 * p;
+	}
+
+	template_cache_t *cache = TC_alloc(ws->sp_lookup->len, 1 << 20, 1e-6);
+
+	CN_ENGINE engines[2] = {CN_ENGINE_ONE_SIDED, CN_ENGINE_FUSED};
+	for (int e = 0; e < 2; e++) {
+		CN_workspace_set_engine(ws, engines[e]);
+
+		for (int c = 0; c < 2; c++) {
+			CN_workspace_set_template_cache(ws, c ? cache : NULL);
+			coherent_network_statistic_batch(net, f_low, f_high, num_points, ct, sky, network_strain, ws, batch_snr);
+
+			for (int p = 0; p < num_points; p++) {
+				double snr;
+				coherent_network_statistic(net, f_low, f_high, &ct[p], &sky[p], network_strain, ws, &snr, NULL);
+				EXPECT_NEAR( batch_snr[p], snr, 1e-12 * snr );
+			}
+		}
+	}
+
+	CN_workspace_set_template_cache(ws, NULL);
+	CN_workspace_free(ws);
+	TC_free(cache);
+	Detector_Network_free(net);
+	network_strain_half_fft_free(network_strain);
+}
+
+TEST(coherent_network_statistic, CN_realizationsMatchSingle) {
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = ct.chirp_time0 + ct.chirp_time1 - ct.chirp_time1_5 + ct.chirp_time2;
+
+	sky_t sky;
+	sky.ra = 1.0;
+	sky.dec = -0.4;
+
+	double f_low = 20.0;
+	double f_high = 200.0;
+	size_t num_detectors = 3;
+	size_t num_time_samples = 512;
+	const size_t num_realizations = 3;
+
+	network_strain_half_fft_t *network_strain;
+	detector_network_t *net;
+	coherent_network_workspace_t *ws = CN_test_data_alloc(num_detectors, num_realizations, num_time_samples,
+			f_low, f_high, &network_strain, &net);
+
+	network_strain_half_fft_t views[num_realizations];
+	for (int r = 0; r < num_realizations; r++) {
+		network_strain_half_fft_realization(network_strain, r, &views[r]);
+		EXPECT_EQ( views[r].strains[0], network_strain->strains[r * num_detectors] );
+	}
+
+	CN_ENGINE engines[2] = {CN_ENGINE_TWO_SIDED, CN_ENGINE_FUSED};
+	for (int e = 0; e < 2; e++) {
+		double snr[num_realizations];
+		CN_workspace_set_engine(ws, engines[e]);
+
+		/* Twice, the second time with the realizations already filtered */
+		for (int repeat = 0; repeat < 2; repeat++) {
+			coherent_network_statistic_realizations(net, f_low, f_high, &ct, &sky, network_strain, ws, snr);
+
+			for (int r = 0; r < num_realizations; r++) {
+				double single_snr;
+				coherent_network_statistic(net, f_low, f_high, &ct, &sky, &views[r], ws, &single_snr, NULL);
+				EXPECT_NEAR( snr[r], single_snr, 1e-12 * single_snr );
+			}
+		}
+	}
+
+	CN_workspace_free(ws);
+	Detector_Network_free(net);
+	network_strain_half_fft_free(network_strain);
+}
+
+TEST(coherent_network_statistic, CN_filteredDataFollowsGeneration) {
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = ct.chirp_time0 + ct.chirp_time1 - ct.chirp_time1_5 + ct.chirp_time2;
+
+	sky_t sky;
+	sky.ra = 1.0;
+	sky.dec = -0.4;
+
+	double f_low = 20.0;
+	double f_high = 200.0;
+	size_t num_detectors = 3;
+	size_t num_time_samples = 512;
+	const size_t num_realizations = 2;
+
+	network_strain_half_fft_t *network_strain;
+	detector_network_t *net;
+	coherent_network_workspace_t *ws = CN_test_data_alloc(num_detectors, num_realizations, num_time_samples,
+			f_low, f_high, &network_strain, &net);
+	CN_workspace_set_engine(ws, CN_ENGINE_FUSED);
+
+	network_strain_half_fft_t view;
+	network_strain_half_fft_realization(network_strain, 0, &view);
+
+	double before, snr[num_realizations];
+	coherent_network_statistic(net, f_low, f_high, &ct, &sky, &view, ws, &before, NULL);
+	coherent_network_statistic_realizations(net, f_low, f_high, &ct, &sky, network_strain, ws, snr);
+
+	/* Doubling the data in place doubles the statistic once the strain is marked as changed */
+	for (int i = 0; i < num_realizations * num_detectors; i++) {
+		for (int k = 0; k < network_strain->strains[i]->half_fft_len; k++) {
+			network_strain->strains[i]->half_fft[k] = gsl_complex_mul_real(network_strain->strains[i]->half_fft[k], 2.0);
+		}
+	}
+	network_strain_half_fft_changed(network_strain);
+
+	double after, snr_after[num_realizations];
+	network_strain_half_fft_realization(network_strain, 0, &view);
+	coherent_network_statistic(net, f_low, f_high, &ct, &sky, &view, ws, &after, NULL);
+	EXPECT_NEAR( after, 2.0 * before, 1e-12 * after );
+
+	coherent_network_statistic_realizations(net, f_low, f_high, &ct, &sky, network_strain, ws, snr_after);
+	for (int r = 0; r < num_realizations; r++) {
+		EXPECT_NEAR( snr_after[r], 2.0 * snr[r], 1e-12 * snr_after[r] );
+	}
+
+	CN_workspace_free(ws);
+	Detector_Network_free(net);
+	network_strain_half_fft_free(network_strain);
+}
+
+TEST(coherent_network_statistic, CN_threadsMatchSerial) {
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = ct.chirp_time0 + ct.chirp_time1 - ct.chirp_time1_5 + ct.chirp_time2;
+
+	sky_t sky;
+	sky.ra = -2.0;
+	sky.dec = 0.6;
+
+	double f_low = 20.0;
+	double f_high = 900.0;
+	size_t num_detectors = 4;
+	size_t num_time_samples = 2048;
+
+	network_strain_half_fft_t *network_strain;
+	detector_network_t *net;
+	coherent_network_workspace_t *ws = CN_test_data_alloc(num_detectors, 1, num_time_samples, f_low, f_high,
+			&network_strain, &net);
+
+	/* The engines, then the fused engine with a tc window, with the baseband evaluation and in single precision */
+	CN_ENGINE engines[6] = {CN_ENGINE_TWO_SIDED, CN_ENGINE_ONE_SIDED, CN_ENGINE_FUSED, CN_ENGINE_FUSED, CN_ENGINE_FUSED,
+			CN_ENGINE_FUSED};
+	for (int e = 0; e < 6; e++) {
+		double serial_snr, threaded_snr;
+		CN_workspace_set_engine(ws, engines[e]);
+		CN_workspace_set_tc_window(ws, 300, (e == 3) ? 500 : 0);
+		CN_workspace_set_baseband(ws, e == 4);
+		CN_workspace_set_precision(ws, (e == 5) ? FFT_SINGLE : FFT_DOUBLE);
+
+		CN_workspace_set_threads(ws, 1);
+		coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, ws, &serial_snr, NULL);
+
+		CN_workspace_set_threads(ws, 3);
+		coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, ws, &threaded_snr, NULL);
+
+		EXPECT_NEAR( threaded_snr, serial_snr, 1e-12 * serial_snr );
+	}
+
+	CN_workspace_free(ws);
+	Detector_Network_free(net);
+	network_strain_half_fft_free(network_strain);
+}
+
+TEST(coherent_network_statistic, CN_sharedContextWorkspaces) {
+	inspiral_chirp_time_t ct;
+	ct.chirp_time0 = 4.0;
+	ct.chirp_time1 = 5.0;
+	ct.chirp_time1_5 = 6.0;
+	ct.chirp_time2 = 7.0;
+	ct.tc = ct.chirp_time0 + ct.chirp_time1 - ct.chirp_time1_5 + ct.chirp_time2;
+
+	sky_t sky;
+	sky.ra = 0.3;
+	sky.dec = 0.9;
+
+	double f_low = 20.0;
+	double f_high = 400.0;
+	size_t num_detectors = 3;
+	size_t num_time_samples = 1024;
+
+	network_strain_half_fft_t *network_strain;
+	detector_network_t *net;
+	coherent_network_workspace_t *own = CN_test_data_alloc(num_detectors, 1, num_time_samples, f_low, f_high,
+			&network_strain, &net);
+	coherent_network_context_t *context = CN_context_alloc(num_time_samples, net, network_strain->strains[0]->half_fft_len,
+			f_low, f_high);
+	coherent_network_workspace_t *shared[2];
+	for (int w = 0; w < 2; w++) {
+		shared[w] = CN_workspace_alloc_shared(context, net);
+		EXPECT_EQ( shared[w]->sp_lookup, context->sp_lookup );
+	}
+
+	/* The fused engine never needs the two-sided buffers */
+	CN_workspace_set_engine(shared[0], CN_ENGINE_FUSED);
+	size_t fused_bytes = CN_workspace_bytes_per_thread(shared[0]);
+	CN_ENGINE engines[2] = {CN_ENGINE_FUSED, CN_ENGINE_TWO_SIDED};
+	for (int e = 0; e < 2; e++) {
+		double snr, shared_snr;
+		CN_workspace_set_engine(own, engines[e]);
+		coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, own, &snr, NULL);
+
+		for (int w = 0; w < 2; w++) {
+			CN_workspace_set_engine(shared[w], engines[e]);
+			coherent_network_statistic(net, f_low, f_high, &ct, &sky, network_strain, shared[w], &shared_snr, NULL);
+			EXPECT_EQ( shared_snr, snr );
+		}
+
+		if (e == 0) {
+			EXPECT_EQ( CN_workspace_bytes_per_thread(shared[0]), fused_bytes );
+		}
+	}
+
+	/* c_plus and c_minus per detector and terms[4] are added by the two-sided engine */
+	size_t two_sided_bytes = CN_workspace_bytes_per_thread(shared[0]);
+	EXPECT_GE( two_sided_bytes - fused_bytes, (2 * num_detectors + 4) * num_time_samples * sizeof(gsl_complex) );
+
+	for (int w = 0; w < 2; w++) {
+		CN_workspace_free(shared[w]);
+	}
+	CN_context_free(context);
+	CN_workspace_free(own);
+	Detector_Network_free(net);
+	network_strain_half_fft_free(network_strain);
+}
+
+TEST(coherent_network_statistic, CN_fixedKernelsMatchGeneric) {
+	const size_t n = 37, stride = 64, offset = 5;
+	size_t d, i, j;
+	double g_re[n], g_im[n], ramp_re[6 * stride], ramp_im[6 * stride], w_plus[6], w_minus[6];
+	double data[12][n + offset];
+	double *data_re[6], *data_im[6];
+	double z_plus[2*n], z_minus[2*n];
+
+	for (j = 0; j < n; j++) {
+		g_re[j] = cos(0.3 * j);
+		g_im[j] = sin(0.3 * j);
+	}
+	for (i = 0; i < 6; i++) {
+		for (j = 0; j < n; j++) {
+			ramp_re[i*stride + j] = cos(0.01 * (i + 1) * j);
+			ramp_im[i*stride + j] = -sin(0.01 * (i + 1) * j);
+		}
+		for (j = 0; j < n + offset; j++) {
+			data[2*i][j] = 1.0 + 0.1 * i - 0.02 * j;
+			data[2*i + 1][j] = 0.5 - 0.03 * i + 0.01 * j;
+		}
+		data_re[i] = data[2*i];
+		data_im[i] = data[2*i + 1];
+		w_plus[i] = 0.7 - 0.1 * i;
+		w_minus[i] = -0.2 + 0.15 * i;
+	}
+
+	EXPECT_EQ( CN_fixed_fused_block(1, n, g_re, g_im, ramp_re, ramp_im, stride, data_re, data_im, offset,
+			w_plus, w_minus, z_plus, z_minus), 0 );
+	EXPECT_EQ( CN_fixed_fused_block(6, n, g_re, g_im, ramp_re, ramp_im, stride, data_re, data_im, offset,
+			w_plus, w_minus, z_plus, z_minus), 0 );
+
+	for (d = CN_FIXED_MIN_DETECTORS; d <= CN_FIXED_MAX_DETECTORS; d++) {
+		ASSERT_EQ( CN_fixed_fused_block(d, n, g_re, g_im, ramp_re, ramp_im, stride, data_re, data_im, offset,
+				w_plus, w_minus, z_plus, z_minus), 1 );
+
+		for (j = 0; j < n; j++) {
+			gsl_complex zp = gsl_complex_rect(0.0, 0.0);
+			gsl_complex zm = gsl_complex_rect(0.0, 0.0);
+			for (i = 0; i < d; i++) {
+				gsl_complex c = gsl_complex_mul( gsl_complex_rect(data_re[i][offset + j], data_im[i][offset + j]),
+						gsl_complex_mul( gsl_complex_rect(g_re[j], g_im[j]),
+								gsl_complex_rect(ramp_re[i*stride + j], ramp_im[i*stride + j]) ) );
+				zp = gsl_complex_add( zp, gsl_complex_mul_real(c, w_plus[i]) );
+				zm = gsl_complex_add( zm, gsl_complex_mul_real(c, w_minus[i]) );
+			}
+			EXPECT_NEAR( z_plus[2*j + 0], GSL_REAL(zp), 1e-12 );
+			EXPECT_NEAR( z_plus[2*j + 1], GSL_IMAG(zp), 1e-12 );
+			EXPECT_NEAR( z_minus[2*j + 0], GSL_REAL(zm), 1e-12 );
+			EXPECT_NEAR( z_minus[2*j + 1], GSL_IMAG(zm), 1e-12 );
+		}
+	}
+}
+
+TEST(coherent_network_statistic, CN_engine_names) {
+	EXPECT_EQ( CN_ENGINE_TWO_SIDED, CN_engine_name_to_id( CN_engine_id_to_name(CN_ENGINE_TWO_SIDED) ) );
+	EXPECT_EQ( CN_ENGINE_ONE_SIDED, CN_engine_name_to_id( CN_engine_id_to_name(CN_ENGINE_ONE_SIDED) ) );
+	EXPECT_EQ( CN_ENGINE_FUSED, CN_engine_name_to_id( CN_engine_id_to_name(CN_ENGINE_FUSED) ) );
+}
+
 #endif
 
@@ -0,0 +1,299 @@
+/*
+ * libpso_test.cpp
+ */
+
+#ifdef HAVE_CONFIG_H
+	#include "config.h"
+#endif
+
+#ifdef HAVE_GTEST
+	#include <gtest/gtest.h>
+#endif
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+
+#include <gsl/gsl_complex.h>
+#include <gsl/gsl_complex_math.h>
+
+#include "../libcore/detector.h"
+#include "../libcore/detector_network.h"
+#include "../libcore/spectral_density.h"
+#include "../libcore/strain.h"
+#include "../libpso/inspiral_pso_fitness.h"
+#include "../libpso/parallel.h"
+#include "../libpso/philox.h"
+#include "../libpso/pso.h"
+
+/* Known answers from the Random123 distribution (kat_vectors, philox4x32_10) */
+TEST(philox, knownAnswers) {
+	const uint32_t ctr[3][4] = {
+		{ 0x00000000, 0x00000000, 0x00000000, 0x00000000 },
+		{ 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff },
+		{ 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 } };
+	const uint32_t key[3][2] = {
+		{ 0x00000000, 0x00000000 },
+		{ 0xffffffff, 0xffffffff },
+		{ 0xa4093822, 0x299f31d0 } };
+	const uint32_t expected[3][4] = {
+		{ 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 },
+		{ 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd },
+		{ 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } };
+	size_t i, j;
+
+	for (i = 0; i < 3; i++) {
+		uint32_t out[4];
+		philox4x32(ctr[i], key[i], out);
+		for (j = 0; j < 4; j++) {
+			EXPECT_EQ(expected[i][j], out[j]);
+		}
+	}
+}
+
+TEST(philox, uniformInUnitInterval) {
+	size_t i;
+
+	for (i = 0; i < 1000; i++) {
+		double u[2];
+		philox_uniform2(1234, PHILOX_STREAM_WEIGHTS, i, i % 7, i % 5, u);
+		EXPECT_GE(u[0], 0.0);
+		EXPECT_LT(u[0], 1.0);
+		EXPECT_GE(u[1], 0.0);
+		EXPECT_LT(u[1], 1.0);
+	}
+}
+
+/* Synthetic data, the same as that of the coherent network tests (CN_test_data_alloc in libcore_test.cpp) */
+typedef struct pso_test_data_s {
+	network_strain_half_fft_t *network_strain;
+	detector_network_t *network;
+} pso_test_data_t;
+
+/* The first num_detectors of H1, L1, V1 and K1 with the one-sided PSD 1 + k at f = k, and half FFTs
+ * sin(0.37 k (i + 1)) + i cos(1.3 k + i) for strain i.
+ */
+static void pso_test_data_init(pso_test_data_t *data, size_t num_detectors, size_t num_time_samples) {
+	const DETECTOR_ID ids[4] = { H1, L1, V1, K1 };
+	size_t i, k, len;
+
+	data->network_strain = network_strain_half_fft_alloc(num_detectors, num_time_samples);
+	len = data->network_strain->strains[0]->half_fft_len;
+	for (i = 0; i < num_detectors; i++) {
+		for (k = 0; k < len; k++) {
+			data->network_strain->strains[i]->half_fft[k] = gsl_complex_rect(sin(0.37 * k * (i + 1)), cos(1.3 * k + i));
+		}
+	}
+
+	data->network = Detector_Network_alloc(num_detectors);
+	for (i = 0; i < num_detectors; i++) {
+		psd_t *psd = PSD_alloc(len);
+		psd->type = PSD_ONE_SIDED;
+		for (k = 0; k < len; k++) {
+			psd->f[k] = k;
+			psd->psd[k] = 1.0 + k;
+		}
+		Detector_init(ids[i], psd, data->network->detector[i]);
+	}
+}
+
+static void pso_test_data_free(pso_test_data_t *data) {
+	Detector_Network_free(data->network);
+	network_strain_half_fft_free(data->network_strain);
+}
+
+/* Writes a pso settings file for a short search with the counter-based generator, plus any extra settings */
+static void pso_test_settings_write(const char *version, const char *extra, char *settings_file) {
+	FILE *fid;
+	int fd;
+
+	strcpy(settings_file, "/tmp/libpso_test_XXXXXX");
+	fd = mkstemp(settings_file);
+	ASSERT_NE(-1, fd);
+	fid = fdopen(fd, "w");
+	ASSERT_TRUE(fid != NULL);
+	fprintf(fid, "popsize 12\nmaxSteps 10\nc1 2\nc2 2\nmax_velocity 0.2\n"
+			"dcLaw_a 0.9\ndcLaw_b 0.4\ndcLaw_d 0.2\nlocMinIter 0\nlocMinStpSz 0.01\n"
+			"pso_version %s\npso_rng philox\n"
+			"network_statistic_engine fused\nnetwork_statistic_precision double\n"
+			"template_cache_mb 0\ntemplate_cache_quantum 1e-6\n"
+			"sky_table_ra_points 0\nsky_table_dec_points 0\nthreads_per_evaluation 1\n%s", version, extra);
+	fclose(fid);
+}
+
+/* Runs a short PSO search of the synthetic data with the given version, seed and thread count */
+static void pso_test_run(const char *version, const char *extra, size_t num_threads, gslseed_t seed,
+		pso_result_t *result) {
+	pso_test_data_t data;
+	pso_fitness_function_parameters_t *params;
+	char settings_file[64];
+
+	pso_test_settings_write(version, extra, settings_file);
+	pso_test_data_init(&data, 3, 512);
+
+	/* The workspaces are allocated for the number of threads in force */
+	parallel_set_num_threads(num_threads);
+	params = pso_fitness_function_parameters_alloc(20.0, 200.0, data.network, data.network_strain);
+	pso_estimate_parameters(settings_file, params, seed, result);
+
+	pso_fitness_function_parameters_free(params);
+	pso_test_data_free(&data);
+	unlink(settings_file);
+}
+
+static void pso_expect_same_result(const pso_result_t *a, const pso_result_t *b) {
+	EXPECT_EQ(a->ra, b->ra);
+	EXPECT_EQ(a->dec, b->dec);
+	EXPECT_EQ(a->chirp_t0, b->chirp_t0);
+	EXPECT_EQ(a->chirp_t1_5, b->chirp_t1_5);
+	EXPECT_EQ(a->snr, b->snr);
+	EXPECT_EQ(a->total_iterations, b->total_iterations);
+	EXPECT_EQ(a->total_func_evals, b->total_func_evals);
+}
+
+TEST(pso, counterRngSameResultForAnyThreadCount_lbest) {
+	pso_result_t one, many;
+
+	pso_test_run("lbest", "", 1, 1234, &one);
+	pso_test_run("lbest", "", 3, 1234, &many);
+	pso_expect_same_result(&one, &many);
+}
+
+TEST(pso, counterRngSameResultForAnyThreadCount_gbest) {
+	pso_result_t one, many;
+
+	pso_test_run("gbest", "", 1, 1234, &one);
+	pso_test_run("gbest", "", 3, 1234, &many);
+	pso_expect_same_result(&one, &many);
+}
+
+/* Records the order in which the trials were reported */
+typedef struct pso_test_trials_s {
+	size_t num_reported;
+	size_t reported[4];
+	pso_result_t result[4];
+} pso_test_trials_t;
+
+static void pso_test_trials_callback(size_t trial, gslseed_t seed, pso_result_t *result, void *callback_data) {
+	pso_test_trials_t *trials = (pso_test_trials_t*) callback_data;
+	trials->reported[trials->num_reported] = trial;
+	trials->result[trial] = *result;
+	trials->num_reported++;
+}
+
+TEST(pso, concurrentTrialsMatchSingleRuns) {
+	const size_t num_trials = 4;
+	const gslseed_t seeds[4] = { 1234, 7, 2017, 99 };
+	pso_result_t results[4];
+	pso_test_trials_t trials;
+	pso_test_data_t data;
+	char settings_file[64];
+	size_t i;
+
+	pso_test_settings_write("lbest", "", settings_file);
+	pso_test_data_init(&data, 3, 512);
+
+	memset(&trials, 0, sizeof(trials));
+	parallel_set_num_threads(4);
+	pso_estimate_parameters_trials(settings_file, 20.0, 200.0, data.network, data.network_strain,
+			num_trials, seeds, 2, results, pso_test_trials_callback, &trials);
+
+	pso_test_data_free(&data);
+	unlink(settings_file);
+
+	/* Every trial is reported once */
+	ASSERT_EQ(num_trials, trials.num_reported);
+	for (i = 0; i < num_trials; i++) {
+		size_t j, count = 0;
+		for (j = 0; j < num_trials; j++) {
+			count += (trials.reported[j] == i);
+		}
+		EXPECT_EQ((size_t) 1, count);
+		pso_expect_same_result(&results[i], &trials.result[i]);
+	}
+
+	/* The same as running the trials one after the other */
+	for (i = 0; i < num_trials; i++) {
+		pso_result_t single;
+		pso_test_run("lbest", "", 2, seeds[i], &single);
+		pso_expect_same_result(&single, &results[i]);
+	}
+}
+
+TEST(pso, asyncRunsTheSynchronousBudget) {
+	const char *versions[2] = { "async_lbest", "async_gbest" };
+	/* More threads than the 12 particles leaves some of them without work */
+	const size_t threads[2] = { 2, 16 };
+	size_t i, j;
+
+	for (i = 0; i < 2; i++) {
+		for (j = 0; j < 2; j++) {
+			pso_result_t result;
+
+			pso_test_run(versions[i], "", threads[j], 1234, &result);
+			EXPECT_GE(result.ra, -M_PI);
+			EXPECT_LE(result.ra, M_PI);
+			EXPECT_GE(result.dec, -0.5 * M_PI);
+			EXPECT_LE(result.dec, 0.5 * M_PI);
+			EXPECT_TRUE(isfinite(result.snr));
+			EXPECT_GT(result.snr, 0.0);
+
+			/* (maxSteps - 1) * popsize evaluations are issued, less those of particles out of the search space */
+			EXPECT_EQ(PSO_STOP_MAX_STEPS, result.stop_reason);
+			EXPECT_EQ((size_t) 9, result.total_iterations);
+			EXPECT_LE(result.total_func_evals, (size_t) 9 * 12);
+			EXPECT_GE(result.total_func_evals, (size_t) 9 * 12 / 2);
+		}
+	}
+}
+
+TEST(pso, stopsAtMaxStepsByDefault) {
+	pso_result_t result;
+
+	pso_test_run("lbest", "", 1, 1234, &result);
+	EXPECT_EQ(PSO_STOP_MAX_STEPS, result.stop_reason);
+	EXPECT_EQ((size_t) 9, result.total_iterations);
+	EXPECT_GE(result.last_improvement_iteration, (size_t) 1);
+	EXPECT_LE(result.last_improvement_iteration, result.total_iterations);
+}
+
+TEST(pso, stopsWhenGbestStalls) {
+	const char *versions[2] = { "lbest", "gbest" };
+	size_t i;
+
+	for (i = 0; i < 2; i++) {
+		pso_result_t result;
+
+		pso_test_run(versions[i], "stallSteps 2\nstallTol 1e6\n", 1, 1234, &result);
+		EXPECT_EQ(PSO_STOP_STALL, result.stop_reason);
+		/* Only the first iteration improves on +infinity by more than stallTol */
+		EXPECT_EQ((size_t) 1, result.last_improvement_iteration);
+		EXPECT_EQ((size_t) 3, result.total_iterations);
+	}
+}
+
+TEST(pso, stopsWhenSwarmIsSmall) {
+	pso_result_t result;
+
+	/* Any swarm fits in a box larger than the search space */
+	pso_test_run("gbest", "minSwarmDiameter 2\n", 1, 1234, &result);
+	EXPECT_EQ(PSO_STOP_DIAMETER, result.stop_reason);
+	EXPECT_EQ((size_t) 1, result.total_iterations);
+}
+
+TEST(pso, stopsAtFuncEvalBudget) {
+	const char *versions[3] = { "lbest", "gbest", "async_lbest" };
+	size_t i;
+
+	for (i = 0; i < 3; i++) {
+		pso_result_t result;
+
+		pso_test_run(versions[i], "maxFuncEvals 30\n", 2, 1234, &result);
+		EXPECT_EQ(PSO_STOP_FUNC_EVALS, result.stop_reason);
+		EXPECT_GE(result.total_func_evals, (size_t) 30);
+		EXPECT_LT(result.total_iterations, (size_t) 9);
+	}
+}